@@ -0,0 +1,59 @@
+#include "CollectionFileHandle.h"
+#include "CollectionFile.h"
+#include "FileFactory.h"
+
+#include <QThreadPool>
+#include <QDebug>
+
+#include <stdexcept>
+
+CollectionFileHandle::CollectionFileHandle(const QString& collectionRoot, const QString& absPath,
+                                           const QString& id, const FileDetectResult& det,
+                                           qint64 size, const QDateTime& mtime)
+    : root_(collectionRoot), absPath_(absPath), id_(id), det_(det), size_(size), mtime_(mtime)
+{
+}
+
+std::shared_ptr<CollectionFile> CollectionFileHandle::get() {
+    std::lock_guard<std::mutex> lk(m_);
+    if (loaded_.load(std::memory_order_relaxed)) return obj_;
+
+    try {
+        obj_ = FileFactory::create(root_, absPath_, det_);
+        if (obj_) FileFactory::load(obj_, absPath_, det_.kind);
+    } catch (const std::exception& e) {
+        qWarning() << "Failed to load" << absPath_ << ":" << e.what();
+        obj_.reset();
+    }
+    loaded_.store(true, std::memory_order_release);
+    return obj_;
+}
+
+void CollectionFileHandle::prefetch(QThreadPool* pool) {
+    if (isLoaded() || queued_.exchange(true)) return;
+    if (!pool) pool = QThreadPool::globalInstance();
+
+    std::weak_ptr<CollectionFileHandle> weak = weak_from_this();
+    pool->start([weak]{
+        if (auto self = weak.lock()) {
+            self->get();
+            self->queued_ = false;
+        }
+    });
+}
+
+void CollectionFileHandle::unload() {
+    std::lock_guard<std::mutex> lk(m_);
+    obj_.reset();
+    loaded_.store(false, std::memory_order_release);
+}
+
+bool CollectionFileHandle::unloadIfUnused() {
+    std::unique_lock<std::mutex> lk(m_, std::try_to_lock);
+    if (!lk.owns_lock()) return false;
+    // A count of 1 cannot grow meanwhile: new copies only come from get(), under m_.
+    if (obj_ && obj_.use_count() > 1) return false;
+    obj_.reset();
+    loaded_.store(false, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <QDateTime>
+#include <QString>
+#include "FileTypeDetector.h"
+
+class CollectionFile;
+class QThreadPool;
+
+/**
+ * @brief Cheap stand-in for a CollectionFile whose load() has not run yet.
+ *
+ * Holds only what enumeration and detection already produced (ID, kind,
+ * size, mtime, detection reason). The concrete object is created and loaded
+ * on the first get(), or earlier on a worker thread through prefetch().
+ * All members are safe to call from any thread; concurrent callers of get()
+ * share one load.
+ */
+class CollectionFileHandle : public std::enable_shared_from_this<CollectionFileHandle> {
+public:
+    CollectionFileHandle(const QString& collectionRoot, const QString& absPath,
+                         const QString& id, const FileDetectResult& det,
+                         qint64 size, const QDateTime& mtime);
+
+    const QString& id() const { return id_; }
+    const QString& absolutePath() const { return absPath_; }
+    FileKind kind() const { return det_.kind; }
+    const QString& reason() const { return det_.reason; }
+    qint64 size() const { return size_; }
+    const QDateTime& lastModified() const { return mtime_; }
+
+    /// True once load() has finished (successfully or not).
+    bool isLoaded() const { return loaded_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief The loaded object; creates and loads it on first use (blocking).
+     * @return nullptr if the kind is unsupported or load threw.
+     */
+    std::shared_ptr<CollectionFile> get();
+
+    /// Queue get() on a pool so the load happens off the calling (UI) thread.
+    void prefetch(QThreadPool* pool = nullptr);
+
+    /// Drop the loaded object; the next get() loads again.
+    void unload();
+
+    /**
+     * @brief unload(), but only if nothing besides this handle holds the object.
+     *
+     * Never blocks: returns false while a load is running on another thread.
+     * Used by ResidencyManager, where unloading an object that is still
+     * referenced would free nothing.
+     * @return true if the object was dropped (or none was loaded).
+     */
+    bool unloadIfUnused();
+
+private:
+    QString root_;
+    QString absPath_;
+    QString id_;
+    FileDetectResult det_;
+    qint64 size_ = 0;
+    QDateTime mtime_;
+
+    std::mutex m_;
+    std::shared_ptr<CollectionFile> obj_;
+    std::atomic<bool> loaded_{false};
+    std::atomic<bool> queued_{false};
+};
@@ -0,0 +1,244 @@
+#include "CollectionLoader.h"
+#include "FileFactory.h"
+#include "CollectionFile.h"
+#include "DetectionCache.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QThread>
+#include <QDebug>
+
+#include <algorithm>
+#include <stdexcept>
+
+CollectionLoader::CollectionLoader()
+    : CollectionLoader(Options{})
+{
+}
+
+CollectionLoader::CollectionLoader(Options opt)
+    : opt_(std::move(opt))
+{
+}
+
+CollectionLoader::~CollectionLoader() {
+    cancel();
+    wait();
+}
+
+QStringList CollectionLoader::enumerate(const QString& collectionRoot, const QStringList& nameFilters) {
+    QStringList out;
+    QDirIterator it(QDir(collectionRoot).absolutePath(), nameFilters,
+                    QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) out << it.next();
+    return out;
+}
+
+void CollectionLoader::start(const QString& collectionRoot, ResultFn onResult, ProgressFn onProgress) {
+    if (running_) { cancel(); wait(); }
+    root_ = collectionRoot;
+    paths_.clear();
+    enumerateRoot_ = true;
+    launch(std::move(onResult), std::move(onProgress));
+}
+
+void CollectionLoader::start(const QString& collectionRoot, const QStringList& absPaths,
+                             ResultFn onResult, ProgressFn onProgress) {
+    if (running_) { cancel(); wait(); }
+    root_ = collectionRoot;
+    paths_ = absPaths;
+    enumerateRoot_ = false;
+    launch(std::move(onResult), std::move(onProgress));
+}
+
+void CollectionLoader::cancel() {
+    cancelled_ = true;
+    std::lock_guard<std::mutex> lk(idleMutex_);
+    idleCv_.notify_all();
+}
+
+void CollectionLoader::wait() {
+    for (auto& t : workers_) if (t.joinable()) t.join();
+    workers_.clear();
+    running_ = false;
+}
+
+void CollectionLoader::launch(ResultFn onResult, ProgressFn onProgress) {
+    onResult_ = std::move(onResult);
+    onProgress_ = std::move(onProgress);
+
+    const int n = opt_.threads > 0 ? opt_.threads : std::max(1, QThread::idealThreadCount());
+    queues_.clear();
+    for (int i = 0; i < n; ++i) queues_.push_back(std::make_unique<Queue>());
+    for (auto& g : gates_) { g.active = 0; g.parked.clear(); }
+
+    seeded_ = false;
+    cancelled_ = false;
+    queued_ = 0;
+    remaining_ = 0;
+    done_ = 0;
+    live_ = n;
+    running_ = true;
+
+    for (int i = 0; i < n; ++i) workers_.emplace_back([this, i]{ workerLoop(i); });
+}
+
+// Paths per detectMany() batch in seed(): large enough to keep the head
+// reads batched, small enough that cancel() is noticed promptly.
+static const int kDetectChunk = 256;
+
+// Runs on worker 0 before anything else: enumerate if asked to, then
+// detect the paths in batches of head reads (FileTypeDetector::detectMany,
+// or the cache's) and deal each file round-robin as soon as its kind is
+// known, so the other workers start loading while a batch is in flight.
+// cancel() is checked between batches.
+void CollectionLoader::seed() {
+    if (enumerateRoot_) paths_ = enumerate(root_, opt_.nameFilters);
+    remaining_ = int(paths_.size());
+    {
+        std::lock_guard<std::mutex> lk(idleMutex_);
+        seeded_ = true;
+        idleCv_.notify_all();
+    }
+
+    const int n = int(queues_.size());
+    int dealt = 0;
+    auto deal = [&](int index, const FileDetectResult& det) {
+        if (cancelled_) return;
+        Task t;
+        t.index = index;
+        t.det = det;
+        {
+            Queue& q = *queues_[size_t(dealt++ % n)];
+            std::lock_guard<std::mutex> lk(q.m);
+            q.tasks.push_back(t);
+            ++queued_;
+        }
+        std::lock_guard<std::mutex> lk(idleMutex_);
+        idleCv_.notify_one();
+    };
+    for (int base = 0; base < paths_.size() && !cancelled_; base += kDetectChunk) {
+        const QStringList chunk = paths_.mid(base, kDetectChunk);
+        auto dealChunk = [&](int index, const FileDetectResult& det) { deal(base + index, det); };
+        if (opt_.cache) opt_.cache->detectMany(chunk, dealChunk);
+        else FileTypeDetector::detectMany(chunk, dealChunk);
+    }
+}
+
+void CollectionLoader::workerLoop(int self) {
+    if (self == 0) {
+        seed();
+    } else {
+        std::unique_lock<std::mutex> lk(idleMutex_);
+        idleCv_.wait(lk, [this]{ return seeded_ || cancelled_.load(); });
+    }
+
+    for (;;) {
+        Task t;
+        if (!cancelled_ && nextTask(self, t)) {
+            process(self, t);
+            continue;
+        }
+        // Nothing queued right now; parked tasks come back when a load of
+        // their kind finishes, so sleep until a push, the end, or cancel.
+        std::unique_lock<std::mutex> lk(idleMutex_);
+        if (cancelled_ || remaining_ == 0) break;
+        if (queued_ > 0) continue;
+        idleCv_.wait(lk);
+    }
+
+    if (--live_ == 0) running_ = false;
+}
+
+bool CollectionLoader::nextTask(int self, Task& out) {
+    const int n = int(queues_.size());
+    {
+        Queue& own = *queues_[size_t(self)];
+        std::lock_guard<std::mutex> lk(own.m);
+        if (!own.tasks.empty()) {
+            out = own.tasks.front();
+            own.tasks.pop_front();
+            --queued_;
+            return true;
+        }
+    }
+    for (int k = 1; k < n; ++k) {
+        Queue& victim = *queues_[size_t((self + k) % n)];
+        std::lock_guard<std::mutex> lk(victim.m);
+        if (!victim.tasks.empty()) {
+            out = victim.tasks.back();
+            victim.tasks.pop_back();
+            --queued_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CollectionLoader::push(int self, Task t) {
+    {
+        Queue& own = *queues_[size_t(self)];
+        std::lock_guard<std::mutex> lk(own.m);
+        own.tasks.push_front(t);
+        ++queued_;
+    }
+    std::lock_guard<std::mutex> lk(idleMutex_);
+    idleCv_.notify_one();
+}
+
+bool CollectionLoader::admit(const Task& t) {
+    const int limit = opt_.perKindLimit.value(t.det.kind, 0);
+    if (limit <= 0) return true;
+
+    KindGate& g = gates_[size_t(t.det.kind)];
+    std::lock_guard<std::mutex> lk(g.m);
+    if (g.active < limit) { ++g.active; return true; }
+    g.parked.push_back(t);
+    return false;
+}
+
+void CollectionLoader::release(int self, FileKind kind) {
+    if (opt_.perKindLimit.value(kind, 0) <= 0) return;
+
+    KindGate& g = gates_[size_t(kind)];
+    Task next;
+    bool resume = false;
+    {
+        std::lock_guard<std::mutex> lk(g.m);
+        --g.active;
+        if (!g.parked.empty()) {
+            next = g.parked.front();
+            g.parked.pop_front();
+            resume = true;
+        }
+    }
+    // Back onto our own queue front so this worker picks it up next.
+    if (resume) push(self, next);
+}
+
+void CollectionLoader::process(int self, Task t) {
+    const QString& absPath = paths_[t.index];
+    if (!admit(t)) return;
+
+    std::shared_ptr<CollectionFile> obj;
+    try {
+        obj = FileFactory::create(root_, absPath, t.det);
+        if (obj) FileFactory::load(obj, absPath, t.det.kind);
+    } catch (const std::exception& e) {
+        qWarning() << "Failed to load" << absPath << ":" << e.what();
+        obj.reset();
+    }
+    release(self, t.det.kind);
+    finish(absPath, std::move(obj));
+}
+
+void CollectionLoader::finish(const QString& absPath, std::shared_ptr<CollectionFile> obj) {
+    const int done = ++done_;
+    if (onResult_) onResult_(absPath, std::move(obj));
+    if (onProgress_) onProgress_(done, int(paths_.size()));
+
+    if (--remaining_ == 0) {
+        std::lock_guard<std::mutex> lk(idleMutex_);
+        idleCv_.notify_all();
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include "FileTypeDetector.h"
+
+class CollectionFile;
+class DetectionCache;
+
+/**
+ * @brief Detects and loads many collection files on a bounded worker pool.
+ *
+ * Files are detected in batches of head reads (FileTypeDetector::detectMany)
+ * and handed out as their kinds become known. Each worker owns a deque of
+ * paths and steals from the back of the others when its own runs dry. Loads of one FileKind can be capped so a few heavy
+ * IRMovieFile loads cannot occupy every worker while cheap images wait:
+ * a file whose kind is at its limit is parked and picked up by the worker
+ * that next finishes a load of that kind.
+ *
+ * Callbacks run on worker threads, in completion order. Use
+ * QMetaObject::invokeMethod (queued) to hand results to the UI thread.
+ */
+class CollectionLoader {
+public:
+    struct Options {
+        int threads = 0;                    ///< 0: QThread::idealThreadCount()
+        QMap<FileKind, int> perKindLimit;   ///< FileKind -> max concurrent loads (absent/<=0: no cap)
+        QStringList nameFilters;            ///< when enumerating a root, e.g. {"*.csq","*.jpg"}; empty = all
+        DetectionCache* cache = nullptr;    ///< optional; skips sniffing for unchanged files (caller saves it)
+    };
+
+    /// Called once per path: obj is nullptr when the file was unsupported or failed to load.
+    using ResultFn   = std::function<void(const QString& absPath, std::shared_ptr<CollectionFile> obj)>;
+    /// Called after every finished path with the number done and the total queued.
+    using ProgressFn = std::function<void(int done, int total)>;
+
+    CollectionLoader();
+    explicit CollectionLoader(Options opt);
+    ~CollectionLoader(); ///< cancels and joins
+
+    CollectionLoader(const CollectionLoader&) = delete;
+    CollectionLoader& operator=(const CollectionLoader&) = delete;
+
+    /**
+     * @brief Load every file below collectionRoot (recursive).
+     *
+     * Enumeration happens on the first worker, so this returns immediately.
+     */
+    void start(const QString& collectionRoot, ResultFn onResult, ProgressFn onProgress = {});
+
+    /// Load an explicit list of absolute paths belonging to collectionRoot.
+    void start(const QString& collectionRoot, const QStringList& absPaths,
+               ResultFn onResult, ProgressFn onProgress = {});
+
+    /// Stop handing out new paths. Loads already running finish and are still
+    /// reported; paths not started yet are dropped without a callback, and
+    /// detection stops after the batch of head reads in flight.
+    void cancel();
+
+    /// Block until every worker has exited (all paths done, or cancelled).
+    void wait();
+
+    bool isRunning() const { return running_.load(); }
+
+    /// Recursive file listing used by start(root, ...).
+    static QStringList enumerate(const QString& collectionRoot, const QStringList& nameFilters = {});
+
+private:
+    struct Task {
+        int index = 0;          // into paths_
+        FileDetectResult det;
+    };
+
+    struct Queue {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    struct KindGate {
+        std::mutex m;
+        int active = 0;
+        std::deque<Task> parked;
+    };
+
+    void launch(ResultFn onResult, ProgressFn onProgress);
+    void seed();
+    void workerLoop(int self);
+    bool nextTask(int self, Task& out);
+    void push(int self, Task t);
+    bool admit(const Task& t);    // false: parked behind the kind limit
+    void release(int self, FileKind kind);
+    void process(int self, Task t);
+    void finish(const QString& absPath, std::shared_ptr<CollectionFile> obj);
+
+    Options opt_;
+    QString root_;
+    QStringList paths_;
+    bool enumerateRoot_ = false;
+
+    ResultFn onResult_;
+    ProgressFn onProgress_;
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::array<KindGate, size_t(FileKind::Unknown) + 1> gates_;
+    std::vector<std::thread> workers_;
+
+    std::mutex idleMutex_;
+    std::condition_variable idleCv_;
+    bool seeded_ = false;
+
+    std::atomic<int> queued_{0};      // tasks sitting in queues_
+    std::atomic<int> remaining_{0};   // paths not yet reported (queued, parked or running)
+    std::atomic<int> done_{0};
+    std::atomic<int> live_{0};
+    std::atomic<bool> cancelled_{false};
+    std::atomic<bool> running_{false};
+};
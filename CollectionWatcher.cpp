@@ -0,0 +1,385 @@
+#include "CollectionWatcher.h"
+#include "CollectionFileHandle.h"
+#include "CollectionLoader.h"
+#include "DetectionCache.h"
+#include "FileFactory.h"
+#include "HotPathStats.h"
+#include "ResidencyManager.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QDebug>
+
+#include <algorithm>
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define FILEMAKE_HAVE_INOTIFY 1
+#endif
+
+static const hps::StageId kStageFlush    = hps::stage("watch.flush");
+static const hps::StageId kStageEvents   = hps::stage("watch.events");
+static const hps::StageId kStageRedetect = hps::stage("watch.redetect");
+static const hps::StageId kStageOverflow = hps::stage("watch.overflow");
+
+#ifdef FILEMAKE_HAVE_INOTIFY
+// Directory watches only; files are covered through their parent.
+static const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                   IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+CollectionWatcher::CollectionWatcher()
+    : CollectionWatcher(Options{})
+{
+}
+
+CollectionWatcher::CollectionWatcher(Options opt)
+    : opt_(std::move(opt))
+{
+}
+
+CollectionWatcher::~CollectionWatcher() {
+    stop();
+}
+
+void CollectionWatcher::start(const QString& collectionRoot, DiffFn onDiff) {
+    if (running_) stop();
+    root_ = QDir(collectionRoot).absolutePath();
+    onDiff_ = std::move(onDiff);
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        snapshot_.clear();
+    }
+    dirtyFiles_.clear();
+    dirtyDirs_.clear();
+    published_ = false;
+    stopping_ = false;
+    rescanRequested_ = false;
+    polling_ = !openNotify();
+    running_ = true;
+    thread_ = std::thread([this]{ run(); });
+}
+
+void CollectionWatcher::stop() {
+    if (!thread_.joinable()) return;
+    stopping_ = true;
+    wake();
+    thread_.join();
+    closeNotify();
+    running_ = false;
+}
+
+void CollectionWatcher::rescan() {
+    rescanRequested_ = true;
+    wake();
+}
+
+QHash<QString, CollectionWatcher::Entry> CollectionWatcher::snapshot() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return snapshot_;
+}
+
+bool CollectionWatcher::openNotify() {
+#ifdef FILEMAKE_HAVE_INOTIFY
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    notifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd_ < 0) qWarning() << "inotify unavailable, polling" << root_ << ":" << qt_error_string(errno);
+    return notifyFd_ >= 0;
+#else
+    return false;
+#endif
+}
+
+void CollectionWatcher::closeNotify() {
+#ifdef FILEMAKE_HAVE_INOTIFY
+    if (notifyFd_ >= 0) ::close(notifyFd_);
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+#endif
+    notifyFd_ = wakeFd_ = -1;
+    wdDirs_.clear();
+    dirWds_.clear();
+}
+
+void CollectionWatcher::wake() {
+#ifdef FILEMAKE_HAVE_INOTIFY
+    const uint64_t one = 1;
+    if (wakeFd_ >= 0) (void)!::write(wakeFd_, &one, sizeof one);
+#endif
+}
+
+void CollectionWatcher::waitForEvents(int timeoutMs) {
+#ifdef FILEMAKE_HAVE_INOTIFY
+    pollfd fds[2] = { { notifyFd_, POLLIN, 0 }, { wakeFd_, POLLIN, 0 } };  // negative fds are skipped
+    if (::poll(fds, 2, timeoutMs) <= 0) return;
+    if (fds[1].revents & POLLIN) {
+        uint64_t n;
+        (void)!::read(wakeFd_, &n, sizeof n);
+    }
+    if (fds[0].revents & POLLIN) readEvents();
+#else
+    // No wake-up descriptor: sleep in slices so stop()/rescan() stay responsive.
+    const auto until = Clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? opt_.pollIntervalMs : timeoutMs);
+    while (!stopping_ && !rescanRequested_ && Clock::now() < until)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+#endif
+}
+
+void CollectionWatcher::readEvents() {
+#ifdef FILEMAKE_HAVE_INOTIFY
+    alignas(inotify_event) char buf[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::read(notifyFd_, buf, sizeof buf);
+        if (n <= 0) return;  // EAGAIN: drained
+        for (const char* p = buf; p < buf + n;) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + ev->len;
+            hps::count(kStageEvents);
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                hps::count(kStageOverflow);
+                if (!fullScanPending_) qWarning() << "inotify queue overflow, rescanning" << root_;
+                markFullScan();
+                continue;
+            }
+            auto it = wdDirs_.find(ev->wd);
+            if (it == wdDirs_.end()) continue;
+            if (ev->mask & IN_IGNORED) {  // watch gone (directory deleted or unwatched)
+                dirWds_.remove(*it);
+                wdDirs_.erase(it);
+                continue;
+            }
+            // Subdirectories are handled through the event on their parent.
+            if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                if (*it == root_) markFullScan();
+                continue;
+            }
+            if (!ev->len) continue;
+            const QString name = QFile::decodeName(ev->name);
+            if (name.startsWith(QLatin1Char('.'))) continue;  // hidden, as in CollectionLoader::enumerate
+            markDirty(*it + QLatin1Char('/') + name, ev->mask & IN_ISDIR);
+        }
+    }
+#endif
+}
+
+bool CollectionWatcher::hasPending() const {
+    return fullScanPending_ || !dirtyFiles_.isEmpty() || !dirtyDirs_.isEmpty();
+}
+
+void CollectionWatcher::markDirty(const QString& absPath, bool isDir) {
+    if (!isDir && !accepts(absPath.mid(absPath.lastIndexOf(QLatin1Char('/')) + 1))) return;
+    const Clock::time_point now = Clock::now();
+    if (!hasPending()) firstEvent_ = now;
+    lastEvent_ = now;
+    (isDir ? dirtyDirs_ : dirtyFiles_).insert(absPath);
+}
+
+void CollectionWatcher::markFullScan() {
+    const Clock::time_point now = Clock::now();
+    if (!hasPending()) firstEvent_ = now;
+    lastEvent_ = now;
+    fullScanPending_ = true;
+}
+
+bool CollectionWatcher::accepts(const QString& fileName) const {
+    return opt_.nameFilters.isEmpty() || QDir::match(opt_.nameFilters, fileName);
+}
+
+void CollectionWatcher::watchTree(const QString& dir) {
+#ifdef FILEMAKE_HAVE_INOTIFY
+    if (notifyFd_ < 0) return;
+    QStringList dirs{dir};
+    QDirIterator it(dir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) dirs << it.next();
+
+    for (const QString& d : dirs) {
+        const int wd = ::inotify_add_watch(notifyFd_, QFile::encodeName(d).constData(), kWatchMask);
+        if (wd < 0) {
+            if (errno == ENOSPC && !polling_) {
+                qWarning() << "inotify watch limit reached (fs.inotify.max_user_watches), polling" << root_;
+                polling_ = true;
+            } else if (errno != ENOENT && errno != ENOSPC) {
+                qWarning() << "Cannot watch" << d << ":" << qt_error_string(errno);
+            }
+            continue;
+        }
+        // The same inode returns its existing wd, e.g. a directory moved within the tree.
+        auto old = wdDirs_.constFind(wd);
+        if (old != wdDirs_.constEnd()) dirWds_.remove(*old);
+        wdDirs_.insert(wd, d);
+        dirWds_.insert(d, wd);
+    }
+#else
+    Q_UNUSED(dir);
+#endif
+}
+
+void CollectionWatcher::unwatchTree(const QString& dir) {
+#ifdef FILEMAKE_HAVE_INOTIFY
+    const QString prefix = dir + QLatin1Char('/');
+    for (auto it = dirWds_.begin(); it != dirWds_.end();) {
+        if (it.key() == dir || it.key().startsWith(prefix)) {
+            ::inotify_rm_watch(notifyFd_, *it);
+            wdDirs_.remove(*it);
+            it = dirWds_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+#else
+    Q_UNUSED(dir);
+#endif
+}
+
+void CollectionWatcher::run() {
+    auto msUntil = [](Clock::time_point t) {
+        return int(std::max<qint64>(0, std::chrono::duration_cast<std::chrono::milliseconds>(t - Clock::now()).count()));
+    };
+    const auto settle = std::chrono::milliseconds(opt_.settleMs);
+    const auto maxDelay = std::chrono::milliseconds(opt_.maxDelayMs);
+    const auto pollInterval = std::chrono::milliseconds(opt_.pollIntervalMs);
+
+    // Watch before the initial scan so nothing created in between is missed.
+    watchTree(root_);
+    fullScanPending_ = true;
+    flush();
+
+    while (!stopping_) {
+        int timeout = -1;
+        if (hasPending()) timeout = msUntil(std::min(lastEvent_ + settle, firstEvent_ + maxDelay));
+        if (polling_) {
+            const int p = msUntil(lastFullScan_ + pollInterval);
+            timeout = timeout < 0 ? p : std::min(timeout, p);
+        }
+        waitForEvents(timeout);
+        if (stopping_) break;
+
+        const Clock::time_point now = Clock::now();
+        if (rescanRequested_.exchange(false) || (polling_ && now >= lastFullScan_ + pollInterval)) {
+            fullScanPending_ = true;
+            flush();
+        } else if (hasPending() && (now >= lastEvent_ + settle || now >= firstEvent_ + maxDelay)) {
+            flush();
+        }
+    }
+}
+
+void CollectionWatcher::flush() {
+    hps::Scope s(kStageFlush);
+    Diff diff;
+    QSet<QString> paths;
+
+    if (fullScanPending_) {
+        // Events may have been lost: rebuild the watches, then stat everything.
+        diff.fullScan = true;
+        lastFullScan_ = Clock::now();
+        unwatchTree(root_);
+        polling_ = notifyFd_ < 0;
+        watchTree(root_);
+        for (const QString& p : CollectionLoader::enumerate(root_, opt_.nameFilters)) paths.insert(p);
+        std::lock_guard<std::mutex> lk(m_);
+        for (auto it = snapshot_.constBegin(); it != snapshot_.constEnd(); ++it) paths.insert(it.key());
+    } else {
+        // Removals first: a directory moved within the tree keeps its wd.
+        for (const QString& d : dirtyDirs_) unwatchTree(d);
+        for (const QString& d : dirtyDirs_) {
+            if (!QFileInfo(d).isDir()) continue;
+            watchTree(d);
+            for (const QString& p : CollectionLoader::enumerate(d, opt_.nameFilters)) paths.insert(p);
+        }
+        // Files of a moved or deleted directory only show up as a directory event.
+        if (!dirtyDirs_.isEmpty()) {
+            std::lock_guard<std::mutex> lk(m_);
+            for (auto it = snapshot_.constBegin(); it != snapshot_.constEnd(); ++it)
+                for (const QString& d : dirtyDirs_)
+                    if (it.key().startsWith(d + QLatin1Char('/'))) { paths.insert(it.key()); break; }
+        }
+        paths.unite(dirtyFiles_);
+    }
+    fullScanPending_ = false;
+    dirtyFiles_.clear();
+    dirtyDirs_.clear();
+
+    QStringList changed;
+    QVector<Entry> stats;
+    for (const QString& p : paths) {
+        Entry e;
+        if (apply(p, diff, e)) { changed << p; stats << e; }
+    }
+    auto onDetected = [&](int i, const FileDetectResult& det) { applyDetected(changed[i], det, stats[i], diff); };
+    if (opt_.cache) opt_.cache->detectMany(changed, onDetected);
+    else FileTypeDetector::detectMany(changed, onDetected);
+
+    if (!published_ || !diff.isEmpty()) {
+        published_ = true;
+        if (onDiff_) onDiff_(diff);
+    }
+}
+
+// Removals and unchanged files are settled here; for a new or changed file
+// stat gets its size and mtime and the caller detects it.
+bool CollectionWatcher::apply(const QString& absPath, Diff& diff, Entry& stat) {
+    const QFileInfo fi(absPath);
+    Entry prev;
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = snapshot_.constFind(absPath);
+        if (it != snapshot_.constEnd()) { prev = *it; known = true; }
+    }
+
+    if (!fi.isFile()) {
+        if (!known) return false;
+        if (prev.kind != FileKind::Unknown) diff.removed << absPath;
+        std::lock_guard<std::mutex> lk(m_);
+        snapshot_.remove(absPath);
+        return false;
+    }
+
+    stat.size = fi.size();
+    stat.mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    return !(known && prev.size == stat.size && prev.mtimeMs == stat.mtimeMs);  // else touched nothing we track
+}
+
+void CollectionWatcher::applyDetected(const QString& absPath, const FileDetectResult& det, Entry e, Diff& diff) {
+    Entry prev;
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = snapshot_.constFind(absPath);
+        if (it != snapshot_.constEnd()) { prev = *it; known = true; }
+    }
+
+    hps::count(kStageRedetect);
+    std::shared_ptr<CollectionFileHandle> h = FileFactory::createDeferred(root_, absPath, det);
+    if (h) {
+        e.size = h->size();
+        e.mtimeMs = h->lastModified().toMSecsSinceEpoch();
+        e.kind = h->kind();
+        (known && prev.kind != FileKind::Unknown ? diff.modified : diff.added) << h;
+        if (!diff.fullScan) prefetch(h);
+    } else if (known && prev.kind != FileKind::Unknown) {
+        diff.removed << absPath;  // no longer a supported file
+    }
+
+    std::lock_guard<std::mutex> lk(m_);
+    snapshot_.insert(absPath, e);
+}
+
+void CollectionWatcher::prefetch(const std::shared_ptr<CollectionFileHandle>& h) {
+    // Only through the residency manager: a load it does not see is never charged or evicted.
+    if (!opt_.prefetch || !opt_.residency) return;
+    QThreadPool* pool = opt_.pool ? opt_.pool : QThreadPool::globalInstance();
+    ResidencyManager* residency = opt_.residency;
+    std::weak_ptr<CollectionFileHandle> weak = h;
+    pool->start([weak, residency]{
+        if (auto self = weak.lock()) residency->acquire(self);
+    });
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "FileTypeDetector.h"
+
+class CollectionFileHandle;
+class DetectionCache;
+class QThreadPool;
+class ResidencyManager;
+
+/**
+ * @brief Keeps a collection in sync with its folder by reacting to changes only.
+ *
+ * Holds a snapshot of every file below the root (path -> size, mtime, kind)
+ * and subscribes to inotify on each directory of the tree. Events are only
+ * marked dirty; once the tree has been quiet for settleMs (or maxDelayMs
+ * after the first event of a burst, so a running acquisition still gets
+ * through), the dirty paths are stat'ed and only those whose size or mtime
+ * differs from the snapshot are detected again, in one FileTypeDetector::detectMany
+ * batch (through the DetectionCache when set), and get a new handle. The
+ * resulting Diff goes to the consumer, so a refresh costs work proportional
+ * to what changed, not to the collection size.
+ *
+ * Handles are created unloaded, as by FileFactory::createDeferred, so the
+ * initial scan costs enumeration and detection only.
+ *
+ * A rename is reported as removed + added. When the kernel queue overflows
+ * (IN_Q_OVERFLOW) events were lost, so the tree is watched again and
+ * stat'ed in full (still without re-detecting unchanged files); the same
+ * happens on platforms without inotify or when the watch limit is reached,
+ * every pollIntervalMs instead.
+ *
+ * Like CollectionLoader, callbacks run on the watcher thread.
+ */
+class CollectionWatcher {
+public:
+    struct Options {
+        int settleMs = 300;             ///< quiet time that ends a burst of events
+        int maxDelayMs = 2000;          ///< upper bound on how long a burst is held back
+        int pollIntervalMs = 5000;      ///< full rescans when inotify is unavailable
+        QStringList nameFilters;        ///< as CollectionLoader::Options::nameFilters; empty = all
+        DetectionCache* cache = nullptr;///< optional; used for (re-)detection
+        /// Load files added or modified after the initial scan in the background,
+        /// through `residency` so they count against its budget. Needs `residency`;
+        /// full scans (startup, overflow) never prefetch.
+        bool prefetch = false;
+        ResidencyManager* residency = nullptr;
+        QThreadPool* pool = nullptr;    ///< for prefetch; nullptr = global pool
+    };
+
+    struct Entry {
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        FileKind kind = FileKind::Unknown;  ///< Unknown files are tracked but never reported
+    };
+
+    struct Diff {
+        QVector<std::shared_ptr<CollectionFileHandle>> added;     ///< new files (or newly supported)
+        QVector<std::shared_ptr<CollectionFileHandle>> modified;  ///< replace the handle with the same path
+        QStringList removed;                                      ///< absolute paths
+        bool fullScan = false;  ///< initial scan or overflow recovery
+        bool isEmpty() const { return added.isEmpty() && modified.isEmpty() && removed.isEmpty(); }
+    };
+
+    using DiffFn = std::function<void(const Diff& diff)>;
+
+    CollectionWatcher();
+    explicit CollectionWatcher(Options opt);
+    ~CollectionWatcher(); ///< stop()
+
+    CollectionWatcher(const CollectionWatcher&) = delete;
+    CollectionWatcher& operator=(const CollectionWatcher&) = delete;
+
+    /**
+     * @brief Watch collectionRoot and report changes to onDiff.
+     *
+     * The first Diff (fullScan set) lists every supported file as added;
+     * later ones carry only changes. Returns immediately.
+     */
+    void start(const QString& collectionRoot, DiffFn onDiff);
+
+    /// Stop watching and join the thread. The snapshot is kept.
+    void stop();
+
+    /// Ask for a full rescan on the watcher thread (e.g. after a remount).
+    void rescan();
+
+    bool isRunning() const { return running_.load(); }
+
+    /// Copy of the current snapshot, keyed by absolute path.
+    QHash<QString, Entry> snapshot() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+    bool openNotify();
+    void closeNotify();
+    void waitForEvents(int timeoutMs);
+    void readEvents();
+    void wake();
+    bool hasPending() const;
+    void markDirty(const QString& absPath, bool isDir);
+    void markFullScan();
+    void watchTree(const QString& dir);
+    void unwatchTree(const QString& dir);
+    bool accepts(const QString& fileName) const;
+    void flush();
+    bool apply(const QString& absPath, Diff& diff, Entry& stat);   // true: (re-)detect it
+    void applyDetected(const QString& absPath, const FileDetectResult& det, Entry stat, Diff& diff);
+    void prefetch(const std::shared_ptr<CollectionFileHandle>& h);
+
+    Options opt_;
+    QString root_;
+    DiffFn onDiff_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> rescanRequested_{false};
+    int wakeFd_ = -1;                  // written by stop()/rescan()
+
+    // Watcher thread only.
+    int notifyFd_ = -1;
+    bool polling_ = false;             // no (complete) inotify coverage: rescan periodically
+    QHash<int, QString> wdDirs_;
+    QHash<QString, int> dirWds_;
+    QSet<QString> dirtyFiles_;
+    QSet<QString> dirtyDirs_;
+    bool fullScanPending_ = false;
+    bool published_ = false;           // the initial Diff went out
+    Clock::time_point firstEvent_;
+    Clock::time_point lastEvent_;
+    Clock::time_point lastFullScan_;
+
+    mutable std::mutex m_;             // guards snapshot_ against snapshot()
+    QHash<QString, Entry> snapshot_;
+};
@@ -0,0 +1,266 @@
+#include "DetectionCache.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static const char kMagic[4] = { 'F', 'M', 'D', 'C' };
+static const quint32 kVersion = 1;
+static const int kHeaderSize = 12;
+static const int kIndexEntry = 16;
+
+// Stable across runs (qHash is seeded per process).
+static quint64 pathHash(const QByteArray& utf8) {
+    quint64 h = 0xcbf29ce484222325ULL;
+    for (char c : utf8) { h ^= uchar(c); h *= 0x100000001b3ULL; }
+    return h;
+}
+
+namespace {
+// Bounds-checked reads from the mapped file; a short or corrupt file just
+// turns into a miss.
+struct Reader {
+    const uchar* data;
+    qint64 size;
+    qint64 pos;
+    bool ok = true;
+
+    template <class T> T get() {
+        T v{};
+        if (!ok || pos < 0 || size - pos < qint64(sizeof(T))) { ok = false; return v; }
+        std::memcpy(&v, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+    QByteArray str() {
+        const quint32 n = get<quint32>();
+        if (!ok || size - pos < qint64(n)) { ok = false; return {}; }
+        QByteArray s(reinterpret_cast<const char*>(data + pos), int(n));
+        pos += n;
+        return s;
+    }
+};
+
+template <class T> void putRaw(QByteArray& out, T v) { out.append(reinterpret_cast<const char*>(&v), sizeof(T)); }
+void putStr(QByteArray& out, const QByteArray& s) { putRaw(out, quint32(s.size())); out.append(s); }
+}
+
+struct DetectionCache::Mapping {
+    QFile file;
+    const uchar* data = nullptr;
+    qint64 size = 0;
+    quint32 count = 0;
+
+    explicit Mapping(const QString& path) : file(path) {}
+    ~Mapping() { if (data) file.unmap(const_cast<uchar*>(data)); }
+
+    /// nullptr if path is missing or not a cache of this version.
+    static std::shared_ptr<const Mapping> open(const QString& path);
+    quint64 offsetAt(quint32 i) const;
+    bool lookup(const QByteArray& path, const Stamp& st, FileDetectResult& out) const;
+};
+
+std::shared_ptr<const DetectionCache::Mapping> DetectionCache::Mapping::open(const QString& path) {
+    auto m = std::make_shared<Mapping>(path);
+    if (!m->file.exists() || !m->file.open(QIODevice::ReadOnly)) return nullptr;
+    m->size = m->file.size();
+    if (m->size < kHeaderSize) return nullptr;
+    m->data = m->file.map(0, m->size);
+    if (!m->data) return nullptr;
+
+    Reader r{m->data, m->size, 0};
+    if (std::memcmp(m->data, kMagic, 4) != 0) return nullptr;
+    r.pos = 4;
+    const quint32 version = r.get<quint32>();
+    const quint32 count = r.get<quint32>();
+    if (!r.ok || version != kVersion || (m->size - kHeaderSize) / kIndexEntry < qint64(count)) return nullptr;
+    m->count = count;
+    return m;
+}
+
+quint64 DetectionCache::Mapping::offsetAt(quint32 i) const {
+    quint64 v;
+    std::memcpy(&v, data + kHeaderSize + qint64(i) * kIndexEntry + 8, 8);
+    return v;
+}
+
+DetectionCache::DetectionCache(const QString& cacheFile)
+    : path_(cacheFile), map_(Mapping::open(cacheFile))
+{
+}
+
+DetectionCache::~DetectionCache() = default;
+
+QString DetectionCache::defaultPathFor(const QString& collectionRoot) {
+    return QDir(collectionRoot).filePath(".filemake-detect.cache");
+}
+
+bool DetectionCache::Mapping::lookup(const QByteArray& path, const Stamp& st, FileDetectResult& out) const {
+    if (!count) return false;
+    const quint64 h = pathHash(path);
+    auto hashAt = [&](quint32 i){ quint64 v; std::memcpy(&v, data + kHeaderSize + qint64(i) * kIndexEntry, 8); return v; };
+
+    quint32 lo = 0, hi = count;
+    while (lo < hi) {
+        const quint32 mid = lo + (hi - lo) / 2;
+        if (hashAt(mid) < h) lo = mid + 1; else hi = mid;
+    }
+    for (; lo < count && hashAt(lo) == h; ++lo) {
+        Reader r{data, size, qint64(offsetAt(lo))};
+        if (r.str() != path || !r.ok) continue;
+        const qint64 size = r.get<qint64>();
+        const qint64 mtime = r.get<qint64>();
+        const quint8 kind = r.get<quint8>();
+        const QByteArray reason = r.str();
+        if (!r.ok || kind > quint8(FileKind::Unknown)) return false;
+        if (size != st.size || mtime != st.mtimeMs) return false;
+        out = { FileKind(kind), QString::fromUtf8(reason) };
+        return true;
+    }
+    return false;
+}
+
+std::shared_ptr<const DetectionCache::Mapping> DetectionCache::mapping() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return map_;
+}
+
+bool DetectionCache::lookup(const QFileInfo& fi, FileDetectResult& out) const {
+    const QString path = fi.absoluteFilePath();
+    const Stamp st{ fi.size(), fi.lastModified().toMSecsSinceEpoch() };
+    std::shared_ptr<const Mapping> map;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        seen_.insert(path);
+        auto it = overlay_.constFind(path);
+        if (it != overlay_.constEnd()) {
+            if (it->first.size != st.size || it->first.mtimeMs != st.mtimeMs) return false;
+            out = it->second;
+            return true;
+        }
+        map = map_;
+    }
+    return map && map->lookup(path.toUtf8(), st, out);
+}
+
+void DetectionCache::insert(const QFileInfo& fi, const FileDetectResult& r) {
+    const Stamp st{ fi.size(), fi.lastModified().toMSecsSinceEpoch() };
+    std::lock_guard<std::mutex> lk(m_);
+    overlay_.insert(fi.absoluteFilePath(), qMakePair(st, r));
+}
+
+FileDetectResult DetectionCache::detect(const QFileInfo& fi) {
+    FileDetectResult r;
+    if (lookup(fi, r)) return r;
+    r = FileTypeDetector::detect(fi.absoluteFilePath());
+    insert(fi, r);
+    return r;
+}
+
+void DetectionCache::detectMany(const QStringList& absPaths,
+                                const std::function<void(int, const FileDetectResult&)>& onResult) {
+    QStringList missPaths;
+    QVector<int> missIndex;
+    QVector<QFileInfo> missInfo;
+    for (int i = 0; i < absPaths.size(); ++i) {
+        const QFileInfo fi(absPaths[i]);
+        FileDetectResult r;
+        if (lookup(fi, r)) { onResult(i, r); continue; }
+        missPaths << absPaths[i];
+        missIndex << i;
+        missInfo << fi;
+    }
+    // Stamped with the stat taken before the read: a file that changes
+    // meanwhile is detected again next time.
+    FileTypeDetector::detectMany(missPaths, [&](int j, const FileDetectResult& r) {
+        insert(missInfo[j], r);
+        onResult(missIndex[j], r);
+    });
+}
+
+bool DetectionCache::isDirty() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return !overlay_.isEmpty();
+}
+
+bool DetectionCache::save() {
+    std::lock_guard<std::mutex> saving(saveM_);
+    struct Entry { quint64 hash; QByteArray path; Stamp st; quint8 kind; QByteArray reason; };
+    std::vector<Entry> entries;
+    QSet<QByteArray> fresh;
+    QHash<QString, Stamp> written;
+    QSet<QString> seen;
+    std::shared_ptr<const Mapping> old;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        for (auto it = overlay_.constBegin(); it != overlay_.constEnd(); ++it) {
+            const QByteArray p = it.key().toUtf8();
+            entries.push_back({ pathHash(p), p, it->first, quint8(it->second.kind), it->second.reason.toUtf8() });
+            fresh.insert(p);
+            written.insert(it.key(), it->first);
+        }
+        old = map_;
+        seen = seen_;
+    }
+    for (quint32 i = 0; old && i < old->count; ++i) {
+        Reader r{old->data, old->size, qint64(old->offsetAt(i))};
+        Entry e;
+        e.path = r.str();
+        e.st.size = r.get<qint64>();
+        e.st.mtimeMs = r.get<qint64>();
+        e.kind = r.get<quint8>();
+        e.reason = r.str();
+        if (!r.ok || fresh.contains(e.path) || !seen.contains(QString::fromUtf8(e.path))) continue;
+        e.hash = pathHash(e.path);
+        entries.push_back(std::move(e));
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){ return a.hash < b.hash; });
+
+    QByteArray out(kMagic, 4);
+    putRaw(out, kVersion);
+    putRaw(out, quint32(entries.size()));
+    QByteArray records;
+    const qint64 recordsAt = kHeaderSize + qint64(entries.size()) * kIndexEntry;
+    for (const Entry& e : entries) {
+        putRaw(out, e.hash);
+        putRaw(out, quint64(recordsAt + records.size()));
+        putStr(records, e.path);
+        putRaw(records, e.st.size);
+        putRaw(records, e.st.mtimeMs);
+        putRaw(records, e.kind);
+        putStr(records, e.reason);
+    }
+    out.append(records);
+    old.reset();
+
+#ifdef Q_OS_WIN
+    // Windows cannot replace a file that is still mapped; lookups miss the
+    // saved entries until the new mapping is in place.
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        map_.reset();
+    }
+#endif
+    QSaveFile sf(path_);
+    const bool ok = sf.open(QIODevice::WriteOnly) && sf.write(out) == out.size() && sf.commit();
+    if (!ok) qWarning() << "Cannot write detection cache" << path_ << ":" << sf.errorString();
+    std::shared_ptr<const Mapping> next = Mapping::open(path_);
+
+    std::lock_guard<std::mutex> lk(m_);
+    map_ = std::move(next);
+    if (!ok) return false;
+    // Keep what was inserted while writing.
+    for (auto it = written.constBegin(); it != written.constEnd(); ++it) {
+        auto o = overlay_.find(it.key());
+        if (o != overlay_.end() && o->first.size == it->size && o->first.mtimeMs == it->mtimeMs) overlay_.erase(o);
+    }
+    return true;
+}
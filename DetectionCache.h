@@ -0,0 +1,84 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include "FileTypeDetector.h"
+
+class QFileInfo;
+
+/**
+ * @brief On-disk cache of FileDetectResult keyed by path, size and mtime.
+ *
+ * One cache file per collection root. It is memory-mapped when opened and
+ * never written in place, so lookups from any number of threads read it
+ * without locking; new results collect in a small overlay until save()
+ * writes a merged file atomically (QSaveFile) and swaps in its mapping.
+ * Lookups hold a reference to the mapping they started on, so an old one
+ * is unmapped only after the last of them returns. Reopening an unchanged
+ * collection costs one stat per file and no content reads.
+ *
+ * A cache file describes one scan of its root: save() writes back only the
+ * files looked up or inserted since the cache was opened, so entries for
+ * files deleted or renamed since the previous scan are dropped.
+ *
+ * Layout: "FMDC" u32 version u32 count, count x {u64 pathHash, u64 offset}
+ * sorted by hash, then records {str path, i64 size, i64 mtimeMs, u8 kind,
+ * str reason} with str = u32 length + UTF-8 bytes.
+ */
+class DetectionCache {
+public:
+    explicit DetectionCache(const QString& cacheFile);
+    ~DetectionCache();
+
+    DetectionCache(const DetectionCache&) = delete;
+    DetectionCache& operator=(const DetectionCache&) = delete;
+
+    /// Conventional cache location for a collection root.
+    static QString defaultPathFor(const QString& collectionRoot);
+
+    /// Cached result if size and mtime in fi still match.
+    bool lookup(const QFileInfo& fi, FileDetectResult& out) const;
+    void insert(const QFileInfo& fi, const FileDetectResult& r);
+
+    /// lookup(), else FileTypeDetector::detect() and insert().
+    FileDetectResult detect(const QFileInfo& fi);
+
+    /**
+     * @brief detect() for many files: hits are reported first, the misses go
+     * through one FileTypeDetector::detectMany() batch.
+     *
+     * onResult receives the index into absPaths, never concurrently.
+     */
+    void detectMany(const QStringList& absPaths,
+                    const std::function<void(int index, const FileDetectResult&)>& onResult);
+
+    bool isDirty() const;
+
+    /**
+     * @brief Merge new results into the cache file and remap it.
+     *
+     * Mapped entries for files not looked up since the cache was opened
+     * are dropped. Safe while other threads call lookup()/detect()/insert();
+     * results inserted during the write stay in the overlay for the next save().
+     * Concurrent save() calls are serialized.
+     * @return false (with a warning logged) if the file could not be written.
+     */
+    bool save();
+
+private:
+    struct Stamp { qint64 size = 0; qint64 mtimeMs = 0; };
+    struct Mapping;  // one mapped cache file; immutable once opened
+
+    std::shared_ptr<const Mapping> mapping() const;
+
+    QString path_;
+    std::mutex saveM_;
+
+    mutable std::mutex m_;            // guards map_, overlay_ and seen_
+    std::shared_ptr<const Mapping> map_;
+    QHash<QString, QPair<Stamp, FileDetectResult>> overlay_;
+    mutable QSet<QString> seen_;      // paths looked up since opening
+};
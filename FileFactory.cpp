@@ -1,6 +1,9 @@
 #include "FileFactory.h"
 
 #include "CollectionFile.h"
+#include "CollectionFileHandle.h"
+#include "DetectionCache.h"
+#include "HotPathStats.h"
 #include "ImageFile.h"
 #include "irImageFile.h"
 #include "irMovieFile.h"
@@ -13,6 +16,18 @@
 #include <QDir>
 #include <QDebug>
 
+static const hps::StageId kStageDetect = hps::stage("factory.detect");
+// Indexed by FileKind.
+static const hps::StageId kStageLoad[] = {
+    hps::stage("factory.load.IRMovie"),
+    hps::stage("factory.load.IRImage"),
+    hps::stage("factory.load.Movie"),
+    hps::stage("factory.load.Image"),
+    hps::stage("factory.load.IRSensorLog"),
+    hps::stage("factory.load.Weather"),
+    hps::stage("factory.load.Unknown")
+};
+
 static QString makeId(const QString& collectionRoot, const QString& absPath) {
     // Use a stable, unique, UI-friendly ID: relative path from the collection root
     QDir root(collectionRoot);
@@ -20,48 +35,68 @@ static QString makeId(const QString& collectionRoot, const QString& absPath) {
     return rel.isEmpty() ? QFileInfo(absPath).fileName() : rel;
 }
 
-std::shared_ptr<CollectionFile> FileFactory::createAndLoad(const QString& collectionRoot,
-                                                           const QString& absPath)
+std::shared_ptr<CollectionFile> FileFactory::create(const QString& collectionRoot,
+                                                    const QString& absPath,
+                                                    const FileDetectResult& det)
 {
-    const auto det = FileTypeDetector::detect(absPath);
     const QString id = makeId(collectionRoot, absPath);
 
-    std::shared_ptr<CollectionFile> obj;
-
     switch (det.kind) {
-        case FileKind::IRMovie: {
-            obj = std::make_shared<IRMovieFile>(id);
-            break;
-        }
-        case FileKind::IRImage: {
-            obj = std::make_shared<IRImageFile>(id);
-            break;
-        }
-        case FileKind::Movie: {
-            obj = std::make_shared<MovieFile>(id);
-            break;
-        }
-        case FileKind::Image: {
-            obj = std::make_shared<ImageFile>(id);
-            break;
-        }
-        case FileKind::IRSensorLog: {
-            obj = std::make_shared<IRSensorLogFile>(id);
-            break;
-        }
-        case FileKind::Weather: {
-            obj = std::make_shared<WeatherFile>(id);
-            break;
-        }
+        case FileKind::IRMovie:     return std::make_shared<IRMovieFile>(id);
+        case FileKind::IRImage:     return std::make_shared<IRImageFile>(id);
+        case FileKind::Movie:       return std::make_shared<MovieFile>(id);
+        case FileKind::Image:       return std::make_shared<ImageFile>(id);
+        case FileKind::IRSensorLog: return std::make_shared<IRSensorLogFile>(id);
+        case FileKind::Weather:     return std::make_shared<WeatherFile>(id);
         case FileKind::Unknown:
         default:
             qDebug() << "Skipping unsupported file:" << absPath << "(" << det.reason << ")";
             return nullptr;
     }
+}
 
+std::shared_ptr<CollectionFile> FileFactory::createAndLoad(const QString& collectionRoot,
+                                                           const QString& absPath)
+{
+    FileDetectResult det;
+    { hps::Scope s(kStageDetect); det = FileTypeDetector::detect(absPath); }
+    std::shared_ptr<CollectionFile> obj = create(collectionRoot, absPath, det);
     if (!obj) return nullptr;
 
-    // Defer heavy load? For now, load immediately:
-    obj->load(absPath);
+    // Loads immediately; use createDeferred() to postpone the heavy part, or
+    // CollectionLoader to run it on a pool for whole collections.
+    load(obj, absPath, det.kind);
     return obj;
 }
+
+void FileFactory::load(const std::shared_ptr<CollectionFile>& obj, const QString& absPath, FileKind kind)
+{
+    hps::Scope s(kStageLoad[int(kind)]);
+    obj->load(absPath);
+}
+
+std::shared_ptr<CollectionFileHandle> FileFactory::createDeferred(const QString& collectionRoot,
+                                                                  const QString& absPath,
+                                                                  DetectionCache* cache)
+{
+    FileDetectResult det;
+    {
+        hps::Scope s(kStageDetect);
+        det = cache ? cache->detect(QFileInfo(absPath)) : FileTypeDetector::detect(absPath);
+    }
+    return createDeferred(collectionRoot, absPath, det);
+}
+
+std::shared_ptr<CollectionFileHandle> FileFactory::createDeferred(const QString& collectionRoot,
+                                                                  const QString& absPath,
+                                                                  const FileDetectResult& det)
+{
+    if (det.kind == FileKind::Unknown) {
+        qDebug() << "Skipping unsupported file:" << absPath << "(" << det.reason << ")";
+        return nullptr;
+    }
+
+    const QFileInfo fi(absPath);
+    return std::make_shared<CollectionFileHandle>(collectionRoot, absPath, makeId(collectionRoot, absPath),
+                                                  det, fi.size(), fi.lastModified());
+}
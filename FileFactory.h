@@ -4,9 +4,29 @@
 #include "FileTypeDetector.h"
 
 class CollectionFile;
+class CollectionFileHandle;
+class DetectionCache;
 
 class FileFactory {
 public:
+    /**
+     * @brief Instantiate the CollectionFile subclass for an already detected file.
+     *
+     * Does not call load(); the object only carries its ID.
+     * @return shared_ptr to an unloaded CollectionFile, or nullptr for FileKind::Unknown.
+     */
+    static std::shared_ptr<CollectionFile> create(const QString& collectionRoot,
+                                                  const QString& absPath,
+                                                  const FileDetectResult& det);
+
+    /**
+     * @brief obj->load(absPath), timed per kind ("factory.load.<Kind>" in HotPathStats).
+     *
+     * Every loading path (createAndLoad, CollectionLoader, CollectionFileHandle)
+     * goes through here. Exceptions from load() propagate.
+     */
+    static void load(const std::shared_ptr<CollectionFile>& obj, const QString& absPath, FileKind kind);
+
     /**
      * @brief Create a concrete CollectionFile subclass for a path.
      * @param collectionRoot Root folder of the collection (for relative ID)
@@ -15,4 +35,22 @@ public:
      */
     static std::shared_ptr<CollectionFile> createAndLoad(const QString& collectionRoot,
                                                          const QString& absPath);
+
+    /**
+     * @brief Deferred variant of createAndLoad: detect and stat only.
+     *
+     * The returned handle creates and loads the CollectionFile on first
+     * access (CollectionFileHandle::get) or when prefetched. With a cache,
+     * an unchanged file is classified without opening it. Acquire through
+     * a ResidencyManager to keep the loaded payload within a memory budget.
+     * @return handle, or nullptr for unsupported files.
+     */
+    static std::shared_ptr<CollectionFileHandle> createDeferred(const QString& collectionRoot,
+                                                                const QString& absPath,
+                                                                DetectionCache* cache = nullptr);
+
+    /// createDeferred() for an already detected file (e.g. from detectMany); stats only.
+    static std::shared_ptr<CollectionFileHandle> createDeferred(const QString& collectionRoot,
+                                                                const QString& absPath,
+                                                                const FileDetectResult& det);
 };
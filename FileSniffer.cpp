@@ -0,0 +1,287 @@
+#include "FileSniffer.h"
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+// Opt-in, like csvdt: -DFILEMAKE_WITH_ZLIB ... -lz, -DFILEMAKE_WITH_ZSTD ... -lzstd.
+#if defined(FILEMAKE_WITH_ZLIB)
+#  include <zlib.h>
+#  define FILEMAKE_HAVE_ZLIB 1
+#endif
+#if defined(FILEMAKE_WITH_ZSTD)
+#  include <zstd.h>
+#  define FILEMAKE_HAVE_ZSTD 1
+#endif
+
+QByteArray FileSniffer::readHead(const QString& absPath, int maxBytes, bool* ok) {
+    if (ok) *ok = false;
+    QFile f(absPath);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) return {};
+    QByteArray buf(maxBytes, Qt::Uninitialized);
+    const qint64 got = f.read(buf.data(), maxBytes);
+    if (got < 0) return {};
+    if (ok) *ok = true;
+    if (got == 0) return {};
+    buf.truncate(int(got));
+    return buf;
+}
+
+namespace {
+
+struct Head {
+    const uchar* p;
+    int n;
+
+    bool has(int at, int len) const { return at >= 0 && len >= 0 && at <= n - len; }
+    bool is(int at, const char* sig, int len) const { return has(at, len) && std::memcmp(p + at, sig, size_t(len)) == 0; }
+    int be16(int at) const { return (p[at] << 8) | p[at + 1]; }
+};
+
+// ISO-BMFF major brands of still images and of video; anything else
+// (M4A/M4B audio, Canon "crx" raw, ...) is left to the extension.
+bool isImageBrand(const QByteArray& b) {
+    return b == "heic" || b == "heix" || b == "mif1" || b == "msf1" || b == "avif";
+}
+bool isVideoBrand(const QByteArray& b) {
+    static const char* const kBrands[] = { "isom", "iso2", "iso4", "iso5", "iso6", "mp41", "mp42",
+                                           "avc1", "qt  ", "M4V ", "M4VH", "M4VP", "3gp4", "3gp5",
+                                           "3gp6", "3g2a", "dash", "MSNV", "f4v ", "XAVC" };
+    for (const char* k : kBrands)
+        if (b == k) return true;
+    return false;
+}
+
+bool containsAscii(const uchar* p, int n, const char* needle) {
+    const int len = int(std::strlen(needle));
+    for (int i = 0; i + len <= n; ++i)
+        if (std::memcmp(p + i, needle, size_t(len)) == 0) return true;
+    return false;
+}
+
+// Walk JPEG marker segments up to the first scan. FLIR cameras store the
+// radiometric FFF data in APP1 segments tagged "FLIR\0" and write "FLIR"
+// into the Exif Make; an image that reaches its scan data without either is
+// a plain JPEG.
+bool sniffJpeg(const Head& h, FileDetectResult& out) {
+    bool exifFlir = false;
+    int pos = 2;
+    while (h.has(pos, 2)) {
+        if (h.p[pos] != 0xFF) return false;
+        const uchar marker = h.p[pos + 1];
+        if (marker == 0xFF) { ++pos; continue; }
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) { pos += 2; continue; }
+        if (marker == 0xDA || marker == 0xD9) {
+            out = exifFlir ? FileDetectResult{ FileKind::IRImage, "JPEG Exif make FLIR" }
+                           : FileDetectResult{ FileKind::Image, "JPEG without FLIR segments" };
+            return true;
+        }
+        if (!h.has(pos + 2, 2)) break;
+        const int len = h.be16(pos + 2);
+        if (len < 2) return false;
+        const int seg = pos + 4;
+        const int avail = std::min(len - 2, h.n - seg);
+        if (marker == 0xE1) {
+            if (h.is(seg, "FLIR\0", 5)) { out = { FileKind::IRImage, "JPEG APP1 FLIR segment" }; return true; }
+            if (h.is(seg, "Exif\0\0", 6) && containsAscii(h.p + seg, avail, "FLIR")) exifFlir = true;
+        }
+        pos += 2 + len;
+    }
+    // Segments run past the head (large Exif thumbnails are common).
+    if (exifFlir) { out = { FileKind::IRImage, "JPEG Exif make FLIR" }; return true; }
+    return false;
+}
+
+// IFD0 of a TIFF: a FLIR Make, or single-channel samples of 16+ bits
+// (raw counts / float temperatures), mark a radiometric image.
+bool sniffTiff(const Head& h, FileDetectResult& out) {
+    const bool le = h.p[0] == 'I';
+    auto u16 = [&](int at){ return le ? (h.p[at] | (h.p[at + 1] << 8)) : h.be16(at); };
+    auto u32 = [&](int at){
+        return le ? quint32(h.p[at]) | quint32(h.p[at + 1]) << 8 | quint32(h.p[at + 2]) << 16 | quint32(h.p[at + 3]) << 24
+                  : quint32(h.p[at]) << 24 | quint32(h.p[at + 1]) << 16 | quint32(h.p[at + 2]) << 8 | quint32(h.p[at + 3]);
+    };
+
+    if (!h.has(4, 4)) return false;
+    const quint32 ifd = u32(4);
+    if (ifd > quint32(h.n) || !h.has(int(ifd), 2)) return false;
+    const int count = u16(int(ifd));
+    int bits = 1, samples = 1;
+    bool flirMake = false;
+    for (int i = 0; i < count; ++i) {
+        const int e = int(ifd) + 2 + 12 * i;
+        if (!h.has(e, 12)) return false;
+        const int tag = u16(e);
+        const quint32 n = u32(e + 4);
+        if (tag == 0x010F) {            // Make (ASCII)
+            const quint32 at = n <= 4 ? quint32(e + 8) : u32(e + 8);
+            if (at < quint32(h.n))
+                flirMake = containsAscii(h.p + at, int(std::min<quint32>(n, quint32(h.n) - at)), "FLIR");
+        } else if (tag == 0x0102) {     // BitsPerSample (SHORT); first channel
+            const quint32 at = n <= 2 ? quint32(e + 8) : u32(e + 8);
+            if (at > quint32(h.n) || !h.has(int(at), 2)) return false;
+            bits = u16(int(at));
+        } else if (tag == 0x0115) {     // SamplesPerPixel
+            samples = u16(e + 8);
+        }
+    }
+
+    if (flirMake) out = { FileKind::IRImage, "TIFF make FLIR" };
+    else if (samples == 1 && bits >= 16) out = { FileKind::IRImage, "single-channel 16/32-bit TIFF" };
+    else out = { FileKind::Image, "TIFF without radiometric hints" };
+    return true;
+}
+
+/**
+ * @brief Header verdicts by header line.
+ *
+ * Sibling logs (daily rollovers of one rig) repeat the same header thousands
+ * of times, so the string work in headerVerdict() runs once per distinct
+ * header. Unknown kind = inconclusive, keep the extension verdict.
+ */
+struct HeaderMemo {
+    static constexpr int kMaxEntries = 4096;
+    std::mutex m;
+    QHash<QByteArray, FileDetectResult> verdicts;
+};
+
+HeaderMemo& headerMemo() {
+    static HeaderMemo memo;
+    return memo;
+}
+
+FileDetectResult headerVerdict(const QString& firstLine) {
+    // Primitive heuristics:
+    if (firstLine.contains("temperature") && firstLine.contains("humidity")) {
+        return { FileKind::Weather, "csv header suggests weather" };
+    }
+    if (firstLine.contains("sensor") || firstLine.contains("emissivity")) {
+        return { FileKind::IRSensorLog, "csv header suggests IR sensor log" };
+    }
+
+    // Otherwise count columns that look like either kind.
+    static const char* const kSensor[]  = { "object", "target", "reflected", "atmospheric", "transmission",
+                                            "radiometric", "spot", "roi", "distance" };
+    static const char* const kWeather[] = { "humid", "wind", "pressure", "baro", "dew", "rain", "precip",
+                                            "solar", "irradiance", "cloud" };
+    int sensor = 0, weather = 0;
+    static const QRegularExpression kSep("[,;\\t|]");
+    for (const QString& col : firstLine.split(kSep)) {
+        bool hit = false;
+        for (const char* k : kSensor) if (col.contains(QLatin1String(k))) { ++sensor; hit = true; break; }
+        if (hit) continue;
+        for (const char* k : kWeather) if (col.contains(QLatin1String(k))) { ++weather; break; }
+    }
+    if (weather > sensor) return { FileKind::Weather, "csv header columns suggest weather" };
+    if (sensor > weather) return { FileKind::IRSensorLog, "csv header columns suggest IR sensor log" };
+    return { FileKind::Unknown, QString() };
+}
+
+FileDetectResult sniffCsvHeader(const Head& h, const FileDetectResult& byExt) {
+    int start = h.is(0, "\xEF\xBB\xBF", 3) ? 3 : 0;
+    int end = start;
+    while (end < h.n && h.p[end] != '\n' && h.p[end] != '\r') ++end;
+    const QByteArray line = QByteArray::fromRawData(reinterpret_cast<const char*>(h.p + start), end - start);
+
+    HeaderMemo& memo = headerMemo();
+    FileDetectResult r;
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lk(memo.m);
+        auto it = memo.verdicts.constFind(line);
+        if (it != memo.verdicts.constEnd()) { r = *it; known = true; }
+    }
+    if (!known) {
+        r = headerVerdict(QString::fromUtf8(line).toLower());
+        std::lock_guard<std::mutex> lk(memo.m);
+        if (memo.verdicts.size() >= HeaderMemo::kMaxEntries) memo.verdicts.clear();
+        memo.verdicts.insert(QByteArray(line.constData(), line.size()), r);
+    }
+    return r.kind == FileKind::Unknown ? byExt : r;
+}
+
+// Decompress the start of a gzip/zstd stream from its (truncated) head bytes,
+// at most FileSniffer::kHeadBytes of output. Returns false when the stream is
+// not compressed, the decoder is not built in, or nothing could be decoded.
+bool decodeHead(const Head& h, QByteArray& out, QString& codec) {
+    out.resize(FileSniffer::kHeadBytes);
+    int got = 0;
+    if (h.is(0, "\x1F\x8B", 2)) {
+        codec = "gzip";
+#ifdef FILEMAKE_HAVE_ZLIB
+        z_stream z{};
+        if (inflateInit2(&z, 15 + 32) != Z_OK) return false;
+        z.next_in = const_cast<Bytef*>(h.p);
+        z.avail_in = uInt(h.n);
+        z.next_out = reinterpret_cast<Bytef*>(out.data());
+        z.avail_out = uInt(out.size());
+        const int rc = inflate(&z, Z_SYNC_FLUSH);
+        got = out.size() - int(z.avail_out);
+        inflateEnd(&z);
+        if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) return false;
+#endif
+    } else if (h.is(0, "\x28\xB5\x2F\xFD", 4)) {
+        codec = "zstd";
+#ifdef FILEMAKE_HAVE_ZSTD
+        ZSTD_DStream* zs = ZSTD_createDStream();
+        if (!zs) return false;
+        ZSTD_inBuffer in{ h.p, size_t(h.n), 0 };
+        ZSTD_outBuffer ob{ out.data(), size_t(out.size()), 0 };
+        while (ob.pos < ob.size && in.pos < in.size) {
+            const size_t before = in.pos + ob.pos;
+            if (ZSTD_isError(ZSTD_decompressStream(zs, &ob, &in)) || in.pos + ob.pos == before) break;
+        }
+        ZSTD_freeDStream(zs);
+        got = int(ob.pos);
+#endif
+    } else {
+        return false;
+    }
+    out.truncate(got);
+    return got > 0;
+}
+
+} // namespace
+
+FileDetectResult FileSniffer::classify(const char* data, int size, const FileDetectResult& byExt) {
+    const Head h{ reinterpret_cast<const uchar*>(data), size };
+    if (size <= 0 || byExt.kind == FileKind::Unknown) return byExt;
+
+    // Compressed logs (.csv.gz, .csv.zst): classify what the stream starts with.
+    QByteArray plain;
+    QString codec;
+    if (decodeHead(h, plain, codec)) {
+        FileDetectResult r = classify(plain.constData(), plain.size(), byExt);
+        if (r.reason != byExt.reason) r.reason += " (" + codec + ")";
+        return r;
+    }
+
+    // FLIR FFF container: CSQ/SEQ movies are sequences of FFF records, .fff a single frame.
+    if (h.is(0, "FFF\0", 4)) {
+        if (byExt.kind == FileKind::IRMovie) return { FileKind::IRMovie, "FLIR FFF container" };
+        return { FileKind::IRImage, "FLIR FFF image" };
+    }
+
+    FileDetectResult r;
+    if (h.is(0, "\xFF\xD8\xFF", 3) && sniffJpeg(h, r)) return r;
+    if ((h.is(0, "II*\0", 4) || h.is(0, "MM\0*", 4)) && sniffTiff(h, r)) return r;
+    if (h.is(0, "\x89PNG", 4)) return { FileKind::Image, "PNG signature" };
+
+    if (h.is(4, "ftyp", 4) && h.has(8, 4)) {
+        const QByteArray brand(data + 8, 4);
+        if (isImageBrand(brand)) return { FileKind::Image, "ftyp " + QString::fromLatin1(brand) };
+        if (isVideoBrand(brand)) return { FileKind::Movie, "ftyp " + QString::fromLatin1(brand).trimmed() };
+        return byExt;
+    }
+    if (h.is(0, "RIFF", 4) && h.is(8, "AVI ", 4)) return { FileKind::Movie, "RIFF AVI" };
+    if (h.is(0, "\x1A\x45\xDF\xA3", 4)) return { FileKind::Movie, "EBML (Matroska/WebM)" };
+
+    if (byExt.kind == FileKind::Weather || byExt.kind == FileKind::IRSensorLog)
+        return sniffCsvHeader(h, byExt);
+
+    return byExt;
+}
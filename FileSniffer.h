@@ -0,0 +1,33 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include "FileTypeDetector.h"
+
+/**
+ * @brief Content checks on a file's first few KB.
+ *
+ * Confirms or corrects the extension verdict from one bounded read:
+ * FLIR FFF containers (CSQ/SEQ/FFF), JPEG with a FLIR APP1 segment,
+ * TIFF radiometric hints, MP4/MOV (ftyp), AVI (RIFF) and Matroska (EBML),
+ * and weather vs. IR sensor CSV headers. Anything the head cannot decide
+ * keeps the extension verdict. A gzip or zstd head is decompressed in
+ * memory (builds with FILEMAKE_WITH_ZLIB / FILEMAKE_WITH_ZSTD) and the decoded
+ * start is classified instead. CSV header verdicts are memoized per
+ * header line, since sibling logs repeat the same header.
+ */
+class FileSniffer {
+public:
+    static constexpr int kHeadBytes = 4096;
+
+    /// One read of at most maxBytes from the start of the file (empty on error,
+    /// and for an empty file; *ok, when given, tells the two apart).
+    static QByteArray readHead(const QString& absPath, int maxBytes = kHeadBytes, bool* ok = nullptr);
+
+    /**
+     * @brief Classify from head bytes.
+     * @param byExt Result of extension mapping; returned unchanged when the
+     *              content is inconclusive. Content only refines a supported
+     *              extension: an Unknown byExt is returned as is.
+     */
+    static FileDetectResult classify(const char* data, int size, const FileDetectResult& byExt);
+};
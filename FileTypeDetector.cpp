@@ -1,11 +1,18 @@
 #include "FileTypeDetector.h"
-#include <QFileInfo>
-#include <QFile>
-#include <QTextStream>
-#include <QRegularExpression>
+#include "FileSniffer.h"
+#include "HeadReader.h"
+#include "HotPathStats.h"
 #include <QMap>
+#include <QVector>
 
-static QMap<FileKind, QStringList> g_exts = {
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static const QMap<FileKind, QStringList> kDefaultExts = {
     { FileKind::IRMovie,     {"csq","seq"} },  // add more as you learn
     { FileKind::IRImage,     {"jpg","jpeg","tif","tiff"} }, // radiometric JPEG/TIFF: you may refine with sniff
     { FileKind::Movie,       {"mp4","mov","avi","mkv"} },
@@ -14,62 +21,190 @@ static QMap<FileKind, QStringList> g_exts = {
     { FileKind::Weather,     {"csv","json"} }
 };
 
-void FileTypeDetector::registerExtensions(FileKind kind, const QStringList& extsLowerNoDot) {
-    g_exts[kind] = extsLowerNoDot;
-}
+// Order in which kinds claim a shared extension (first match wins).
+static const FileKind kExtPriority[] = {
+    FileKind::IRMovie, FileKind::IRImage, FileKind::Movie,
+    FileKind::Image, FileKind::Weather, FileKind::IRSensorLog
+};
+static const int kKindCount = int(sizeof(kExtPriority) / sizeof(kExtPriority[0]));
+static const int kMaxExtLen = 15;
 
-static bool extIs(const QString& extLower, const QStringList& allowed) {
-    return allowed.contains(extLower);
-}
+/**
+ * @brief Immutable open-addressing table: lowercase suffix -> candidate kinds.
+ *
+ * Candidates are stored in kExtPriority order; kinds[0] is what extension
+ * mapping alone picks.
+ */
+struct ExtTable {
+    struct Slot {
+        char ext[kMaxExtLen + 1] = {};
+        quint8 len = 0;          // 0 = empty slot
+        quint8 count = 0;
+        FileKind kinds[kKindCount] = {};
+    };
+    std::vector<Slot> slots;     // power-of-two size
+    quint32 mask = 0;
 
-static FileDetectResult detectByExt(const QString& absPath) {
-    QFileInfo fi(absPath);
-    const QString ext = fi.suffix().toLower();
+    static quint32 hash(const char* s, int n) {
+        quint32 h = 2166136261u;
+        for (int i = 0; i < n; ++i) { h ^= uchar(s[i]); h *= 16777619u; }
+        return h;
+    }
 
-    if (extIs(ext, g_exts[FileKind::IRMovie]))  return { FileKind::IRMovie, "by extension" };
+    const Slot* find(const char* s, int n) const {
+        for (quint32 i = hash(s, n) & mask;; i = (i + 1) & mask) {
+            const Slot& sl = slots[i];
+            if (sl.len == 0) return nullptr;
+            if (sl.len == n && std::memcmp(sl.ext, s, size_t(n)) == 0) return &sl;
+        }
+    }
 
-    // Distinguish radiometric TIFF/JPEG vs non-radiometric:
-    if (extIs(ext, g_exts[FileKind::IRImage]))  return { FileKind::IRImage, "by extension (raster radiometric candidate)" };
+    static ExtTable* build(const QMap<FileKind, QStringList>& exts) {
+        auto* t = new ExtTable;
+        int entries = 0;
+        for (const QStringList& l : exts) entries += l.size();
+        quint32 cap = 8;
+        while (cap < quint32(entries) * 2) cap <<= 1;
+        t->slots.resize(cap);
+        t->mask = cap - 1;
 
-    if (extIs(ext, g_exts[FileKind::Movie]))    return { FileKind::Movie, "by extension" };
-    if (extIs(ext, g_exts[FileKind::Image]))    return { FileKind::Image, "by extension" };
-    if (extIs(ext, g_exts[FileKind::Weather]))  return { FileKind::Weather, "by extension" };
-    if (extIs(ext, g_exts[FileKind::IRSensorLog])) return { FileKind::IRSensorLog, "by extension" };
+        for (FileKind kind : kExtPriority) {
+            for (const QString& e : exts.value(kind)) {
+                const QByteArray key = e.toLower().toLatin1();
+                if (key.isEmpty() || key.size() > kMaxExtLen) continue;
+                quint32 i = hash(key.constData(), key.size()) & t->mask;
+                while (t->slots[i].len && !(t->slots[i].len == key.size() &&
+                       std::memcmp(t->slots[i].ext, key.constData(), size_t(key.size())) == 0))
+                    i = (i + 1) & t->mask;
+                Slot& sl = t->slots[i];
+                if (!sl.len) { std::memcpy(sl.ext, key.constData(), size_t(key.size())); sl.len = quint8(key.size()); }
+                if (std::find(sl.kinds, sl.kinds + sl.count, kind) == sl.kinds + sl.count) sl.kinds[sl.count++] = kind;
+            }
+        }
+        return t;
+    }
+};
 
-    return { FileKind::Unknown, "unknown extension" };
-}
+/**
+ * @brief Current extension table plus the writer-side state behind it.
+ *
+ * Readers only do an acquire load of `current`. registerExtensions() builds a
+ * new table under `writeMutex` and publishes it with a release store. Old
+ * tables stay alive in `snapshots` (registrations are rare and tiny), so a
+ * reader still holding one can never see it freed.
+ */
+struct ExtRegistry {
+    std::mutex writeMutex;
+    QMap<FileKind, QStringList> exts = kDefaultExts;
+    std::vector<std::unique_ptr<const ExtTable>> snapshots;
+    std::atomic<const ExtTable*> current{nullptr};
 
-static FileDetectResult optionalSniff(const QString& absPath, FileDetectResult current) {
-    // Optional: upgrade/refine IRImage vs Image based on radiometric tags.
-    // For CSV: decide between Weather vs IRSensorLog based on header columns.
+    ExtRegistry() { publish(); }
 
-    if (current.kind == FileKind::IRImage) {
-        // TODO: open with your FLIR SDK to confirm radiometric tags,
-        // or inspect EXIF/XMP if available; if not radiometric, demote to Image.
-        // For now, return as-is.
-        return current;
+    void publish() {
+        snapshots.emplace_back(ExtTable::build(exts));
+        current.store(snapshots.back().get(), std::memory_order_release);
     }
+};
 
-    if (current.kind == FileKind::Weather || current.kind == FileKind::IRSensorLog) {
-        QFile f(absPath);
-        if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream ts(&f);
-            const QString firstLine = ts.readLine().toLower();
-            // Primitive heuristics:
-            if (firstLine.contains("temperature") && firstLine.contains("humidity")) {
-                return { FileKind::Weather, "csv header suggests weather" };
-            }
-            if (firstLine.contains("sensor") || firstLine.contains("emissivity")) {
-                return { FileKind::IRSensorLog, "csv header suggests IR sensor log" };
-            }
-        }
+static ExtRegistry& registry() {
+    static ExtRegistry r;
+    return r;
+}
+
+void FileTypeDetector::registerExtensions(FileKind kind, const QStringList& extsLowerNoDot) {
+    ExtRegistry& r = registry();
+    std::lock_guard<std::mutex> lk(r.writeMutex);
+    r.exts[kind] = extsLowerNoDot;
+    r.publish();
+}
+
+/**
+ * @brief Lowercased suffix of the file name (text after its last '.') into buf.
+ * @param end Only the first `end` characters of absPath are considered
+ *        (-1 = all), so the inner suffix of "x.csv.gz" is found with the
+ *        position of the last dot.
+ * @return length, or -1 when there is none or it cannot be in the table
+ *         (too long or non-ASCII). Does not allocate.
+ */
+static int suffixLower(const QString& absPath, char (&buf)[kMaxExtLen + 1], int end = -1) {
+    const QChar* p = absPath.constData();
+    if (end < 0) end = absPath.size();
+    int dot = -1;
+    for (int i = end - 1; i >= 0; --i) {
+        const ushort c = p[i].unicode();
+        if (c == '/' || c == '\\') break;
+        if (c == '.') { dot = i; break; }
     }
+    if (dot < 0) return -1;
+    const int n = end - dot - 1;
+    if (n == 0 || n > kMaxExtLen) return -1;
+    for (int i = 0; i < n; ++i) {
+        const ushort c = p[dot + 1 + i].unicode();
+        if (c >= 0x80) return -1;
+        buf[i] = char(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+    }
+    return n;
+}
+
+static FileDetectResult detectByExt(const QString& absPath) {
+    char ext[kMaxExtLen + 1];
+    int n = suffixLower(absPath, ext);
+
+    // Compound suffix of a compressed file (log.csv.gz, log.csv.zst): map the inner one.
+    const char* codec = nullptr;
+    if (n == 2 && std::memcmp(ext, "gz", 2) == 0) codec = "gzip";
+    else if ((n == 3 && std::memcmp(ext, "zst", 3) == 0) || (n == 4 && std::memcmp(ext, "zstd", 4) == 0)) codec = "zstd";
+    if (codec) n = suffixLower(absPath, ext, absPath.size() - n - 1);
 
-    return current;
+    const ExtTable::Slot* sl = n > 0 ? registry().current.load(std::memory_order_acquire)->find(ext, n) : nullptr;
+    if (!sl) return { FileKind::Unknown, "unknown extension" };
+    if (codec) return { sl->kinds[0], QString("by extension (%1-compressed)").arg(QLatin1String(codec)) };
+
+    // Distinguish radiometric TIFF/JPEG vs non-radiometric:
+    if (sl->kinds[0] == FileKind::IRImage) return { FileKind::IRImage, "by extension (raster radiometric candidate)" };
+    return { sl->kinds[0], "by extension" };
 }
 
+FileDetectResult FileTypeDetector::detectByExtension(const QString& absolutePath) {
+    return detectByExt(absolutePath);
+}
+
+static const hps::StageId kStageExt      = hps::stage("detect.ext");
+static const hps::StageId kStageReadHead = hps::stage("detect.read_head");
+static const hps::StageId kStageClassify = hps::stage("detect.classify");
+
+// Unsupported extensions are never sniffed (FileSniffer::classify keeps
+// them Unknown), so their heads are not read either.
 FileDetectResult FileTypeDetector::detect(const QString& absolutePath) {
-    FileDetectResult r = detectByExt(absolutePath);
-    r = optionalSniff(absolutePath, r);
-    return r;
+    FileDetectResult r;
+    QByteArray head;
+    { hps::Scope s(kStageExt); r = detectByExt(absolutePath); }
+    if (r.kind == FileKind::Unknown) return r;
+    { hps::Scope s(kStageReadHead); head = FileSniffer::readHead(absolutePath); }
+    hps::Scope s(kStageClassify);
+    return FileSniffer::classify(head.constData(), head.size(), r);
+}
+
+void FileTypeDetector::detectMany(const QStringList& absolutePaths,
+                                  const std::function<void(int, const FileDetectResult&)>& onResult) {
+    QStringList sniffPaths;
+    QVector<int> sniffIndex;
+    QVector<FileDetectResult> sniffExt;
+    for (int i = 0; i < absolutePaths.size(); ++i) {
+        FileDetectResult r;
+        { hps::Scope s(kStageExt); r = detectByExt(absolutePaths[i]); }
+        if (r.kind == FileKind::Unknown) { onResult(i, r); continue; }
+        sniffPaths << absolutePaths[i];
+        sniffIndex << i;
+        sniffExt << r;
+    }
+    HeadReader::readAll(sniffPaths, FileSniffer::kHeadBytes, [&](int j, const char* data, int size) {
+        FileDetectResult r;
+        {
+            hps::Scope s(kStageClassify);
+            r = FileSniffer::classify(data, std::max(size, 0), sniffExt[j]);
+        }
+        onResult(sniffIndex[j], r);
+    });
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <QString>
 #include <QStringList>
 
@@ -31,10 +32,26 @@ public:
      *
      * Strategy:
      * 1) Extension mapping
-     * 2) (Optional) Content sniffing (magic bytes, CSV header)
+     * 2) Content sniffing of the first few KB (magic bytes, CSV header),
+     *    see FileSniffer; skipped, with no file access, for unsupported
+     *    extensions
      */
     static FileDetectResult detect(const QString& absolutePath);
 
+    /**
+     * @brief detect() for many files, with their head reads issued as one batch.
+     *
+     * Results are identical to calling detect() per path. onResult receives
+     * the index into absolutePaths as each file is classified (completion
+     * order, never concurrently); files with an unsupported extension come
+     * first and are not read. See HeadReader for how reads are issued.
+     */
+    static void detectMany(const QStringList& absolutePaths,
+                           const std::function<void(int index, const FileDetectResult&)>& onResult);
+
+    /// Extension mapping alone (no file access).
+    static FileDetectResult detectByExtension(const QString& absolutePath);
+
     /// Adds/overrides extensions for a given kind at runtime (optional)
     static void registerExtensions(FileKind kind, const QStringList& extsLowerNoDot);
 };
@@ -0,0 +1,137 @@
+#include "HeadReader.h"
+#include "FileSniffer.h"
+#include <QFile>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Opt-in (-DFILEMAKE_WITH_IO_URING ... -luring); otherwise the reader pool is used.
+#if defined(__linux__) && defined(FILEMAKE_WITH_IO_URING)
+#  include <liburing.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  define FILEMAKE_HAVE_IO_URING 1
+#endif
+
+#ifdef FILEMAKE_HAVE_IO_URING
+// IORING_OP_OPENAT and IORING_OP_READ arrived in Linux 5.6; older kernels
+// set up a ring fine but fail every openat with -EINVAL.
+static bool uringSupportsOpenRead() {
+    io_uring_probe* probe = io_uring_get_probe();
+    if (!probe) return false;
+    const bool ok = io_uring_opcode_supported(probe, IORING_OP_OPENAT)
+                 && io_uring_opcode_supported(probe, IORING_OP_READ);
+    io_uring_free_probe(probe);
+    return ok;
+}
+
+// Each slot is one file moving through openat -> read; the fd is closed
+// synchronously once its read completes. Returns false only when the ring
+// cannot be created or lacks the opcodes, before any callback has run.
+static bool readAllUring(const QStringList& paths, int maxBytes, const HeadReader::Callback& cb, int depth) {
+    static const bool supported = uringSupportsOpenRead();
+    if (!supported) return false;
+    io_uring ring;
+    if (io_uring_queue_init(unsigned(depth), &ring, 0) < 0) return false;
+
+    struct Slot {
+        int index = -1;
+        int fd = -1;
+        bool reading = false;
+        QByteArray name;
+        QByteArray buf;
+    };
+    std::vector<Slot> slots(size_t(depth));
+    std::vector<int> idle;
+    for (int s = depth - 1; s >= 0; --s) idle.push_back(s);
+
+    const int n = paths.size();
+    int next = 0, inflight = 0;
+    while (next < n || inflight > 0) {
+        while (next < n && !idle.empty()) {
+            const int s = idle.back();
+            idle.pop_back();
+            Slot& sl = slots[size_t(s)];
+            sl.index = next++;
+            sl.reading = false;
+            sl.name = QFile::encodeName(paths[sl.index]);
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            io_uring_prep_openat(sqe, AT_FDCWD, sl.name.constData(), O_RDONLY | O_CLOEXEC, 0);
+            io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(uintptr_t(s)));
+            ++inflight;
+        }
+        io_uring_submit_and_wait(&ring, 1);
+
+        io_uring_cqe* cqe;
+        unsigned head, seen = 0;
+        io_uring_for_each_cqe(&ring, head, cqe) {
+            ++seen;
+            --inflight;
+            const int s = int(reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe)));
+            Slot& sl = slots[size_t(s)];
+            if (!sl.reading && cqe->res >= 0) {
+                // Opened: queue the read into this slot's buffer (there is
+                // always a free SQE since every slot has at most one op).
+                sl.fd = cqe->res;
+                sl.reading = true;
+                sl.buf.resize(maxBytes);
+                io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+                io_uring_prep_read(sqe, sl.fd, sl.buf.data(), unsigned(maxBytes), 0);
+                io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(uintptr_t(s)));
+                ++inflight;
+                continue;
+            }
+            if (sl.reading) {
+                ::close(sl.fd);
+                sl.fd = -1;
+                cb(sl.index, sl.buf.constData(), cqe->res >= 0 ? cqe->res : -1);
+            } else {
+                cb(sl.index, nullptr, -1);
+            }
+            idle.push_back(s);
+        }
+        io_uring_cq_advance(&ring, seen);
+    }
+
+    io_uring_queue_exit(&ring);
+    return true;
+}
+#endif
+
+bool HeadReader::hasIoUring() {
+#ifdef FILEMAKE_HAVE_IO_URING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HeadReader::readAll(const QStringList& absPaths, int maxBytes, const Callback& cb, int queueDepth) {
+    if (absPaths.isEmpty()) return;
+    queueDepth = std::max(1, std::min(queueDepth, absPaths.size()));
+#ifdef FILEMAKE_HAVE_IO_URING
+    if (readAllUring(absPaths, maxBytes, cb, queueDepth)) return;
+#endif
+
+    // Blocking fallback: enough readers to keep several requests queued on
+    // slow storage, reporting through one lock.
+    const int threads = std::min(queueDepth, 32);
+    std::atomic<int> next{0};
+    std::mutex cbMutex;
+    auto work = [&]{
+        for (int i = next++; i < absPaths.size(); i = next++) {
+            bool ok = false;
+            const QByteArray head = FileSniffer::readHead(absPaths[i], maxBytes, &ok);
+            std::lock_guard<std::mutex> lk(cbMutex);
+            cb(i, head.constData(), ok ? head.size() : -1);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <functional>
+#include <QStringList>
+
+/**
+ * @brief Reads the first bytes of many files with as many reads in flight as possible.
+ *
+ * On Linux builds with FILEMAKE_WITH_IO_URING (link -luring), opens and reads are
+ * submitted through one io_uring (queueDepth files at a time) and completed
+ * on the calling thread. Elsewhere, or when the kernel refuses to set up a
+ * ring or lacks the openat/read opcodes (before 5.6), a pool of blocking
+ * readers does the same work. Either way the
+ * callback is never invoked concurrently.
+ */
+class HeadReader {
+public:
+    /// size < 0: the file could not be opened or read; 0: it is empty. The
+    /// same in both read paths.
+    using Callback = std::function<void(int index, const char* data, int size)>;
+
+    /// Read up to maxBytes from the start of every path; cb runs once per path, in completion order.
+    static void readAll(const QStringList& absPaths, int maxBytes, const Callback& cb, int queueDepth = 256);
+
+    /// True when readAll() was built with io_uring support.
+    static bool hasIoUring();
+};
@@ -0,0 +1,309 @@
+#pragma once
+// HotPathStats.h
+// Low-overhead timing for the loading / detection hot paths, shared by the Qt
+// side and csvdt (plain C++17, header-only).
+//
+//   static const hps::StageId kStage = hps::stage("csvdt.tokenize");
+//   { hps::Scope s(kStage); ...work... }      // latency + call count
+//   hps::count(kProbes, n);                   // plain counter
+//
+// Every thread records into its own slab (single writer, relaxed atomics),
+// so recording never contends; snapshot() merges the slabs on demand and
+// slabs of exited threads are folded into a retired total. Recording is off
+// until hps::enable(true): a disabled Scope costs one relaxed load and a
+// branch. Defining HOTPATH_STATS_DISABLED compiles every call to nothing.
+//
+// With tracing enabled (hps::enable_trace), Scopes also append complete
+// events to a per-thread buffer that write_chrome_trace() dumps as Chrome
+// trace JSON (chrome://tracing, Perfetto).
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hps {
+
+using StageId = uint16_t;
+
+constexpr size_t kMaxStages = 128;
+// Shared by every stage registered once the other kMaxStages - 1 are taken,
+// and never handed out to a named stage before that; reported as "(overflow)".
+constexpr StageId kOverflowStage = StageId(kMaxStages - 1);
+constexpr size_t kBuckets = 40;              // log2(ns) buckets: [2^i, 2^(i+1))
+constexpr size_t kMaxTraceEvents = 1 << 20;  // per thread
+
+struct StageStats {
+    std::string name;
+    uint64_t calls{0};      // Scopes closed, or count() increments
+    uint64_t total_ns{0};   // Scopes only
+    uint64_t max_ns{0};
+    double mean_ns{0.0};
+    double p50_ns{0.0}, p90_ns{0.0}, p99_ns{0.0};  // bucket upper bounds
+    std::array<uint64_t, kBuckets> histogram{};
+};
+
+namespace detail {
+
+inline uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline size_t bucket_of(uint64_t ns) {
+    size_t b = 0;
+    while (ns > 1 && b + 1 < kBuckets) { ns >>= 1; ++b; }
+    return b;
+}
+
+struct TraceEvent {
+    StageId stage;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+};
+
+// One thread's numbers. Only the owner writes; readers see possibly
+// slightly stale but never torn values.
+struct Slab {
+    struct Cell {
+        std::atomic<uint64_t> calls{0}, total_ns{0}, max_ns{0};
+        std::array<std::atomic<uint64_t>, kBuckets> hist{};
+    };
+    std::array<Cell, kMaxStages> cells;
+    std::mutex trace_mutex;          // owner appends, write_chrome_trace() reads
+    std::vector<TraceEvent> trace;
+    uint32_t tid{0};
+
+    static void bump(std::atomic<uint64_t> &a, uint64_t v) {
+        a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+    void add(StageId id, uint64_t n) { bump(cells[id].calls, n); }
+    void record(StageId id, uint64_t ns) {
+        Cell &c = cells[id];
+        bump(c.calls, 1);
+        bump(c.total_ns, ns);
+        if (ns > c.max_ns.load(std::memory_order_relaxed)) c.max_ns.store(ns, std::memory_order_relaxed);
+        bump(c.hist[bucket_of(ns)], 1);
+    }
+    void merge_into(Slab &dst) const {
+        for (size_t i = 0; i < kMaxStages; ++i) {
+            const Cell &s = cells[i];
+            Cell &d = dst.cells[i];
+            bump(d.calls, s.calls.load(std::memory_order_relaxed));
+            bump(d.total_ns, s.total_ns.load(std::memory_order_relaxed));
+            d.max_ns.store(std::max(d.max_ns.load(std::memory_order_relaxed), s.max_ns.load(std::memory_order_relaxed)),
+                           std::memory_order_relaxed);
+            for (size_t b = 0; b < kBuckets; ++b) bump(d.hist[b], s.hist[b].load(std::memory_order_relaxed));
+        }
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::vector<Slab*> live;
+    Slab retired;                       // merged slabs of exited threads
+    std::vector<std::pair<uint32_t, TraceEvent>> retired_trace;
+    uint32_t next_tid{1};
+    uint64_t epoch_ns{now_ns()};
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> tracing{false};
+};
+
+inline Registry &registry() {
+    static Registry *r = new Registry;  // outlives thread_local slabs at exit
+    return *r;
+}
+
+struct SlabHolder {
+    Slab *slab;
+    SlabHolder() : slab(new Slab) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lk(r.mutex);
+        slab->tid = r.next_tid++;
+        r.live.push_back(slab);
+    }
+    ~SlabHolder() {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lk(r.mutex);
+        slab->merge_into(r.retired);
+        {
+            std::lock_guard<std::mutex> tl(slab->trace_mutex);
+            for (auto &e : slab->trace) r.retired_trace.emplace_back(slab->tid, e);
+        }
+        r.live.erase(std::remove(r.live.begin(), r.live.end(), slab), r.live.end());
+        delete slab;
+    }
+};
+
+inline Slab &local_slab() {
+    thread_local SlabHolder holder;
+    return *holder.slab;
+}
+
+} // namespace detail
+
+// Register (or look up) a stage by name. Call once and keep the id, e.g. in
+// a namespace-scope static; ids are stable for the life of the process.
+inline StageId stage(const std::string &name) {
+    detail::Registry &r = detail::registry();
+    std::lock_guard<std::mutex> lk(r.mutex);
+    for (size_t i = 0; i < r.names.size(); ++i) if (r.names[i] == name) return StageId(i);
+    if (r.names.size() >= kOverflowStage) {
+        if (r.names.size() == kOverflowStage) r.names.push_back("(overflow)");
+        return kOverflowStage;
+    }
+    r.names.push_back(name);
+    return StageId(r.names.size() - 1);
+}
+
+inline void enable(bool on) { detail::registry().enabled.store(on, std::memory_order_relaxed); }
+inline bool enabled() { return detail::registry().enabled.load(std::memory_order_relaxed); }
+inline void enable_trace(bool on) {
+    if (on) enable(true);
+    detail::registry().tracing.store(on, std::memory_order_relaxed);
+}
+
+#ifndef HOTPATH_STATS_DISABLED
+
+inline void count(StageId id, uint64_t n = 1) {
+    if (enabled()) detail::local_slab().add(id, n);
+}
+
+class Scope {
+public:
+    explicit Scope(StageId id) : id_(id), start_(enabled() ? detail::now_ns() : 0) {}
+    ~Scope() {
+        if (!start_) return;
+        const uint64_t dur = detail::now_ns() - start_;
+        detail::Slab &s = detail::local_slab();
+        s.record(id_, dur);
+        detail::Registry &r = detail::registry();
+        if (r.tracing.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lk(s.trace_mutex);
+            if (s.trace.size() < kMaxTraceEvents) s.trace.push_back({id_, start_, dur});
+        }
+    }
+    Scope(const Scope&) = delete;
+    Scope &operator=(const Scope&) = delete;
+
+private:
+    StageId id_;
+    uint64_t start_;
+};
+
+#else
+
+inline void count(StageId, uint64_t = 1) {}
+
+class Scope {
+public:
+    explicit Scope(StageId) {}
+};
+
+#endif
+
+// Merged view over all threads (live and exited), one entry per stage that
+// saw any activity.
+inline std::vector<StageStats> snapshot() {
+    detail::Registry &r = detail::registry();
+    auto total = std::make_unique<detail::Slab>();
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lk(r.mutex);
+        names = r.names;
+        r.retired.merge_into(*total);
+        for (const detail::Slab *s : r.live) s->merge_into(*total);
+    }
+
+    std::vector<StageStats> out;
+    for (size_t i = 0; i < names.size(); ++i) {
+        const auto &c = total->cells[i];
+        StageStats st;
+        st.name = names[i];
+        st.calls = c.calls.load(std::memory_order_relaxed);
+        if (!st.calls) continue;
+        st.total_ns = c.total_ns.load(std::memory_order_relaxed);
+        st.max_ns = c.max_ns.load(std::memory_order_relaxed);
+        uint64_t timed = 0;
+        for (size_t b = 0; b < kBuckets; ++b) timed += (st.histogram[b] = c.hist[b].load(std::memory_order_relaxed));
+        if (timed) {
+            st.mean_ns = double(st.total_ns) / double(timed);
+            auto pct = [&](double q) {
+                const double want = q * double(timed);
+                uint64_t seen = 0;
+                for (size_t b = 0; b < kBuckets; ++b) {
+                    seen += st.histogram[b];
+                    if (double(seen) >= want) return std::min(double(uint64_t(2) << b), double(st.max_ns));
+                }
+                return double(st.max_ns);
+            };
+            st.p50_ns = pct(0.50);
+            st.p90_ns = pct(0.90);
+            st.p99_ns = pct(0.99);
+        }
+        out.push_back(std::move(st));
+    }
+    return out;
+}
+
+// Clears counters, histograms and trace buffers. Call while the measured
+// work is idle: a thread mid-update may keep a value from before the reset.
+inline void reset() {
+    detail::Registry &r = detail::registry();
+    std::lock_guard<std::mutex> lk(r.mutex);
+    auto clear = [](detail::Slab &s) {
+        for (auto &c : s.cells) {
+            c.calls.store(0, std::memory_order_relaxed);
+            c.total_ns.store(0, std::memory_order_relaxed);
+            c.max_ns.store(0, std::memory_order_relaxed);
+            for (auto &h : c.hist) h.store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> tl(s.trace_mutex);
+        s.trace.clear();
+    };
+    clear(r.retired);
+    for (detail::Slab *s : r.live) clear(*s);
+    r.retired_trace.clear();
+    r.epoch_ns = detail::now_ns();
+}
+
+// Chrome trace-event JSON of the recorded Scopes ("X" events, microseconds).
+inline bool write_chrome_trace(const std::string &path) {
+    detail::Registry &r = detail::registry();
+    std::vector<std::pair<uint32_t, detail::TraceEvent>> events;
+    std::vector<std::string> names;
+    uint64_t epoch;
+    {
+        std::lock_guard<std::mutex> lk(r.mutex);
+        names = r.names;
+        epoch = r.epoch_ns;
+        events = r.retired_trace;
+        for (detail::Slab *s : r.live) {
+            std::lock_guard<std::mutex> tl(s->trace_mutex);
+            for (auto &e : s->trace) events.emplace_back(s->tid, e);
+        }
+    }
+
+    std::ofstream f(path, std::ios::trunc);
+    if (!f) return false;
+    f << "{\"traceEvents\":[";
+    bool first = true;
+    for (auto &te : events) {
+        const detail::TraceEvent &e = te.second;
+        if (e.start_ns < epoch) continue;
+        f << (first ? "" : ",") << "\n{\"name\":\"" << names[e.stage] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << te.first
+          << ",\"ts\":" << double(e.start_ns - epoch) / 1000.0 << ",\"dur\":" << double(e.dur_ns) / 1000.0 << "}";
+        first = false;
+    }
+    f << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return bool(f);
+}
+
+} // namespace hps
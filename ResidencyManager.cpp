@@ -0,0 +1,161 @@
+#include "ResidencyManager.h"
+#include "CollectionFile.h"
+#include "CollectionFileHandle.h"
+#include "HotPathStats.h"
+
+#include <algorithm>
+
+static const hps::StageId kStageEvict = hps::stage("residency.evict");
+
+// Same control block: the handle itself, not another one at a reused address.
+static bool sameHandle(const std::weak_ptr<CollectionFileHandle>& w, const std::shared_ptr<CollectionFileHandle>& h) {
+    return !w.owner_before(h) && !h.owner_before(w);
+}
+
+ResidencyManager::ResidencyManager(qint64 budgetBytes)
+    : budget_(budgetBytes)
+{
+    weights_.fill(1.0);
+}
+
+void ResidencyManager::setBudget(qint64 bytes) {
+    std::lock_guard<std::mutex> lk(m_);
+    budget_ = bytes;
+    trimLocked(nullptr);
+}
+
+qint64 ResidencyManager::budget() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return budget_;
+}
+
+qint64 ResidencyManager::residentBytes() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return resident_;
+}
+
+int ResidencyManager::residentCount() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return int(lru_.size());
+}
+
+void ResidencyManager::setKindWeight(FileKind kind, double weight) {
+    std::lock_guard<std::mutex> lk(m_);
+    weights_[size_t(kind)] = std::max(0.0, weight);
+}
+
+void ResidencyManager::setFootprint(FootprintFn fn) {
+    std::lock_guard<std::mutex> lk(m_);
+    footprint_ = std::move(fn);
+}
+
+qint64 ResidencyManager::estimate(const CollectionFileHandle& h, const CollectionFile& obj) const {
+    if (footprint_) return std::max<qint64>(0, footprint_(h, obj));
+    return qint64(double(h.size()) * weights_[size_t(h.kind())]);
+}
+
+ResidencyManager::Lru::iterator ResidencyManager::findLocked(const std::shared_ptr<CollectionFileHandle>& handle) {
+    auto it = index_.find(handle.get());
+    if (it == index_.end()) return lru_.end();
+    const Lru::iterator e = *it;
+    if (sameHandle(e->handle, handle)) return e;
+    // Left behind by a destroyed handle whose address was reused.
+    dropLocked(e);
+    return lru_.end();
+}
+
+void ResidencyManager::dropLocked(Lru::iterator it) {
+    resident_ -= it->bytes;
+    index_.remove(it->key);
+    lru_.erase(it);
+}
+
+std::shared_ptr<CollectionFile> ResidencyManager::acquire(const std::shared_ptr<CollectionFileHandle>& handle) {
+    // Load outside the lock; a slow load must not stall other acquires.
+    std::shared_ptr<CollectionFile> obj = handle->get();
+    if (!obj) return obj;
+
+    std::lock_guard<std::mutex> lk(m_);
+    const CollectionFileHandle* key = handle.get();
+    auto it = findLocked(handle);
+    if (it != lru_.end()) {
+        lru_.splice(lru_.begin(), lru_, it);
+    } else {
+        Entry e;
+        e.handle = handle;
+        e.key = key;
+        e.bytes = estimate(*handle, *obj);
+        resident_ += e.bytes;
+        lru_.push_front(e);
+        index_.insert(key, lru_.begin());
+    }
+    trimLocked(key);
+    return obj;
+}
+
+void ResidencyManager::pin(const std::shared_ptr<CollectionFileHandle>& handle) {
+    std::lock_guard<std::mutex> lk(m_);
+    Pin& p = pins_[handle.get()];
+    if (!sameHandle(p.handle, handle)) p = Pin{handle, 0};  // new, or a dead handle's
+    ++p.count;
+}
+
+void ResidencyManager::unpin(const std::shared_ptr<CollectionFileHandle>& handle) {
+    std::lock_guard<std::mutex> lk(m_);
+    auto it = pins_.find(handle.get());
+    if (it == pins_.end() || !sameHandle(it->handle, handle)) return;
+    if (--it->count <= 0) pins_.erase(it);
+    trimLocked(nullptr);
+}
+
+void ResidencyManager::recharge(const std::shared_ptr<CollectionFileHandle>& handle) {
+    std::shared_ptr<CollectionFile> obj = handle->isLoaded() ? handle->get() : nullptr;
+    std::lock_guard<std::mutex> lk(m_);
+    auto it = findLocked(handle);
+    if (it == lru_.end() || !obj) return;
+    const qint64 bytes = estimate(*handle, *obj);
+    resident_ += bytes - it->bytes;
+    it->bytes = bytes;
+    obj.reset();
+    trimLocked(nullptr);
+}
+
+void ResidencyManager::forget(const CollectionFileHandle* handle) {
+    std::lock_guard<std::mutex> lk(m_);
+    pins_.remove(handle);
+    auto it = index_.find(handle);
+    if (it == index_.end()) return;
+    dropLocked(*it);
+}
+
+void ResidencyManager::trim() {
+    std::lock_guard<std::mutex> lk(m_);
+    trimLocked(nullptr);
+}
+
+void ResidencyManager::trimLocked(const CollectionFileHandle* keep) {
+    // Pins of destroyed handles protect nothing.
+    for (auto it = pins_.begin(); it != pins_.end();) {
+        if (it->handle.expired()) it = pins_.erase(it); else ++it;
+    }
+    if (resident_ <= budget_) return;
+
+    // Entries of destroyed handles go first: they free nothing more and
+    // only inflate the total.
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        if (it->handle.expired()) dropLocked(it++); else ++it;
+    }
+
+    // Oldest first; skip what is pinned, just acquired or still in use.
+    for (auto it = lru_.end(); resident_ > budget_ && it != lru_.begin();) {
+        --it;
+        if (it->key == keep || pins_.contains(it->key)) continue;
+        const std::shared_ptr<CollectionFileHandle> h = it->handle.lock();
+        if (h && !h->unloadIfUnused()) continue;
+
+        hps::count(kStageEvict);
+        resident_ -= it->bytes;
+        index_.remove(it->key);
+        it = lru_.erase(it);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <QHash>
+#include "FileTypeDetector.h"
+
+class CollectionFile;
+class CollectionFileHandle;
+
+/**
+ * @brief Keeps the loaded payload of a collection within a byte budget.
+ *
+ * Callers keep CollectionFileHandle objects (identity and metadata, cheap)
+ * and go through acquire() to reach the loaded CollectionFile. Each
+ * acquired object is charged its estimated decoded footprint and moved to
+ * the front of an LRU list; while the total is over budget, the least
+ * recently used objects are unloaded through their handle, which reloads on
+ * its next acquire().
+ *
+ * An object is only evicted when nothing outside its handle still holds it
+ * (evicting it would free nothing) and it is not pinned, so pin what is on
+ * screen. Resident bytes may exceed the budget by what is pinned or in use;
+ * everything else stays bounded whatever the collection size.
+ *
+ * Footprints default to file size times a per-kind weight (decoded bytes per
+ * byte on disk); setFootprint() can measure objects instead. Thread-safe.
+ *
+ * Entries and pins are looked up by handle address but hold a weak_ptr, so
+ * a handle destroyed without forget() is never confused with a new one at
+ * the same address: its entry is replaced, and its pins are dropped.
+ */
+class ResidencyManager {
+public:
+    using FootprintFn = std::function<qint64(const CollectionFileHandle&, const CollectionFile&)>;
+
+    explicit ResidencyManager(qint64 budgetBytes);
+
+    void setBudget(qint64 bytes);  ///< evicts right away if now over budget
+    qint64 budget() const;
+    qint64 residentBytes() const;
+    int residentCount() const;
+
+    /// Decoded bytes per on-disk byte for a kind (default 1.0).
+    void setKindWeight(FileKind kind, double weight);
+    void setFootprint(FootprintFn fn);
+
+    /**
+     * @brief The loaded object (loading it if needed), marked most recently used.
+     * @return nullptr if the handle's load failed or the kind is unsupported.
+     */
+    std::shared_ptr<CollectionFile> acquire(const std::shared_ptr<CollectionFileHandle>& handle);
+
+    /// Pinned handles are never evicted. Pins nest; unpin() releases one.
+    void pin(const std::shared_ptr<CollectionFileHandle>& handle);
+    void unpin(const std::shared_ptr<CollectionFileHandle>& handle);
+
+    /// Re-estimate a resident object, e.g. after it decoded more frames.
+    void recharge(const std::shared_ptr<CollectionFileHandle>& handle);
+
+    /// Stop tracking a handle (removed from the collection); it is not unloaded.
+    void forget(const CollectionFileHandle* handle);
+
+    /// Evict until within budget (also done by acquire() and setBudget()).
+    void trim();
+
+private:
+    struct Entry {
+        std::weak_ptr<CollectionFileHandle> handle;
+        const CollectionFileHandle* key = nullptr;
+        qint64 bytes = 0;
+    };
+    using Lru = std::list<Entry>;  // front = most recently used
+
+    struct Pin {
+        std::weak_ptr<CollectionFileHandle> handle;
+        int count = 0;
+    };
+
+    qint64 estimate(const CollectionFileHandle& h, const CollectionFile& obj) const;
+    Lru::iterator findLocked(const std::shared_ptr<CollectionFileHandle>& handle);  // lru_.end(): not tracked
+    void dropLocked(Lru::iterator it);
+    void trimLocked(const CollectionFileHandle* keep);
+
+    mutable std::mutex m_;
+    qint64 budget_ = 0;
+    qint64 resident_ = 0;
+    std::array<double, size_t(FileKind::Unknown) + 1> weights_;
+    FootprintFn footprint_;
+    Lru lru_;
+    QHash<const CollectionFileHandle*, Lru::iterator> index_;
+    QHash<const CollectionFileHandle*, Pin> pins_;
+};
@@ -0,0 +1,176 @@
+// Benchmarks for the csvdt hot paths (column_detector*.cpp).
+//
+// The internal header exposes the tokenizer and format matchers next to the
+// public API. Build on any Linux box with Google Benchmark installed, from
+// the repository root:
+//
+//   g++ -std=c++17 -O2 -pthread bench/bench_csvdt.cpp column_detector*.cpp -o bench_csvdt -lbenchmark
+//
+// Compressed input needs the codecs compiled in:
+//   -DCSVDT_WITH_ZLIB -DCSVDT_WITH_ZSTD ... -lz -lzstd
+//   ./bench_csvdt --benchmark_filter=Detect
+//
+// Inputs come from bench/generators.h; sample files are written to the
+// system temp directory once per process and removed at exit.
+
+#include "../column_detector_p.h"
+#include "generators.h"
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <map>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// One generated file per distinct spec, kept for the whole run.
+class SampleFiles {
+public:
+    ~SampleFiles() {
+        std::error_code ec;
+        for (auto &kv : files_) fs::remove(kv.second, ec);
+    }
+    const std::string &get(const std::string &key, const benchgen::CsvSpec &spec) {
+        auto it = files_.find(key);
+        if (it != files_.end()) return it->second;
+        const fs::path p = fs::temp_directory_path() / ("csvdt_bench_" + key + ".csv");
+        benchgen::write_file(p, benchgen::make_csv(spec));
+        return files_.emplace(key, p.string()).first->second;
+    }
+private:
+    std::map<std::string, std::string> files_;
+};
+
+SampleFiles &samples() {
+    static SampleFiles s;
+    return s;
+}
+
+std::vector<std::string> data_lines(const benchgen::CsvSpec &spec) {
+    const std::string csv = benchgen::make_csv(spec);
+    std::vector<std::string> lines;
+    size_t pos = csv.find('\n') + 1;
+    while (pos < csv.size()) {
+        const size_t end = csv.find('\n', pos);
+        lines.push_back(csv.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return lines;
+}
+
+// Args: columns, quoted-cell percentage.
+void BM_SplitCsvLine(benchmark::State &state) {
+    benchgen::CsvSpec spec;
+    spec.rows = 2000;
+    spec.cols = size_t(state.range(0));
+    spec.quote_rate = state.range(1) / 100.0;
+    const auto lines = data_lines(spec);
+    size_t bytes = 0;
+    for (auto &l : lines) bytes += l.size();
+    for (auto _ : state)
+        for (auto &l : lines) benchmark::DoNotOptimize(csvdt::split_csv_line(l, ','));
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(bytes));
+}
+BENCHMARK(BM_SplitCsvLine)->Args({8, 0})->Args({8, 20})->Args({64, 5})->Args({256, 5});
+
+void BM_TokenizerSplitLine(benchmark::State &state) {
+    benchgen::CsvSpec spec;
+    spec.rows = 2000;
+    spec.cols = size_t(state.range(0));
+    spec.quote_rate = state.range(1) / 100.0;
+    const auto lines = data_lines(spec);
+    size_t bytes = 0;
+    for (auto &l : lines) bytes += l.size();
+    csvdt::CsvTokenizer tok(',');
+    for (auto _ : state)
+        for (auto &l : lines) benchmark::DoNotOptimize(tok.split_line(l).size());
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(bytes));
+}
+BENCHMARK(BM_TokenizerSplitLine)->Args({8, 0})->Args({8, 20})->Args({64, 5})->Args({256, 5});
+
+// Every value of a bank (one per format) against every format of the bank,
+// which is what scoring does per cell.
+template <size_t N>
+void run_try_get_time(benchmark::State &state, const std::array<std::string_view, N> &text,
+                      const std::array<csvdt::CompiledFormat, N> &formats) {
+    std::vector<std::string> values;
+    for (size_t r = 0; r < 64; ++r)
+        for (auto f : text) values.push_back(benchgen::format_time(std::string(f), 1700000000 + int64_t(r) * 7919));
+    for (auto _ : state)
+        for (auto &v : values)
+            for (auto &f : formats) benchmark::DoNotOptimize(csvdt::try_get_time(v, f));
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size() * N));
+}
+void BM_TryGetTime_Date(benchmark::State &s)     { run_try_get_time(s, csvdt::kDateFormatText, csvdt::kDateFormats); }
+void BM_TryGetTime_Time(benchmark::State &s)     { run_try_get_time(s, csvdt::kTimeFormatText, csvdt::kTimeFormats); }
+void BM_TryGetTime_DateTime(benchmark::State &s) { run_try_get_time(s, csvdt::kDateTimeFormatText, csvdt::kDateTimeFormats); }
+void BM_TryGetTime_IsoLike(benchmark::State &s)  { run_try_get_time(s, csvdt::kIsoLikeFormatText, csvdt::kIsoLikeFormats); }
+BENCHMARK(BM_TryGetTime_Date);
+BENCHMARK(BM_TryGetTime_Time);
+BENCHMARK(BM_TryGetTime_DateTime);
+BENCHMARK(BM_TryGetTime_IsoLike);
+
+// best_format_for over a 1000-row sampled column; arg = index into the
+// DateTime bank used to generate it.
+void BM_BestFormatFor(benchmark::State &state) {
+    const auto fmt = csvdt::kDateTimeFormatText[size_t(state.range(0))];
+    benchgen::CsvSpec spec;
+    spec.rows = 1000;
+    spec.format = std::string(fmt);
+    const auto &path = samples().get("bff" + std::to_string(state.range(0)), spec);
+    const auto table = csvdt::Detector::read_csv_sample(path, 1000);
+    const auto col = table.column(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(csvdt::best_format_for(col, csvdt::kDateFormats));
+        benchmark::DoNotOptimize(csvdt::best_format_for(col, csvdt::kTimeFormats));
+        benchmark::DoNotOptimize(csvdt::best_format_for(col, csvdt::kDateTimeFormats));
+        benchmark::DoNotOptimize(csvdt::best_format_for(col, csvdt::kIsoLikeFormats, true));
+    }
+    state.SetLabel(std::string(fmt));
+}
+BENCHMARK(BM_BestFormatFor)->DenseRange(0, int(csvdt::kDateTimeFormatText.size()) - 1);
+
+benchgen::CsvSpec large_spec() {
+    benchgen::CsvSpec spec;
+    spec.rows = 200000;
+    spec.cols = 24;
+    return spec;
+}
+
+// Arg 0: head sampling, 1: stratified.
+void BM_ReadCsvSample(benchmark::State &state) {
+    const auto &path = samples().get("large", large_spec());
+    csvdt::Detector::SampleOptions opt;
+    if (state.range(0)) opt.mode = csvdt::Detector::SampleMode::Stratified;
+    for (auto _ : state) benchmark::DoNotOptimize(csvdt::Detector::read_csv_sample(path, opt));
+}
+BENCHMARK(BM_ReadCsvSample)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Args: time column kind (benchgen::TimeColumn), threads.
+void BM_Detect(benchmark::State &state) {
+    benchgen::CsvSpec spec;
+    spec.rows = 1000;
+    spec.cols = 48;
+    spec.time = benchgen::TimeColumn(state.range(0));
+    if (spec.time == benchgen::TimeColumn::DateAndTime || spec.time == benchgen::TimeColumn::DateOnly) spec.format = "%d/%m/%Y";
+    const auto &path = samples().get("detect" + std::to_string(state.range(0)), spec);
+    const auto table = csvdt::Detector::read_csv_sample(path, 1000);
+    for (auto _ : state) benchmark::DoNotOptimize(csvdt::Detector::detect(table, unsigned(state.range(1))));
+}
+BENCHMARK(BM_Detect)
+    ->ArgsProduct({{int(benchgen::TimeColumn::DateTime), int(benchgen::TimeColumn::DateAndTime),
+                    int(benchgen::TimeColumn::EpochSeconds), int(benchgen::TimeColumn::EpochMillis)}, {1, 4}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_DetectAdaptive(benchmark::State &state) {
+    const auto &path = samples().get("large", large_spec());
+    const csvdt::Detector::AdaptiveOptions opt;
+    for (auto _ : state) benchmark::DoNotOptimize(csvdt::Detector::detect_adaptive(path, opt));
+}
+BENCHMARK(BM_DetectAdaptive)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,185 @@
+#pragma once
+// Synthetic inputs for the benchmarks: CSV logs shaped like the ones the
+// detector sees in the field, and fake collection trees whose files carry
+// the magic bytes FileSniffer looks for. Plain C++17, no Qt.
+
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace benchgen {
+
+// Small deterministic generator so runs are comparable across machines.
+struct Rng {
+    uint64_t s;
+    explicit Rng(uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    uint32_t next() { s ^= s << 13; s ^= s >> 7; s ^= s << 17; return uint32_t(s >> 16); }
+    uint32_t below(uint32_t n) { return next() % n; }
+    double unit() { return next() / 4294967296.0; }
+};
+
+enum class TimeColumn { DateTime, DateAndTime, DateOnly, EpochSeconds, EpochMillis, None };
+
+struct CsvSpec {
+    size_t rows = 10000;
+    size_t cols = 12;                        // total, time columns included
+    char delim = ',';
+    double quote_rate = 0.05;                // share of text cells that need quoting
+    double empty_rate = 0.01;                // share of filler cells left empty
+    TimeColumn time = TimeColumn::DateTime;
+    std::string format = "%Y-%m-%d %H:%M:%S"; // DateTime / DateOnly column, date part of DateAndTime
+    std::string time_format = "%H:%M:%S";     // time part of DateAndTime
+    std::string suffix;                      // appended to DateTime values, e.g. ".250Z" or "+02:00"
+    int64_t start_epoch = 1700000000;
+    int64_t step_seconds = 1;
+    unsigned seed = 1;
+};
+
+inline std::string format_time(const std::string &fmt, int64_t epoch) {
+    const std::time_t t = static_cast<std::time_t>(epoch);
+    std::tm tm{};
+#if defined(_WIN32)
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char buf[128];
+    const size_t n = std::strftime(buf, sizeof(buf), fmt.c_str(), &tm);
+    return std::string(buf, n);
+}
+
+inline void append_text_cell(std::string &out, Rng &rng, const CsvSpec &spec) {
+    static const char *const kWords[] = { "north", "gate", "ok", "fault", "idle", "zone A", "cam-3", "n/a" };
+    const char *w = kWords[rng.below(8)];
+    if (rng.unit() < spec.quote_rate) {
+        out += '"';
+        out += w;
+        out += spec.delim;
+        out += rng.below(2) ? " \"\"ref\"\"" : " more";
+        out += '"';
+    } else {
+        out += w;
+    }
+}
+
+// Header plus spec.rows data lines, "\n"-terminated.
+inline std::string make_csv(const CsvSpec &spec) {
+    Rng rng(spec.seed);
+    size_t timeCols = 0;
+    std::string out;
+    std::vector<std::string> headers;
+    switch (spec.time) {
+        case TimeColumn::DateTime:     headers = {"timestamp"}; break;
+        case TimeColumn::DateAndTime:  headers = {"date", "time"}; break;
+        case TimeColumn::DateOnly:     headers = {"date"}; break;
+        case TimeColumn::EpochSeconds: headers = {"unix_ts"}; break;
+        case TimeColumn::EpochMillis:  headers = {"ts_ms"}; break;
+        case TimeColumn::None: break;
+    }
+    timeCols = headers.size();
+    for (size_t c = timeCols; c < spec.cols; ++c) headers.push_back("col" + std::to_string(c));
+    for (size_t c = 0; c < headers.size(); ++c) {
+        if (c) out += spec.delim;
+        out += headers[c];
+    }
+    out += '\n';
+
+    for (size_t r = 0; r < spec.rows; ++r) {
+        const int64_t t = spec.start_epoch + int64_t(r) * spec.step_seconds;
+        switch (spec.time) {
+            case TimeColumn::DateTime:     out += format_time(spec.format, t) + spec.suffix; break;
+            case TimeColumn::DateAndTime:  out += format_time(spec.format, t) + spec.delim + format_time(spec.time_format, t); break;
+            case TimeColumn::DateOnly:     out += format_time(spec.format, t); break;
+            case TimeColumn::EpochSeconds: out += std::to_string(t); break;
+            case TimeColumn::EpochMillis:  out += std::to_string(t * 1000 + rng.below(1000)); break;
+            case TimeColumn::None: break;
+        }
+        for (size_t c = timeCols; c < spec.cols; ++c) {
+            if (c) out += spec.delim;
+            if (rng.unit() < spec.empty_rate) continue;
+            switch (c % 3) {
+                case 0: out += std::to_string(rng.below(100000)) + "." + std::to_string(rng.below(1000)); break;
+                case 1: out += std::to_string(rng.below(5000)); break;
+                default: append_text_cell(out, rng, spec); break;
+            }
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+inline void write_file(const std::filesystem::path &p, const std::string &content) {
+    std::ofstream f(p, std::ios::binary | std::ios::trunc);
+    f.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+// File counts per kind for a fake collection; files are spread over `dirs`
+// subdirectories and padded to `payload_bytes`.
+struct TreeSpec {
+    size_t ir_movies = 50;     // .csq, FFF container
+    size_t ir_images = 400;    // .jpg with a FLIR APP1 segment
+    size_t plain_jpegs = 200;  // .jpg, JFIF only
+    size_t pngs = 100;
+    size_t movies = 50;        // .mp4 (ftyp isom)
+    size_t weather_csvs = 100;
+    size_t sensor_csvs = 100;
+    size_t dirs = 16;
+    size_t payload_bytes = 16 * 1024;
+    unsigned seed = 1;
+};
+
+inline std::string pad(std::string head, size_t bytes, Rng &rng) {
+    while (head.size() < bytes) head.push_back(char(rng.below(256)));
+    return head;
+}
+
+inline std::string jpeg_head(bool flir) {
+    std::string h("\xFF\xD8", 2);
+    h += std::string("\xFF\xE0\x00\x10JFIF\0\x01\x01\0\0\x01\0\x01\0\0", 18);
+    if (flir) {
+        const std::string seg = std::string("FLIR\0\x01\x00\x00", 8) + "FFF" + std::string(53, '\0');
+        h += "\xFF\xE1";
+        h += char((seg.size() + 2) >> 8);
+        h += char((seg.size() + 2) & 0xFF);
+        h += seg;
+    }
+    h += std::string("\xFF\xDA\x00\x08\x01\x01\x00\x00\x3F\x00", 10);
+    return h;
+}
+
+// Returns the absolute paths written, in creation order.
+inline std::vector<std::string> make_collection_tree(const std::filesystem::path &root, const TreeSpec &spec) {
+    namespace fs = std::filesystem;
+    Rng rng(spec.seed);
+    std::vector<std::string> paths;
+    size_t serial = 0;
+    auto emit = [&](const char *ext, const std::string &content) {
+        const fs::path dir = root / ("d" + std::to_string(serial % spec.dirs));
+        fs::create_directories(dir);
+        const fs::path p = dir / ("f" + std::to_string(serial++) + ext);
+        write_file(p, content);
+        paths.push_back(fs::absolute(p).string());
+    };
+
+    CsvSpec weather;
+    weather.rows = 200;
+    weather.cols = 5;
+    CsvSpec sensor = weather;
+    std::string w = make_csv(weather), s = make_csv(sensor);
+    w.replace(0, w.find('\n'), "timestamp,temperature,humidity,wind_speed,pressure");
+    s.replace(0, s.find('\n'), "timestamp,sensor_id,object_temp,emissivity,reflected_temp");
+
+    for (size_t i = 0; i < spec.ir_movies; ++i)   emit(".csq", pad(std::string("FFF\0", 4), spec.payload_bytes, rng));
+    for (size_t i = 0; i < spec.ir_images; ++i)   emit(".jpg", pad(jpeg_head(true), spec.payload_bytes, rng));
+    for (size_t i = 0; i < spec.plain_jpegs; ++i) emit(".jpg", pad(jpeg_head(false), spec.payload_bytes, rng));
+    for (size_t i = 0; i < spec.pngs; ++i)        emit(".png", pad("\x89PNG\r\n\x1a\n", spec.payload_bytes, rng));
+    for (size_t i = 0; i < spec.movies; ++i)      emit(".mp4", pad(std::string("\0\0\0\x18" "ftypisom", 12), spec.payload_bytes, rng));
+    for (size_t i = 0; i < spec.weather_csvs; ++i) emit(".csv", w);
+    for (size_t i = 0; i < spec.sensor_csvs; ++i)  emit(".csv", s);
+    return paths;
+}
+
+} // namespace benchgen
@@ -0,0 +1,30 @@
+#pragma once
+// Benchmark stand-in for the application's CollectionFile hierarchy. load()
+// reads the whole file once so factory benchmarks include realistic I/O
+// without any decoding.
+#include <QFile>
+#include <QString>
+
+class CollectionFile {
+public:
+    explicit CollectionFile(const QString& id) : id_(id) {}
+    virtual ~CollectionFile() = default;
+
+    const QString& id() const { return id_; }
+    qint64 loadedBytes() const { return bytes_; }
+
+    virtual void load(const QString& absPath) {
+        QFile f(absPath);
+        if (f.open(QIODevice::ReadOnly)) bytes_ = f.readAll().size();
+    }
+
+private:
+    QString id_;
+    qint64 bytes_ = 0;
+};
+
+#define BENCH_STUB_FILE(Name)                                          \
+    class Name : public CollectionFile {                               \
+    public:                                                            \
+        explicit Name(const QString& id) : CollectionFile(id) {}       \
+    };
@@ -0,0 +1,3 @@
+#pragma once
+#include "CollectionFile.h"
+BENCH_STUB_FILE(WeatherFile)
@@ -1,434 +1,1028 @@
-// smart_datetime_detector.cpp
-// C++17+ (works even better with C++20). Single-file utility for inferring CSV date/time columns & formats.
-
-#include <algorithm>
-#include <array>
-#include <cctype>
-#include <chrono>
-#include <ctime>
+// column_detector.cpp
+// csvdt detection and full-file timestamp extraction, plus the file access
+// and decoding the other sources share (see column_detector.h).
+
+#include "column_detector_p.h"
+
 #include <fstream>
-#include <iomanip>
-#include <iostream>
-#include <locale>
-#include <optional>
-#include <regex>
-#include <sstream>
-#include <string>
-#include <tuple>
-#include <unordered_map>
-#include <vector>
+#include <map>
+
+// Compressed input (see DecodeStream) is opt-in, since it adds link
+// dependencies: -DCSVDT_WITH_ZLIB ... -lz, -DCSVDT_WITH_ZSTD ... -lzstd.
+#if defined(CSVDT_WITH_ZLIB)
+#  include <zlib.h>
+#  define CSVDT_HAVE_ZLIB 1
+#endif
+#if defined(CSVDT_WITH_ZSTD)
+#  include <zstd.h>
+#  define CSVDT_HAVE_ZSTD 1
+#endif
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
 
 namespace csvdt {
 
-enum class Role { Unknown, Date, Time, DateTime, EpochSeconds, EpochMillis };
+// --- file access ------------------------------------------------------------
 
-struct DetectedColumn {
-    size_t index{};
-    Role role{Role::Unknown};
-    std::string format;     // strptime/get_time-compatible format (empty for epoch)
-    double confidence{0.0}; // 0..1 based on sample parse rate (+header boost)
-    std::string header;
-};
+MappedFile::MappedFile(const std::string &path, Access access) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING,
+                              access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open file: " + path);
+    file_ = file;
+    LARGE_INTEGER sz{};
+    GetFileSizeEx(file, &sz);
+    size_ = static_cast<size_t>(sz.QuadPart);
+    if (size_ == 0) return;
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_) data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) { close(); throw std::runtime_error("Cannot map file: " + path); }
+#else
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) throw std::runtime_error("Cannot open file: " + path);
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0) { close(); throw std::runtime_error("Cannot stat file: " + path); }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) return;
+    void *p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) { close(); throw std::runtime_error("Cannot map file: " + path); }
+    data_ = static_cast<const char*>(p);
+    ::madvise(p, size_, access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+}
 
-struct DetectionResult {
-    // Either: datetime_col has value; or: date_col and time_col have values
-    std::optional<DetectedColumn> datetime_col;
-    std::optional<DetectedColumn> date_col;
-    std::optional<DetectedColumn> time_col;
-    char delimiter{','};
-    std::vector<DetectedColumn> all_columns; // for inspection/debug
-};
+void MappedFile::close() {
+#if defined(_WIN32)
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+}
 
-// --- small helpers ----------------------------------------------------------
+bool stat_file(const std::string &path, FileStamp &out) {
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA fa{};
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &fa)) return false;
+    out.size = (uint64_t(fa.nFileSizeHigh) << 32) | fa.nFileSizeLow;
+    const uint64_t ticks = (uint64_t(fa.ftLastWriteTime.dwHighDateTime) << 32) | fa.ftLastWriteTime.dwLowDateTime;
+    out.mtime_ns = static_cast<int64_t>(ticks) * 100;
+#else
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) return false;
+    out.size = static_cast<uint64_t>(st.st_size);
+#  if defined(__APPLE__)
+    out.mtime_ns = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#  else
+    out.mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#  endif
+#endif
+    return true;
+}
 
-static inline std::string trim(const std::string &s) {
-    size_t a = 0, b = s.size();
-    while (a < b && std::isspace(static_cast<unsigned char>(s[a]))) ++a;
-    while (b > a && std::isspace(static_cast<unsigned char>(s[b-1]))) --b;
-    return s.substr(a, b - a);
+std::string write_temp(const std::string &path, std::string_view bytes) {
+    const std::string tmp = path + ".tmp";
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f) throw std::runtime_error("Cannot write: " + tmp);
+    f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!f) throw std::runtime_error("Cannot write: " + tmp);
+    return tmp;
 }
 
-static inline std::string tolower_copy(std::string s) {
-    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return std::tolower(c); });
-    return s;
+void rename_over(const std::string &tmp, const std::string &path) {
+#if defined(_WIN32)
+    if (!MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+#endif
+        throw std::runtime_error("Cannot replace: " + path);
 }
 
-static char sniff_delimiter(const std::string &headerLine) {
-    // Look for common delimiters; choose the one with the most occurrences
-    const std::array<char,4> cands{',',';','\t','|'};
-    size_t bestCount = 0;
-    char best = ',';
-    for (char d : cands) {
-        size_t cnt = std::count(headerLine.begin(), headerLine.end(), d);
-        if (cnt > bestCount) { bestCount = cnt; best = d; }
-    }
-    return best;
+ThreadPool &ThreadPool::shared(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    static std::mutex mu;
+    static std::map<unsigned, std::unique_ptr<ThreadPool>> pools;
+    std::lock_guard<std::mutex> lk(mu);
+    std::unique_ptr<ThreadPool> &pool = pools[threads];
+    if (!pool) pool = std::make_unique<ThreadPool>(threads);
+    return *pool;
 }
 
-// Basic CSV splitter (handles quoted fields with the chosen delimiter)
-static std::vector<std::string> split_csv_line(const std::string &line, char delim) {
-    std::vector<std::string> out;
-    std::string cur;
-    bool inQuotes = false;
-    for (size_t i=0;i<line.size();++i) {
-        char c = line[i];
-        if (c == '"') {
-            if (inQuotes && i+1<line.size() && line[i+1]=='"') {
-                cur.push_back('"'); // escaped quote
-                ++i;
-            } else {
-                inQuotes = !inQuotes;
+std::vector<size_t> split_record_aligned(std::string_view data, size_t begin, size_t end,
+                                         size_t parts, ThreadPool &pool)
+{
+    std::vector<size_t> cuts{begin};
+    if (parts <= 1 || end <= begin) { cuts.push_back(end); return cuts; }
+
+    const size_t span = (end - begin + parts - 1) / parts;
+    struct Scan { size_t quotes{0}; size_t nl_even{SIZE_MAX}, nl_odd{SIZE_MAX}; };
+    std::vector<Scan> scans(parts);
+    pool.parallel_for(parts, [&](size_t i){
+        const size_t a = begin + i * span;
+        const size_t b = std::min(end, a + span);
+        if (a >= b) return;
+        Scan sc;
+        const char *p = data.data() + a, *e = data.data() + b;
+        while ((p = find_special(p, e, '"', '\n', '\n')) != e) {
+            if (*p == '"') ++sc.quotes;
+            else {
+                const size_t off = static_cast<size_t>(p - data.data()) + 1;
+                if (sc.quotes % 2 == 0) { if (sc.nl_even == SIZE_MAX) sc.nl_even = off; }
+                else if (sc.nl_odd == SIZE_MAX) sc.nl_odd = off;
             }
-        } else if (c == delim && !inQuotes) {
-            out.push_back(cur);
-            cur.clear();
-        } else {
-            cur.push_back(c);
+            ++p;
+        }
+        scans[i] = sc;
+    });
+
+    size_t parity = 0; // quote parity at the start of chunk i
+    for (size_t i = 0; i < parts; ++i) {
+        if (i > 0) {
+            const size_t cut = parity == 0 ? scans[i].nl_even : scans[i].nl_odd;
+            if (cut != SIZE_MAX && cut < end && cut > cuts.back()) cuts.push_back(cut);
         }
+        parity = (parity + scans[i].quotes) & 1;
     }
-    out.push_back(cur);
-    return out;
+    cuts.push_back(end);
+    return cuts;
 }
 
-// Try parsing with std::get_time for a given format (after normalizing string).
-static bool try_get_time(const std::string &value, const std::string &fmt) {
-    std::tm tm{}; tm.tm_isdst = -1;
-    std::istringstream iss(value);
-    iss.imbue(std::locale::classic());
-    iss >> std::get_time(&tm, fmt.c_str());
-    return !iss.fail();
-}
+// --- compressed input -------------------------------------------------------
 
-// Normalize ISO-8601-ish strings so get_time can cope better:
-// - Strip trailing 'Z'
-// - Strip timezone offsets like +hh:mm or -hhmm (we ignore the offset for format detection)
-// - Remove fractional seconds ".sss..." but remember we did it
-static std::string normalize_iso_like(std::string s) {
-    s = trim(s);
-    // Remove trailing Z
-    if (!s.empty() && (s.back()=='Z' || s.back()=='z')) {
-        s.pop_back();
-        s = trim(s);
-    }
-    // Remove timezone offset (common forms: +hh:mm, -hh:mm, +hhmm, -hhmm)
-    static const std::regex tz1(R"(([+-]\d{2}:\d{2})$)");
-    static const std::regex tz2(R"(([+-]\d{4})$)");
-    s = std::regex_replace(s, tz1, "");
-    s = std::regex_replace(s, tz2, "");
-    s = trim(s);
-    // Remove fractional .sss...
-    static const std::regex frac(R"((\.\d{1,9}))");
-    s = std::regex_replace(s, frac, "");
-    return s;
-}
+struct DecodeStream::Codec {
+#if defined(CSVDT_HAVE_ZLIB)
+    z_stream z{};
+    bool member_done{false};
+#endif
+#if defined(CSVDT_HAVE_ZSTD)
+    ZSTD_DStream *zs{nullptr};
+    bool drained{true};
+#endif
 
-struct FormatHit {
-    std::string fmt;
-    size_t hits{};
+    ~Codec() {
+#if defined(CSVDT_HAVE_ZLIB)
+        if (z.state) inflateEnd(&z);
+#endif
+#if defined(CSVDT_HAVE_ZSTD)
+        if (zs) ZSTD_freeDStream(zs);
+#endif
+    }
 };
 
-static bool is_epoch_seconds(const std::string &s) {
-    static const std::regex re(R"(^\d{10}$)");
-    return std::regex_match(trim(s), re);
+DecodeStream::DecodeStream(std::string_view src, Compression kind)
+    : src_(src), kind_(kind), codec_(std::make_unique<Codec>()) {
+    if (kind_ == Compression::Gzip) {
+#if defined(CSVDT_HAVE_ZLIB)
+        z_stream &z = codec_->z;
+        if (inflateInit2(&z, 15 + 32) != Z_OK) throw std::runtime_error("Cannot start gzip decoder");
+        z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src_.data()));
+        z.avail_in = 0;
+#else
+        throw std::runtime_error("gzip input needs a build with -DCSVDT_WITH_ZLIB");
+#endif
+    } else if (kind_ == Compression::Zstd) {
+#if defined(CSVDT_HAVE_ZSTD)
+        codec_->zs = ZSTD_createDStream();
+        if (!codec_->zs || ZSTD_isError(ZSTD_initDStream(codec_->zs))) throw std::runtime_error("Cannot start zstd decoder");
+#else
+        throw std::runtime_error("zstd input needs a build with -DCSVDT_WITH_ZSTD");
+#endif
+    }
 }
 
-static bool is_epoch_millis(const std::string &s) {
-    static const std::regex re(R"(^\d{13}$)");
-    return std::regex_match(trim(s), re);
-}
+DecodeStream::~DecodeStream() = default;
 
-// Score a column against candidate formats; return best format and score
-static std::pair<std::string,double> best_format_for(
-    const std::vector<std::string> &samples,
-    const std::vector<std::string> &formats,
-    bool normalize_iso=false)
-{
-    std::vector<FormatHit> tally;
-    tally.reserve(formats.size());
-    for (auto &f: formats) tally.push_back({f,0});
-
-    size_t nonEmpty = 0;
-    for (auto s : samples) {
-        s = trim(s);
-        if (s.empty()) continue;
-        ++nonEmpty;
-        std::string test = normalize_iso ? normalize_iso_like(s) : s;
-        for (auto &fh : tally) {
-            if (try_get_time(test, fh.fmt)) {
-                fh.hits++;
+size_t DecodeStream::read(std::string &out, size_t max) {
+    const size_t old = out.size();
+    out.resize(old + max);
+    char *dst = &out[old];
+    size_t got = 0;
+#if defined(CSVDT_HAVE_ZLIB)
+    if (kind_ == Compression::Gzip) {
+        z_stream &z = codec_->z;
+        while (got < max) {
+            if (z.avail_in == 0) {
+                const size_t chunk = std::min<size_t>(src_.size() - in_, 1u << 20);
+                if (!chunk) {
+                    if (!codec_->member_done) throw std::runtime_error("Truncated gzip data");
+                    break;
+                }
+                z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src_.data() + in_));
+                z.avail_in = static_cast<uInt>(chunk);
+                in_ += chunk;
+            }
+            z.next_out = reinterpret_cast<Bytef*>(dst + got);
+            z.avail_out = static_cast<uInt>(std::min<size_t>(max - got, UINT32_MAX));
+            const uInt before = z.avail_out;
+            const int rc = inflate(&z, Z_NO_FLUSH);
+            got += before - z.avail_out;
+            if (rc == Z_STREAM_END) {
+                // Another member may follow (trailing zero padding is tolerated).
+                codec_->member_done = true;
+                if (z.avail_in == 0 && in_ == src_.size()) break;
+                if (z.avail_in && *z.next_in != 0x1f) { in_ = src_.size(); z.avail_in = 0; break; }
+                inflateReset(&z);
+                codec_->member_done = false;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                throw std::runtime_error("Corrupt gzip data");
+            }
+        }
+    }
+#endif
+#if defined(CSVDT_HAVE_ZSTD)
+    if (kind_ == Compression::Zstd) {
+        ZSTD_outBuffer ob{dst, max, 0};
+        while (ob.pos < max) {
+            ZSTD_inBuffer ib{src_.data(), src_.size(), in_};
+            if (ib.pos == ib.size && ob.pos == 0 && codec_->drained) break;
+            const size_t rc = ZSTD_decompressStream(codec_->zs, &ob, &ib);
+            if (ZSTD_isError(rc)) throw std::runtime_error(std::string("Corrupt zstd data: ") + ZSTD_getErrorName(rc));
+            const bool progressed = ib.pos != in_;
+            in_ = ib.pos;
+            codec_->drained = rc == 0;
+            if (ib.pos == ib.size && (rc == 0 || !progressed) && ob.pos < max) {
+                if (rc != 0) throw std::runtime_error("Truncated zstd data");
+                break;
             }
         }
+        got = ob.pos;
     }
-    // If column is empty in all sample rows, avoid division by zero
-    if (nonEmpty == 0) return {"", 0.0};
+#endif
+    if (kind_ == Compression::None) {
+        got = std::min(max, src_.size() - in_);
+        std::memcpy(dst, src_.data() + in_, got);
+        in_ += got;
+    }
+    out.resize(old + got);
+    return got;
+}
 
-    // Pick best
-    auto it = std::max_element(tally.begin(), tally.end(),
-        [](const FormatHit&a, const FormatHit&b){ return a.hits < b.hits; });
+// Seek table of a zstd seekable-format file: decoded byte ranges map to
+// independent frames, so any range decodes without the bytes before it.
+class ZstdSeekTable {
+public:
+    explicit ZstdSeekTable(std::string_view src) {
+        constexpr uint32_t kSkippableMagic = 0x184D2A5E, kSeekableMagic = 0x8F92EAB1;
+        if (src.size() < 17 || get_u32(src, src.size() - 4) != kSeekableMagic) return;
+        const uint32_t frames = get_u32(src, src.size() - 9);
+        const uint8_t desc = uint8_t(src[src.size() - 5]);
+        const size_t entry = (desc & 0x80) ? 12 : 8;
+        const uint64_t table = uint64_t(frames) * entry + 9;
+        if (table + 8 > src.size()) return;
+        const size_t at = src.size() - static_cast<size_t>(table) - 8;
+        if (get_u32(src, at) != kSkippableMagic || get_u32(src, at + 4) != table) return;
 
-    double score = static_cast<double>(it->hits) / static_cast<double>(nonEmpty);
-    return {it->fmt, score};
-}
+        uint64_t c = 0, d = 0;
+        frames_.reserve(frames);
+        for (uint32_t i = 0; i < frames; ++i) {
+            const size_t e = at + 8 + size_t(i) * entry;
+            frames_.push_back({c, d, get_u32(src, e), get_u32(src, e + 4)});
+            c += frames_.back().csize;
+            d += frames_.back().dsize;
+        }
+        if (c != at) { frames_.clear(); return; }
+        size_ = d;
+    }
+
+    bool valid() const { return !frames_.empty(); }
+    uint64_t size() const { return size_; }
 
-// Header “prior” boost
-static double header_prior(const std::string &hdr, Role role) {
-    std::string h = tolower_copy(hdr);
-    auto has = [&](std::initializer_list<const char*> kws){
-        for (auto k: kws) if (h.find(k) != std::string::npos) return true;
-        return false;
+    // Decodes the frames overlapping [begin, begin + len) into out and returns
+    // the decoded offset of out[0] (frame aligned).
+    uint64_t read(std::string_view src, uint64_t begin, size_t len, std::string &out) const {
+        out.clear();
+        if (begin >= size_) return size_;
+        auto it = std::upper_bound(frames_.begin(), frames_.end(), begin,
+                                   [](uint64_t v, const Frame &f){ return v < f.doff; }) - 1;
+        const uint64_t base = it->doff;
+        for (; it != frames_.end() && it->doff < begin + len; ++it) {
+            const size_t old = out.size();
+            out.resize(old + it->dsize);
+#if defined(CSVDT_HAVE_ZSTD)
+            const size_t rc = ZSTD_decompress(&out[old], it->dsize, src.data() + it->coff, it->csize);
+            if (ZSTD_isError(rc) || rc != it->dsize) throw std::runtime_error("Corrupt zstd frame");
+#else
+            (void)src;
+            throw std::runtime_error("zstd input needs a build with -DCSVDT_WITH_ZSTD");
+#endif
+        }
+        return base;
+    }
+
+private:
+    struct Frame { uint64_t coff, doff; uint32_t csize, dsize; };
+
+    static uint32_t get_u32(std::string_view s, size_t at) {
+        return uint32_t(uint8_t(s[at])) | uint32_t(uint8_t(s[at + 1])) << 8 |
+               uint32_t(uint8_t(s[at + 2])) << 16 | uint32_t(uint8_t(s[at + 3])) << 24;
+    }
+
+    std::vector<Frame> frames_;
+    uint64_t size_{0};
+};
+
+// The bytes a sampler reads. Plain files expose their whole mapping.
+// Compressed ones expose a decoded prefix that grows on demand, and decoded
+// windows anywhere in the file when they are seekable zstd.
+class SampleText {
+public:
+    struct Window {
+        std::string_view bytes;
+        size_t base;   // decoded offset of bytes[0]
+        bool to_end;   // bytes run to the end of the data
     };
-    double bonus = 0.0;
-    if (role == Role::DateTime) {
-        if (has({"datetime","timestamp","ts","date_time","date-time"})) bonus += 0.15;
+
+    SampleText(const std::string &path, MappedFile::Access access) : file_(path, access) {
+        const std::string_view raw = file_.view();
+        kind_ = compression_of(raw);
+        if (kind_ == Compression::None) {
+            prefix_ = raw;
+            complete_ = true;
+            return;
+        }
+        if (kind_ == Compression::Zstd) seek_ = std::make_unique<ZstdSeekTable>(raw);
+        stream_ = std::make_unique<DecodeStream>(raw, kind_);
+    }
+
+    Compression compression() const { return kind_; }
+
+    // Next line from `pos` (without its '\n' or "\r\n", as next_record()
+    // ends records), decoding further as needed; false at the end of the data.
+    bool line(size_t &pos, std::string_view &out) {
+        for (;;) {
+            if (pos >= prefix_.size() && complete_) return false;
+            size_t end = prefix_.find('\n', pos);
+            if (end == std::string_view::npos && !complete_) { grow(); continue; }
+            if (end == std::string_view::npos) end = prefix_.size();
+            out = prefix_.substr(pos, end - pos);
+            if (!out.empty() && out.back() == '\r') out.remove_suffix(1);
+            pos = end + 1;
+            return true;
+        }
     }
-    if (role == Role::Date) {
-        if (has({"date","day","ymd","mdy","dmy"})) bonus += 0.10;
+
+    // Stratified sampling needs size() and window().
+    bool random_access() const { return kind_ == Compression::None || (seek_ && seek_->valid()); }
+    uint64_t size() const { return kind_ == Compression::None ? prefix_.size() : seek_->size(); }
+
+    // At least [begin, begin + len) of the data, clipped at its end. Valid
+    // until the next call.
+    Window window(size_t begin, size_t len) {
+        if (kind_ == Compression::None) return {prefix_, 0, true};
+        const size_t base = static_cast<size_t>(seek_->read(file_.view(), begin, len, window_));
+        return {window_, base, base + window_.size() >= seek_->size()};
     }
-    if (role == Role::Time) {
-        if (has({"time","hour","minute","second"})) bonus += 0.10;
+
+private:
+    void grow() {
+        if (stream_->read(buf_, std::max<size_t>(64 * 1024, buf_.size())) == 0) complete_ = true;
+        prefix_ = buf_;
     }
-    // UTC hints
-    if (has({"utc","zulu","tz"})) bonus += 0.05;
-    return bonus;
-}
 
-// --- main detection ---------------------------------------------------------
+    MappedFile file_;
+    Compression kind_{Compression::None};
+    std::unique_ptr<DecodeStream> stream_;
+    std::unique_ptr<ZstdSeekTable> seek_;
+    std::string buf_, window_;
+    std::string_view prefix_;
+    bool complete_{false};
+};
 
-class Detector {
+// --- incremental scoring ----------------------------------------------------
+//
+// Per-column tallies for adaptive sampling. Every live format of every bank
+// is matched as rows arrive; review() prunes formats and decides when more
+// rows can no longer change which role/format leads the column, using Wilson
+// bounds on each hit rate plus the role's header prior. The tallies only
+// decide when to stop: the reported scores come from score_bank.
+
+class ColumnScorer {
 public:
-    struct Table {
-        char delim{','};
-        std::vector<std::string> headers;
-        std::vector<std::vector<std::string>> rows; // sampled rows
-    };
+    enum class State { Open, Decided, Dead };
+
+    explicit ColumnScorer(const std::string &header) {
+        for (size_t r = 0; r < kRoles; ++r) prior_[r] = header_prior(header, kRoleOf[r]);
+        live_.fill(true);
+    }
 
-    static Table read_csv_sample(const std::string &path, size_t max_rows=1000) {
-        std::ifstream in(path);
-        if (!in) throw std::runtime_error("Cannot open file: " + path);
-        std::string headerLine;
-        if (!std::getline(in, headerLine)) throw std::runtime_error("Empty file: " + path);
-        char delim = sniff_delimiter(headerLine);
-        auto headers = split_csv_line(headerLine, delim);
-
-        std::vector<std::vector<std::string>> rows;
-        rows.reserve(max_rows);
-        std::string line;
-        while (rows.size() < max_rows && std::getline(in, line)) {
-            if (line.empty()) continue;
-            rows.push_back(split_csv_line(line, delim));
-            // Normalize row length by padding or trimming
-            if (rows.back().size() < headers.size()) rows.back().resize(headers.size());
-            if (rows.back().size() > headers.size()) rows.back().resize(headers.size());
+    void feed(std::string_view cell) {
+        ++rows_;
+        const ValueScan x = scan_value(cell);
+        if (!x.value.empty()) {
+            ++scanned_;
+            if (is_epoch_seconds(x)) ++sec_;
+            else if (is_epoch_millis(x)) ++ms_;
+        }
+        const std::string_view s = trim_view(cell);
+        if (s.empty()) return;
+        ++nonEmpty_;
+        for (size_t i = 0; i < kFormats; ++i) {
+            if (!live_[i]) continue;
+            DateTimeFields f;
+            if (!try_get_time(i >= kIsoBegin ? x.iso_core : s, format_at(i), &f)) continue;
+            ++hits_[i];
+            const uint64_t packed = (uint64_t(f.year) << 40) ^ (uint64_t(f.month) << 32) ^ (uint64_t(f.day) << 24) ^
+                                    (uint64_t(f.hour) << 16) ^ (uint64_t(f.minute) << 8) ^ uint64_t(f.second);
+            sig_[i] = (sig_[i] ^ packed) * 0x100000001b3ULL;
         }
-        return Table{delim, headers, rows};
     }
 
-    static DetectionResult detect(const Table &t) {
-        const std::vector<std::string> &hdrs = t.headers;
-        const auto &rows = t.rows;
-        const size_t cols = hdrs.size();
+    State review(size_t min_rows, size_t tie_rows, double z) {
+        if (nonEmpty_ < min_rows) return rows_ >= tie_rows ? State::Dead : State::Open;
 
-        auto column_samples = [&](size_t c)->std::vector<std::string>{
-            std::vector<std::string> v; v.reserve(rows.size());
-            for (auto &r: rows) if (c < r.size()) v.push_back(r[c]);
-            return v;
-        };
+        // One candidate per role: its leading format (first maximum, as the
+        // banks pick) and its bound in rate+prior space.
+        struct Cand { size_t hits, n, fmt; uint64_t sig; double prior, thresh; };
+        std::array<Cand, kRoles> roles;
+        for (size_t r = 0; r < kFormatRoles; ++r) {
+            size_t best = kRoleRange[r][0];
+            for (size_t i = best; i < kRoleRange[r][1]; ++i) if (hits_[i] > hits_[best]) best = i;
+            roles[r] = {hits_[best], nonEmpty_, best, sig_[best], prior_[r], kRoleThresh[r]};
+        }
+        roles[3] = {sec_, scanned_, kFormats, 1, prior_[3], kRoleThresh[3]};
+        roles[4] = {ms_,  scanned_, kFormats, 2, prior_[4], kRoleThresh[4]};
 
-        // Candidate format banks
-        const std::vector<std::string> date_formats = {
-            "%Y-%m-%d", "%Y/%m/%d", "%m/%d/%Y", "%d/%m/%Y", "%d.%m.%Y",
-            "%d-%b-%Y", "%b %d, %Y", "%Y%m%d"
-        };
-        const std::vector<std::string> time_formats = {
-            "%H:%M:%S", "%H:%M", "%I:%M:%S %p", "%I:%M %p", "%H%M%S", "%H%M"
-        };
-        // Some common datetime mixes (we also try ISO-ish via normalization)
-        const std::vector<std::string> datetime_formats = {
-            "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M",
-            "%m/%d/%Y %H:%M:%S", "%m/%d/%Y %H:%M",
-            "%d/%m/%Y %H:%M:%S", "%d/%m/%Y %H:%M",
-            "%Y/%m/%d %H:%M:%S", "%Y/%m/%d %H:%M",
-            "%d-%b-%Y %H:%M:%S", "%d-%b-%Y %H:%M",
-            "%Y%m%d %H%M%S", "%Y-%m-%d_%H-%M-%S"
-        };
-        // ISO-like (we normalize then try)
-        const std::vector<std::string> iso_like = {
-            "%Y-%m-%dT%H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M"
-        };
+        auto upper = [&](const Cand &c){ return wilson(c.hits, c.n, z, +1) + c.prior; };
+        auto lower = [&](const Cand &c){ return wilson(c.hits, c.n, z, -1) + c.prior; };
+        auto rate  = [&](const Cand &c){ return (c.n ? double(c.hits) / c.n : 0.0) + c.prior; };
 
-        std::vector<DetectedColumn> detected;
-        detected.reserve(cols);
-
-        for (size_t c=0;c<cols;++c) {
-            auto samples = column_samples(c);
-            // Pre-trim samples for epoch detection
-            size_t nonEmpty=0, secHits=0, msHits=0;
-            for (auto &s : samples) {
-                std::string x = trim(s);
-                if (x.empty()) continue;
-                ++nonEmpty;
-                if (is_epoch_seconds(x)) ++secHits;
-                else if (is_epoch_millis(x)) ++msHits;
-            }
+        // Formats that cannot reach their role's threshold stop being matched;
+        // their counts freeze, which keeps them below the leader.
+        for (size_t r = 0; r < kFormatRoles; ++r)
+            for (size_t i = kRoleRange[r][0]; i < kRoleRange[r][1]; ++i)
+                if (live_[i] && wilson(hits_[i], nonEmpty_, z, +1) + prior_[r] < kRoleThresh[r]) live_[i] = false;
 
-            double epochScoreSec = nonEmpty? double(secHits)/nonEmpty : 0.0;
-            double epochScoreMs  = nonEmpty? double(msHits)/nonEmpty : 0.0;
-
-            // Try date/time/datetime banks
-            auto [bestDateFmt, dateScore] = best_format_for(samples, date_formats, false);
-            auto [bestTimeFmt, timeScore] = best_format_for(samples, time_formats, false);
-            auto [bestDTFmt,  dtScore1]  = best_format_for(samples, datetime_formats, false);
-            auto [bestIsoFmt, dtScore2]  = best_format_for(samples, iso_like, true);
-
-            double dtScore = std::max(dtScore1, dtScore2);
-            std::string dtFmt = (dtScore1 >= dtScore2) ? bestDTFmt : bestIsoFmt;
-
-            // Decide role
-            Role role = Role::Unknown;
-            std::string fmt;
-            double score = 0.0;
-
-            // Start with the best-scoring of the four “modes”
-            struct Cand { Role role; std::string fmt; double score; };
-            std::vector<Cand> cands;
-            cands.push_back({Role::DateTime, dtFmt, dtScore});
-            cands.push_back({Role::Date,     bestDateFmt, dateScore});
-            cands.push_back({Role::Time,     bestTimeFmt, timeScore});
-            cands.push_back({Role::EpochSeconds, "", epochScoreSec});
-            cands.push_back({Role::EpochMillis,  "", epochScoreMs});
-
-            // Add header prior bonus
-            for (auto &cd : cands) {
-                cd.score += header_prior(hdrs[c], cd.role);
+        bool reachable = false;
+        for (auto &c : roles) reachable = reachable || upper(c) >= c.thresh;
+        if (!reachable) return State::Dead;
+
+        size_t lead = 0;
+        for (size_t r = 1; r < kRoles; ++r) if (rate(roles[r]) > rate(roles[lead])) lead = r;
+        const Cand &L = roles[lead];
+        const double floor = lower(L);
+        if (floor < L.thresh) return State::Open;
+        if (nonEmpty_ >= tie_rows) return State::Decided;
+
+        auto settled = [&](const Cand &c){
+            return upper(c) < floor || (c.hits == L.hits && c.n == L.n && c.sig == L.sig);
+        };
+        for (size_t r = 0; r < kRoles; ++r) if (r != lead && !settled(roles[r])) return State::Open;
+        if (lead < kFormatRoles) {
+            for (size_t i = kRoleRange[lead][0]; i < kRoleRange[lead][1]; ++i) {
+                if (i == L.fmt) continue;
+                if (!settled(Cand{hits_[i], nonEmpty_, i, sig_[i], L.prior, L.thresh})) return State::Open;
             }
-            auto best = std::max_element(cands.begin(), cands.end(),
-                [](const Cand&a, const Cand&b){ return a.score < b.score; });
+        }
+        return State::Decided;
+    }
+
+private:
+    static constexpr size_t kTimeBegin     = kDateFormats.size();
+    static constexpr size_t kDateTimeBegin = kTimeBegin + kTimeFormats.size();
+    static constexpr size_t kIsoBegin      = kDateTimeBegin + kDateTimeFormats.size();
+    static constexpr size_t kFormats       = kIsoBegin + kIsoLikeFormats.size();
+
+    // Roles in the order detect() lists its candidates; the first three are
+    // backed by format ranges, DateTime spanning both the DateTime and
+    // IsoLike banks.
+    static constexpr size_t kRoles = 5, kFormatRoles = 3;
+    static constexpr Role kRoleOf[kRoles] = { Role::DateTime, Role::Date, Role::Time, Role::EpochSeconds, Role::EpochMillis };
+    static constexpr double kRoleThresh[kRoles] = { 0.70, 0.60, 0.60, 0.70, 0.70 };
+    static constexpr size_t kRoleRange[kFormatRoles][2] = {
+        { kDateTimeBegin, kFormats }, { 0, kTimeBegin }, { kTimeBegin, kDateTimeBegin } };
+
+    static const CompiledFormat &format_at(size_t i) {
+        if (i < kTimeBegin)     return kDateFormats[i];
+        if (i < kDateTimeBegin) return kTimeFormats[i - kTimeBegin];
+        if (i < kIsoBegin)      return kDateTimeFormats[i - kDateTimeBegin];
+        return kIsoLikeFormats[i - kIsoBegin];
+    }
+
+    static double wilson(size_t hits, size_t n, double z, int side) {
+        if (n == 0) return side > 0 ? 1.0 : 0.0;
+        const double p = double(hits) / n, z2 = z * z;
+        const double centre = p + z2 / (2 * n);
+        const double spread = z * std::sqrt(p * (1 - p) / n + z2 / (4.0 * n * n));
+        return (centre + side * spread) / (1 + z2 / n);
+    }
+
+    size_t rows_{0}, nonEmpty_{0}, scanned_{0}, sec_{0}, ms_{0};
+    std::array<size_t, kFormats> hits_{};
+    std::array<uint64_t, kFormats> sig_{};
+    std::array<bool, kFormats> live_{};
+    double prior_[kRoles]{};
+};
+
+// --- main detection ---------------------------------------------------------
 
-            role  = best->role;
-            fmt   = best->fmt;
-            score = std::min(best->score, 1.0); // cap
+// Role and final mapping from per-(column, bank) scores.
+static DetectionResult decide(const std::vector<std::string> &hdrs, char delim,
+                              const std::vector<BankScore> &scores, const std::vector<ValueProfile> &types) {
+    hps::Scope s(stats::kDecide);
+    const size_t cols = hdrs.size();
+    const size_t banks = static_cast<size_t>(Bank::Count);
 
-            detected.push_back(DetectedColumn{c, role, fmt, score, hdrs[c]});
+    std::vector<DetectedColumn> detected;
+    detected.reserve(cols);
+
+    for (size_t c=0;c<cols;++c) {
+        const BankScore *bs = &scores[c * banks];
+        const BankScore &epoch = bs[size_t(Bank::Epoch)];
+        const BankScore &date  = bs[size_t(Bank::Date)];
+        const BankScore &time  = bs[size_t(Bank::Time)];
+        const BankScore &dt    = bs[size_t(Bank::DateTime)];
+        const BankScore &iso   = bs[size_t(Bank::IsoLike)];
+
+        double dtScore = std::max(dt.score, iso.score);
+        std::string dtFmt(dt.score >= iso.score ? dt.fmt : iso.fmt);
+
+        // Decide role
+        Role role = Role::Unknown;
+        std::string fmt;
+        double score = 0.0;
+
+        // Start with the best-scoring of the four “modes”
+        struct Cand { Role role; std::string fmt; double score; };
+        std::vector<Cand> cands;
+        cands.push_back({Role::DateTime, dtFmt, dtScore});
+        cands.push_back({Role::Date,     std::string(date.fmt), date.score});
+        cands.push_back({Role::Time,     std::string(time.fmt), time.score});
+        cands.push_back({Role::EpochSeconds, "", epoch.score});
+        cands.push_back({Role::EpochMillis,  "", epoch.score_ms});
+
+        // Add header prior bonus
+        for (auto &cd : cands) {
+            cd.score += header_prior(hdrs[c], cd.role);
         }
+        auto best = std::max_element(cands.begin(), cands.end(),
+            [](const Cand&a, const Cand&b){ return a.score < b.score; });
 
-        // Decide final mapping:
-        DetectionResult res;
-        res.delimiter = t.delim;
-        res.all_columns = detected;
-
-        // Prefer a single strong DateTime / Epoch column
-        auto pick_dt = [&](Role r)->std::optional<DetectedColumn>{
-            const double THRESH = 0.70;
-            DetectedColumn best{};
-            bool found=false;
-            for (auto &d: detected) {
-                if (d.role == r && d.confidence >= THRESH) {
-                    if (!found || d.confidence > best.confidence) { best = d; found = true; }
-                }
-            }
-            if (found) return best;
-            return std::nullopt;
-        };
+        role  = best->role;
+        fmt   = best->fmt;
+        score = std::min(best->score, 1.0); // cap
+
+        detected.push_back(DetectedColumn{c, role, fmt, score, hdrs[c], types[c].type, types[c].sentinel});
+    }
 
-        if (auto msec = pick_dt(Role::EpochMillis)) { res.datetime_col = msec; return res; }
-        if (auto sec  = pick_dt(Role::EpochSeconds)) { res.datetime_col = sec; return res; }
-        if (auto dt   = pick_dt(Role::DateTime)) { res.datetime_col = dt; return res; }
+    // Decide final mapping:
+    DetectionResult res;
+    res.delimiter = delim;
+    res.all_columns = detected;
 
-        // Otherwise, try separate Date + Time with decent scores
-        DetectedColumn bestDate{}, bestTime{};
-        bool haveDate=false, haveTime=false;
+    // Prefer a single strong DateTime / Epoch column
+    auto pick_dt = [&](Role r)->std::optional<DetectedColumn>{
+        const double THRESH = 0.70;
+        DetectedColumn best{};
+        bool found=false;
         for (auto &d: detected) {
-            if (d.role==Role::Date && d.confidence>=0.60) {
-                if (!haveDate || d.confidence > bestDate.confidence) { bestDate = d; haveDate = true; }
-            }
-            if (d.role==Role::Time && d.confidence>=0.60) {
-                if (!haveTime || d.confidence > bestTime.confidence) { bestTime = d; haveTime = true; }
+            if (d.role == r && d.confidence >= THRESH) {
+                if (!found || d.confidence > best.confidence) { best = d; found = true; }
             }
         }
-        if (haveDate && haveTime) {
-            res.date_col = bestDate;
-            res.time_col = bestTime;
-            return res;
-        }
+        if (found) return best;
+        return std::nullopt;
+    };
 
-        // As a fallback, expose whatever had the highest score among all roles.
-        auto overall = std::max_element(detected.begin(), detected.end(),
-            [](const DetectedColumn&a, const DetectedColumn&b){ return a.confidence < b.confidence; });
+    if (auto msec = pick_dt(Role::EpochMillis)) { res.datetime_col = msec; return res; }
+    if (auto sec  = pick_dt(Role::EpochSeconds)) { res.datetime_col = sec; return res; }
+    if (auto dt   = pick_dt(Role::DateTime)) { res.datetime_col = dt; return res; }
 
-        if (overall != detected.end()) {
-            if (overall->role == Role::Date) res.date_col = *overall;
-            else if (overall->role == Role::Time) res.time_col = *overall;
-            else res.datetime_col = *overall;
+    // Otherwise, try separate Date + Time with decent scores
+    DetectedColumn bestDate{}, bestTime{};
+    bool haveDate=false, haveTime=false;
+    for (auto &d: detected) {
+        if (d.role==Role::Date && d.confidence>=0.60) {
+            if (!haveDate || d.confidence > bestDate.confidence) { bestDate = d; haveDate = true; }
+        }
+        if (d.role==Role::Time && d.confidence>=0.60) {
+            if (!haveTime || d.confidence > bestTime.confidence) { bestTime = d; haveTime = true; }
         }
+    }
+    if (haveDate && haveTime) {
+        res.date_col = bestDate;
+        res.time_col = bestTime;
         return res;
     }
-};
 
-} // namespace csvdt
+    // As a fallback, expose whatever had the highest score among all roles.
+    auto overall = std::max_element(detected.begin(), detected.end(),
+        [](const DetectedColumn&a, const DetectedColumn&b){ return a.confidence < b.confidence; });
+
+    if (overall != detected.end()) {
+        if (overall->role == Role::Date) res.date_col = *overall;
+        else if (overall->role == Role::Time) res.time_col = *overall;
+        else res.datetime_col = *overall;
+    }
+    return res;
+}
 
-// -------------------- demo usage --------------------
-#ifdef CSV_DT_DEMO_MAIN
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: smart_datetime_detector <csv-file> [max_rows]\n";
-        return 1;
+// Up to `n` non-blank records starting at `pos` (advanced past them).
+static size_t take_records(std::string_view data, size_t &pos, size_t n, CsvTokenizer &tok, TableBuilder &tb) {
+    size_t taken = 0;
+    while (taken < n && tok.next_record(data, pos)) {
+        const auto &f = tok.fields();
+        if (f.size() == 1 && f[0].empty()) continue;
+        tb.add_row(f);
+        ++taken;
     }
-    std::string path = argv[1];
-    size_t max_rows = (argc >= 3) ? static_cast<size_t>(std::stoul(argv[2])) : 1000;
+    return taken;
+}
 
-    try {
-        auto table = csvdt::Detector::read_csv_sample(path, max_rows);
-        auto res   = csvdt::Detector::detect(table);
+// First record start at or after `target`. A newline found from an
+// arbitrary offset may sit inside a quoted field, so a candidate is only
+// accepted when the next two records parse to the header's field count;
+// failing that within the window, the first line start is used.
+static size_t resync(std::string_view data, size_t target, size_t cols, CsvTokenizer &tok) {
+    constexpr size_t kWindow = 64 * 1024;
+    const size_t limit = std::min(data.size(), target + kWindow);
+    size_t first = std::string_view::npos;
+    for (size_t p = target; p < limit; ) {
+        const size_t nl = data.find('\n', p);
+        if (nl == std::string_view::npos || nl >= limit) break;
+        const size_t cand = nl + 1;
+        if (first == std::string_view::npos) first = cand;
+        size_t q = cand;
+        bool ok = true;
+        for (int k = 0; k < 2 && ok && tok.next_record(data, q); ++k)
+            ok = tok.fields().size() == cols;
+        if (ok) return cand;
+        p = cand;
+    }
+    return first == std::string_view::npos ? data.size() : first;
+}
 
-        std::cout << "Delimiter: '" << (res.delimiter=='\t' ? ' ' : res.delimiter) << "' (\\t shown as space)\n";
-        std::cout << "Headers:\n";
-        for (size_t i=0;i<table.headers.size();++i) {
-            std::cout << "  ["<<i<<"] " << table.headers[i] << "\n";
-        }
-        std::cout << "\nColumn roles (all):\n";
-        auto role_to_str = [](csvdt::Role r){
-            switch (r) {
-                case csvdt::Role::Date: return "Date";
-                case csvdt::Role::Time: return "Time";
-                case csvdt::Role::DateTime: return "DateTime";
-                case csvdt::Role::EpochSeconds: return "EpochSeconds";
-                case csvdt::Role::EpochMillis: return "EpochMillis";
-                default: return "Unknown";
+// Offsets are in decoded bytes. A plain file is one window over all of
+// it; on a seekable zstd file each block decodes just the frames it
+// touches, doubling the window until the block's records (and resync's
+// look-ahead) end inside it, so both give the same rows.
+static void sample_stratified(SampleText &text, size_t body, size_t cols, const Detector::SampleOptions &opt,
+                              CsvTokenizer &tok, TableBuilder &tb) {
+    const size_t size = static_cast<size_t>(text.size());
+    const size_t blocks = std::max<size_t>(opt.blocks, 2);
+    const size_t per = std::max<size_t>(1, opt.max_rows / blocks);
+
+    // Up to n records from `at` (from the record start at or after it when
+    // `sync`); returns the offset after them.
+    auto take = [&](size_t at, bool sync, size_t n, size_t *taken) {
+        for (size_t len = 256 * 1024;; len *= 2) {
+            const SampleText::Window w = text.window(at, len);
+            const std::string_view data = w.bytes;
+            size_t pos = at - w.base;
+            if (sync) {
+                if (!w.to_end && pos + 2 * 64 * 1024 > data.size()) continue;
+                pos = resync(data, pos, cols, tok);
             }
-        };
-        for (auto &d : res.all_columns) {
-            std::cout << "  ["<<d.index<<"] header='"<<d.header<<"' role="<<role_to_str(d.role)
-                      << " conf="<<std::fixed<<std::setprecision(2)<<d.confidence
-                      << (d.format.empty() ? "" : (" fmt='" + d.format + "'"))
-                      << "\n";
+            size_t end = pos, k = 0;
+            while (k < n && tok.next_record(data, end)) {
+                const auto &f = tok.fields();
+                if (!(f.size() == 1 && f[0].empty())) ++k;
+            }
+            if (!w.to_end && end >= data.size()) continue; // last record may run past the window
+            const size_t got = take_records(data, pos, n, tok, tb);
+            if (taken) *taken = got;
+            return w.base + pos;
         }
+    };
 
-        std::cout << "\nBest mapping:\n";
-        if (res.datetime_col) {
-            auto &d = *res.datetime_col;
-            std::cout << "  DateTime column: #" << d.index << " ('" << d.header << "')";
-            if (d.role==csvdt::Role::EpochSeconds || d.role==csvdt::Role::EpochMillis) {
-                std::cout << " [epoch]\n";
-            } else {
-                std::cout << " fmt='" << d.format << "'\n";
-            }
+    size_t headRows = 0;
+    size_t pos = take(body, false, per, &headRows);
+    const double avgRow = headRows ? double(pos - body) / double(headRows) : 256.0;
+
+    // Blocks that would start inside what was already read continue from there.
+    for (size_t b = 1; b + 1 < blocks && tb.rows() < opt.max_rows; ++b) {
+        const size_t target = body + (size - body) / (blocks - 1) * b;
+        pos = take(std::max(target, pos), target > pos, std::min(per, opt.max_rows - tb.rows()), nullptr);
+    }
+
+    // Tail: start far enough back for the remaining rows, keep the last ones.
+    const size_t want = opt.max_rows - tb.rows();
+    if (want == 0 || pos >= size) return;
+    const size_t back = static_cast<size_t>(avgRow * 2.0 * double(want)) + 4096;
+    const bool skip = size - pos > back;
+    const size_t from = skip ? size - back : pos;
+    const SampleText::Window w = text.window(from, size - from);
+    const std::string_view data = w.bytes;
+    pos = skip ? resync(data, from - w.base, cols, tok) : pos - w.base;
+    std::vector<size_t> starts;
+    for (size_t p = pos; p < data.size(); ) {
+        const size_t start = p;
+        tok.next_record(data, p);
+        const auto &f = tok.fields();
+        if (!(f.size() == 1 && f[0].empty())) starts.push_back(start);
+    }
+    pos = starts.size() > want ? starts[starts.size() - want] : pos;
+    take_records(data, pos, want, tok, tb);
+}
+
+Detector::Table Detector::read_csv_sample(const std::string &path, size_t max_rows) {
+    SampleOptions opt;
+    opt.max_rows = max_rows;
+    return read_csv_sample(path, opt);
+}
+
+Detector::Table Detector::read_csv_sample(const std::string &path, const SampleOptions &opt) {
+    std::unique_ptr<SampleText> text;
+    {
+        hps::Scope s(stats::kMap);
+        text = std::make_unique<SampleText>(path, opt.mode == SampleMode::Head ? MappedFile::Access::Sequential
+                                                                               : MappedFile::Access::Random);
+    }
+    size_t body = 0;
+    std::string_view headerLine;
+    if (!text->line(body, headerLine)) throw std::runtime_error("Empty file: " + path);
+    char delim = sniff_delimiter(std::string(headerLine));
+    auto headers = split_csv_line(std::string(headerLine), delim);
+
+    hps::Scope s(stats::kTokenize);
+    CsvTokenizer tok(delim);
+    TableBuilder tb(headers.size(), opt.max_rows);
+    if (opt.mode == SampleMode::Head || !text->random_access()) {
+        // Line by line, like the getline loop this replaces.
+        size_t pos = body;
+        std::string_view line;
+        while (tb.rows() < opt.max_rows && text->line(pos, line)) {
+            if (!line.empty()) tb.add_row(tok.split_line(line));
+        }
+    } else {
+        sample_stratified(*text, std::min<size_t>(body, text->size()), headers.size(), opt, tok, tb);
+    }
+    return tb.finish(delim, std::move(headers));
+}
+
+DetectionResult Detector::detect(const Table &t, unsigned threads) {
+    const std::vector<std::string> &hdrs = t.headers;
+    const size_t cols = hdrs.size();
+    const size_t banks = static_cast<size_t>(Bank::Count);
+
+    std::vector<BankScore> scores(cols * banks);
+    std::vector<ValueProfile> types(cols);
+    auto score_one = [&](size_t i){
+        if (i >= scores.size()) {
+            hps::Scope s(stats::kTypes);
+            const size_t c = i - scores.size();
+            ValueTyper typer;
+            const ColumnView col = t.column(c);
+            for (size_t r = 0; r < col.size(); ++r) typer.feed(col[r]);
+            types[c] = typer.result();
+            return;
+        }
+        hps::Scope s(stats::kScore[i % banks]);
+        scores[i] = score_bank(t.column(i / banks), static_cast<Bank>(i % banks));
+    };
+    if (threads == 1) {
+        for (size_t i = 0; i < scores.size() + cols; ++i) score_one(i);
+    } else {
+        ThreadPool::shared(threads).parallel_for(scores.size() + cols, score_one);
+    }
+
+    return decide(hdrs, t.delim, scores, types);
+}
+
+DetectionResult Detector::detect_adaptive(const std::string &path, const AdaptiveOptions &opt, size_t *rows_read) {
+    hps::Scope s(stats::kAdaptive);
+    SampleText text(path, MappedFile::Access::Sequential);
+    size_t pos = 0;
+    std::string_view headerLine;
+    if (!text.line(pos, headerLine)) throw std::runtime_error("Empty file: " + path);
+    char delim = sniff_delimiter(std::string(headerLine));
+    const auto headers = split_csv_line(std::string(headerLine), delim);
+    const size_t cols = headers.size();
+
+    std::vector<ColumnScorer> scorers;
+    scorers.reserve(cols);
+    for (auto &h : headers) scorers.emplace_back(h);
+    std::vector<ValueTyper> typers(cols);
+    std::vector<size_t> open(cols);
+    for (size_t c = 0; c < cols; ++c) open[c] = c;
+
+    CsvTokenizer tok(delim);
+    TableBuilder tb(cols, opt.max_rows);
+    size_t rows = 0;
+    std::string_view line;
+    while (rows < opt.max_rows && (!open.empty() || opt.full_typing) && text.line(pos, line)) {
+        if (line.empty()) continue;
+        const auto &f = tok.split_line(line);
+        for (size_t c = 0; c < cols; ++c) typers[c].feed(c < f.size() ? f[c] : std::string_view{});
+        ++rows;
+        if (open.empty()) continue;  // scoring done; full_typing reads on
+        tb.add_row(f);
+        for (size_t c : open) scorers[c].feed(c < f.size() ? f[c] : std::string_view{});
+        if (rows % opt.batch_rows == 0) {
+            open.erase(std::remove_if(open.begin(), open.end(), [&](size_t c){
+                return scorers[c].review(opt.min_rows, opt.tie_rows, opt.z) != ColumnScorer::State::Open;
+            }), open.end());
+        }
+    }
+    if (rows_read) *rows_read = rows;
+
+    const Table t = tb.finish(delim, headers);
+    const size_t banks = static_cast<size_t>(Bank::Count);
+    std::vector<BankScore> scores(cols * banks);
+    for (size_t i = 0; i < scores.size(); ++i) {
+        hps::Scope s(stats::kScore[i % banks]);
+        scores[i] = score_bank(t.column(i / banks), static_cast<Bank>(i % banks));
+    }
+    std::vector<ValueProfile> types(cols);
+    for (size_t c = 0; c < cols; ++c) types[c] = typers[c].result();
+    return decide(headers, delim, scores, types);
+}
+
+// --- full-file timestamp extraction ----------------------------------------
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm).
+static constexpr int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// Pattern text -> compiled matcher. Built-in patterns resolve to the
+// constexpr banks; anything else is compiled here (text is not kept, the
+// caller owns the string).
+static CompiledFormat resolve_format(std::string_view fmt) {
+    for (auto &cf : kDateTimeFormats) if (cf.text == fmt) return cf;
+    for (auto &cf : kIsoLikeFormats)  if (cf.text == fmt) return cf;
+    for (auto &cf : kDateFormats)     if (cf.text == fmt) return cf;
+    for (auto &cf : kTimeFormats)     if (cf.text == fmt) return cf;
+    CompiledFormat cf = compile_format(fmt);
+    cf.text = {};
+    return cf;
+}
+
+static inline bool parse_uint64(std::string_view s, uint64_t &out) {
+    if (s.empty() || s.size() > 19) return false;
+    uint64_t v = 0;
+    for (char c : s) {
+        if (!is_digit_c(c)) return false;
+        v = v * 10 + static_cast<uint64_t>(c - '0');
+    }
+    out = v;
+    return true;
+}
+
+// The date's day plus the time of day, at the value's offset (or
+// assume_offset minutes east of UTC without one).
+static int64_t to_epoch_ns(const DateTimeFields &date, const DateTimeFields &time, const ValueScan &v, int assume_offset) {
+    if (date.day < 1) return TimestampExtractor::kInvalid; // pattern without a day (e.g. a time-only format)
+    const int64_t days = days_from_civil(date.year, static_cast<unsigned>(date.month), static_cast<unsigned>(date.day));
+    const int offset = v.has_offset ? v.offset_minutes : assume_offset;
+    const int64_t secs = days * 86400 + time.hour * 3600 + time.minute * 60 + time.second - int64_t(offset) * 60;
+    return secs * 1000000000 + v.frac_nanos;
+}
+
+TimestampExtractor::TimestampExtractor(const DetectionResult &det, Options opt) : delim_(det.delimiter), opt_(opt) {
+    if (det.datetime_col) {
+        const auto &c = *det.datetime_col;
+        primary_ = c.index;
+        switch (c.role) {
+            case Role::EpochSeconds: mode_ = Mode::EpochSeconds; break;
+            case Role::EpochMillis:  mode_ = Mode::EpochMillis; break;
+            case Role::DateTime:     mode_ = Mode::DateTime; primary_fmt_ = resolve_format(c.format); break;
+            default: throw std::runtime_error("No usable timestamp column in detection result");
+        }
+    } else if (det.date_col) {
+        primary_ = det.date_col->index;
+        primary_fmt_ = resolve_format(det.date_col->format);
+        if (det.time_col) {
+            mode_ = Mode::DateAndTime;
+            secondary_ = det.time_col->index;
+            secondary_fmt_ = resolve_format(det.time_col->format);
         } else {
-            if (res.date_col) {
-                auto &d = *res.date_col;
-                std::cout << "  Date column:    #" << d.index << " ('" << d.header << "') fmt='" << d.format << "'\n";
-            }
-            if (res.time_col) {
-                auto &d = *res.time_col;
-                std::cout << "  Time column:    #" << d.index << " ('" << d.header << "') fmt='" << d.format << "'\n";
-            }
-            if (!res.date_col && !res.time_col) {
-                std::cout << "  (No confident date/time mapping found.)\n";
-            }
+            mode_ = Mode::DateOnly;
         }
-    } catch (const std::exception &e) {
-        std::cerr << "Error: " << e.what() << "\n";
-        return 2;
+    } else {
+        throw std::runtime_error("No usable timestamp column in detection result");
     }
-    return 0;
+    needed_ = std::max(primary_, mode_ == Mode::DateAndTime ? secondary_ : primary_) + 1;
 }
-#endif
+
+std::vector<int64_t> TimestampExtractor::extract(const std::string &path) const {
+    MappedFile file(path, MappedFile::Access::Sequential);
+    const std::string_view raw = file.view();
+    const Compression kind = compression_of(raw);
+    if (kind == Compression::None) return extract(raw);
+
+    constexpr size_t kPiece = 64u << 20;
+    DecodeStream in(raw, kind);
+    ThreadPool &pool = ThreadPool::shared(opt_.threads);
+    std::vector<int64_t> ts;
+    std::string buf;
+    bool header = true, more = true;
+    while (more) {
+        more = in.read(buf, kPiece) != 0;
+        const std::string_view data = buf;
+        const size_t end = more ? complete_prefix(data) : data.size();
+        size_t body = 0;
+        if (header && end) {
+            CsvTokenizer tok(delim_);
+            tok.next_record(data.substr(0, end), body);
+            header = false;
+        }
+        if (end > body) extract_range(data, body, end, pool, ts);
+        buf.erase(0, end);
+    }
+    return ts;
+}
+
+std::vector<int64_t> TimestampExtractor::extract(std::string_view data) const {
+    CsvTokenizer tok(delim_);
+    size_t body = 0;
+    tok.next_record(data, body); // header
+
+    std::vector<int64_t> ts;
+    extract_range(data, body, data.size(), ThreadPool::shared(opt_.threads), ts);
+    return ts;
+}
+
+void TimestampExtractor::extract_range(std::string_view data, size_t begin, size_t end, ThreadPool &pool,
+                                       std::vector<int64_t> &ts) const {
+    const size_t bytes = end - begin;
+    const size_t parts = std::max<size_t>(1, std::min<size_t>(size_t(pool.size()) * 4,
+                                                              bytes / std::max<size_t>(1, opt_.min_chunk_bytes)));
+    const auto cuts = split_record_aligned(data, begin, end, parts, pool);
+    const size_t chunks = cuts.size() - 1;
+
+    std::vector<std::vector<int64_t>> partial(chunks);
+    pool.parallel_for(chunks, [&](size_t i){
+        hps::Scope s(stats::kExtract);
+        std::string_view block = data.substr(0, cuts[i+1]);
+        auto &out = partial[i];
+        out.reserve((cuts[i+1] - cuts[i]) / 32);
+        CsvTokenizer t(delim_);
+        size_t pos = cuts[i];
+        while (t.next_record(block, pos)) {
+            const auto &f = t.fields();
+            if (f.size() == 1 && f[0].empty()) continue; // blank line
+            out.push_back(convert(f));
+        }
+    });
+
+    std::vector<size_t> offset(chunks + 1, ts.size());
+    for (size_t i = 0; i < chunks; ++i) offset[i+1] = offset[i] + partial[i].size();
+    ts.resize(offset[chunks]);
+    pool.parallel_for(chunks, [&](size_t i){
+        std::copy(partial[i].begin(), partial[i].end(), ts.begin() + static_cast<std::ptrdiff_t>(offset[i]));
+        std::vector<int64_t>().swap(partial[i]);
+    });
+}
+
+int64_t TimestampExtractor::convert(const std::vector<std::string_view> &fields) const {
+    if (fields.size() < needed_) return kInvalid;
+    switch (mode_) {
+        case Mode::EpochSeconds: {
+            const ValueScan v = scan_value(fields[primary_]);
+            uint64_t s;
+            if (!parse_uint64(v.iso_core, s) || v.has_offset) return kInvalid;
+            return static_cast<int64_t>(s) * 1000000000 + v.frac_nanos;
+        }
+        case Mode::EpochMillis: {
+            uint64_t ms;
+            if (!parse_uint64(trim_view(fields[primary_]), ms)) return kInvalid;
+            return static_cast<int64_t>(ms) * 1000000;
+        }
+        case Mode::DateTime: {
+            DateTimeFields f;
+            const ValueScan v = scan_value(fields[primary_]);
+            if (!try_get_time(v.iso_core, primary_fmt_, &f, true) && !try_get_time(v.value, primary_fmt_, &f, true))
+                return kInvalid;
+            return to_epoch_ns(f, f, v, opt_.assume_utc_offset_minutes);
+        }
+        case Mode::DateAndTime: {
+            DateTimeFields d, t;
+            if (!try_get_time(trim_view(fields[primary_]), primary_fmt_, &d, true)) return kInvalid;
+            const ValueScan v = scan_value(fields[secondary_]);
+            if (!try_get_time(v.iso_core, secondary_fmt_, &t, true) && !try_get_time(v.value, secondary_fmt_, &t, true))
+                return kInvalid;
+            return to_epoch_ns(d, t, v, opt_.assume_utc_offset_minutes);
+        }
+        case Mode::DateOnly: {
+            DateTimeFields d;
+            if (!try_get_time(trim_view(fields[primary_]), primary_fmt_, &d, true)) return kInvalid;
+            return to_epoch_ns(d, DateTimeFields{}, ValueScan{}, opt_.assume_utc_offset_minutes);
+        }
+    }
+    return kInvalid;
+}
+
+} // namespace csvdt
@@ -0,0 +1,793 @@
+#pragma once
+// column_detector.h
+// csvdt: inferring CSV date/time columns & formats, and the log tooling built
+// on the result (full-file timestamp extraction, result cache, schema reuse,
+// tail follow, time index, time alignment, columnar cache). C++17.
+//
+// This is the public API; it pulls in no platform, SIMD or codec headers.
+// The building blocks the sources share (tokenizer, compiled formats, value
+// scanning, thread pool, file mapping) are in column_detector_p.h, which is
+// not part of it. Sources:
+//   column_detector.cpp           detection, extraction, file access, codecs
+//   column_detector_cache.cpp     ResultCache, SchemaRegistry
+//   column_detector_follow.cpp    LogFollower
+//   column_detector_index.cpp     TimeIndex, ColumnarCache
+//   column_detector_align.cpp     time sources, TimeAligner
+//   column_detector_main.cpp      demo (-DCSV_DT_DEMO_MAIN) and tokenizer
+//                                 microbenchmark (-DCSV_DT_BENCH_MAIN)
+//
+//   g++ -std=c++17 -O2 -pthread -DCSV_DT_DEMO_MAIN column_detector*.cpp -o csvdt_demo
+//
+// Compressed input is opt-in (see DecodeStream): -DCSVDT_WITH_ZLIB ... -lz,
+// -DCSVDT_WITH_ZSTD ... -lzstd, on column_detector.cpp.
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace csvdt {
+
+enum class Role { Unknown, Date, Time, DateTime, EpochSeconds, EpochMillis };
+
+// Type of a column's values (see ValueTyper), independent of its Role.
+enum class ValueType : uint8_t { Text, Int, Float, Bool, Categorical };
+
+struct DetectedColumn {
+    size_t index{};
+    Role role{Role::Unknown};
+    std::string format;     // strptime/get_time-compatible format (empty for epoch)
+    double confidence{0.0}; // 0..1 based on sample parse rate (+header boost)
+    std::string header;
+    ValueType value_type{ValueType::Text};
+    std::optional<double> sentinel; // numeric code standing for missing data
+};
+
+struct DetectionResult {
+    // Either: datetime_col has value; or: date_col and time_col have values
+    std::optional<DetectedColumn> datetime_col;
+    std::optional<DetectedColumn> date_col;
+    std::optional<DetectedColumn> time_col;
+    char delimiter{','};
+    std::vector<DetectedColumn> all_columns; // for inspection/debug
+};
+
+class CsvTokenizer;
+class DecodeStream;
+class MappedFile;
+class ThreadPool;
+
+// One sampled column, read in place from the table's arena: its cells are
+// stored back to back, cell r spans [offsets[r], offsets[r+1]).
+struct ColumnView {
+    const char *arena{nullptr};
+    const uint32_t *offsets{nullptr}; // size()+1 entries
+    size_t rows{0};
+
+    size_t size() const { return rows; }
+    std::string_view operator[](size_t r) const {
+        return {arena + offsets[r], static_cast<size_t>(offsets[r+1] - offsets[r])};
+    }
+};
+
+// A strftime-style pattern compiled into a short op list (see
+// compile_format and try_get_time in column_detector_p.h).
+struct CompiledFormat {
+    enum Op : unsigned char { Lit, Space, Year, Month, Day, Hour, Hour12, Minute, Second, MonthName, AmPm };
+    struct Step { Op op{Lit}; char ch{}; };
+
+    std::string_view text;         // source pattern (what DetectedColumn::format reports)
+    std::array<Step, 24> steps{};
+    size_t count{0};
+    bool valid{true};              // false: unsupported directive, never matches
+};
+
+// Size and modification time of a file; sidecars and cached results are
+// trusted while it is unchanged.
+struct FileStamp {
+    uint64_t size{0};
+    int64_t mtime_ns{0};
+    bool operator==(const FileStamp &o) const { return size == o.size && mtime_ns == o.mtime_ns; }
+};
+
+// --- main detection ---------------------------------------------------------
+
+class Detector {
+public:
+    // Sampled cells in columnar form: one byte arena holding every cell of
+    // column 0, then column 1, ..., and one offset array with rows()+1
+    // entries per column. Rows are padded/trimmed to the header width.
+    struct Table {
+        char delim{','};
+        std::vector<std::string> headers;
+        std::string arena;
+        std::vector<uint32_t> offsets; // column c starts at c * (rows() + 1)
+        size_t row_count{0};
+
+        size_t rows() const { return row_count; }
+        size_t cols() const { return headers.size(); }
+        ColumnView column(size_t c) const {
+            return {arena.data(), offsets.data() + c * (row_count + 1), row_count};
+        }
+        std::string_view cell(size_t r, size_t c) const { return column(c)[r]; }
+    };
+
+    enum class SampleMode {
+        Head,       // the first max_rows data lines
+        Stratified  // row blocks from the head, evenly spaced middle offsets and the tail
+    };
+
+    struct SampleOptions {
+        size_t max_rows{1000};
+        SampleMode mode{SampleMode::Head};
+        size_t blocks{8};   // Stratified: number of row blocks (head and tail included)
+    };
+
+    static Table read_csv_sample(const std::string &path, size_t max_rows=1000);
+
+    // The file is memory-mapped, so only the pages under the sampled blocks
+    // are read, whatever the file size. gzip/zstd files are decoded only as
+    // far as the head sample needs; Stratified on them needs a seekable zstd
+    // file and falls back to Head otherwise.
+    static Table read_csv_sample(const std::string &path, const SampleOptions &opt);
+
+    // threads: 1 scores columns serially on the calling thread, 0 uses all
+    // hardware threads; the workers are a process-wide pool per thread
+    // count, started on first use and kept, so calling this per file costs
+    // no thread start-up. Every (column, bank) pair is scored independently,
+    // and every column typed, and the results are reduced in column order,
+    // so the result doesn't depend on the thread count.
+    static DetectionResult detect(const Table &t, unsigned threads=1);
+
+    struct AdaptiveOptions {
+        size_t max_rows{1000};   // never read more data lines than this
+        size_t min_rows{16};     // non-empty samples a column needs before it can be decided
+        size_t tie_rows{64};     // after this many, unresolved ties no longer hold a column open
+        size_t batch_rows{8};    // re-check the stopping rule every batch
+        double z{2.576};         // Wilson interval width (99%)
+        bool full_typing{false}; // read on to max_rows for value types and sentinels
+    };
+
+    // Head sampling with early stopping. Rows are scored as they are read;
+    // formats that can no longer reach the 0.70/0.60 thresholds are pruned,
+    // columns that cannot become temporal are dropped, and reading stops once
+    // every column's leading role/format clears its threshold with
+    // confidence and is separated from the alternatives (or only ties with
+    // formats that parsed every sample to the same fields).
+    //
+    // The incremental tallies only drive that stopping rule. The result is
+    // scored like detect() over the rows read, so it equals
+    // detect(read_csv_sample(path, *rows_read)), value types included. The
+    // mapping matches detect(read_csv_sample(path, max_rows)) unless the
+    // evidence changes after the point where it looked conclusive.
+    //
+    // With full_typing, reading goes on to max_rows after scoring stops,
+    // but only to collect value types and sentinels, which then equal those
+    // of the full sample; *rows_read counts those rows too.
+    static DetectionResult detect_adaptive(const std::string &path, const AdaptiveOptions &opt,
+                                           size_t *rows_read = nullptr);
+};
+
+// --- full-file timestamp extraction ----------------------------------------
+
+// Turns the column(s) picked by Detector::detect into UTC epoch-nanoseconds
+// for every data row of a file.
+//
+// Supported mappings: a datetime_col with role DateTime, EpochSeconds or
+// EpochMillis; a date_col + time_col pair; or a date_col alone (midnight).
+// Values without an explicit offset are taken to be at
+// Options::assume_utc_offset_minutes (UTC by default). Rows whose timestamp
+// doesn't parse yield kInvalid so the output stays aligned with the rows.
+class TimestampExtractor {
+public:
+    static constexpr int64_t kInvalid = INT64_MIN;
+
+    struct Options {
+        unsigned threads{0};              // 0 = hardware concurrency (shared pool, as for detect)
+        int assume_utc_offset_minutes{0}; // for values without Z / offset
+        size_t min_chunk_bytes{1u << 20}; // don't split finer than this
+    };
+
+    explicit TimestampExtractor(const DetectionResult &det) : TimestampExtractor(det, Options{}) {}
+    TimestampExtractor(const DetectionResult &det, Options opt);
+
+    // Timestamps for every non-empty data row of `path` (header excluded).
+    // gzip/zstd files are decoded in memory a piece at a time.
+    std::vector<int64_t> extract(const std::string &path) const;
+
+    // Same, over an in-memory copy of the whole file (header included).
+    std::vector<int64_t> extract(std::string_view data) const;
+
+    // Timestamps of the records in [begin, end) of `data`, appended to `ts`.
+    // begin and end must be record boundaries.
+    void extract_range(std::string_view data, size_t begin, size_t end, ThreadPool &pool,
+                       std::vector<int64_t> &ts) const;
+
+    // Timestamp of one tokenized row (kInvalid if it doesn't parse).
+    int64_t convert(const std::vector<std::string_view> &fields) const;
+
+private:
+    enum class Mode { DateTime, EpochSeconds, EpochMillis, DateAndTime, DateOnly };
+
+    char delim_;
+    Options opt_;
+    Mode mode_{Mode::DateTime};
+    size_t primary_{0}, secondary_{0}, needed_{1};
+    CompiledFormat primary_fmt_{}, secondary_fmt_{};
+};
+
+// --- persistent result cache ------------------------------------------------
+//
+// DetectionResults keyed by (path, size, mtime), stored in one binary file
+// (typically one per collection root). The file is memory-mapped when the
+// cache is opened and never modified in place, so any number of threads can
+// look up in it without locking; new results go to a small in-memory overlay
+// and save() writes a merged file next to the old one and renames it over.
+// A cache file that is missing, truncated or from another version is simply
+// treated as empty.
+//
+// Layout (little-endian, host byte order):
+//   "CDTC" u32 version u32 count
+//   count x { u64 path_hash, u64 record_offset }   sorted by hash
+//   records: str path, u64 size, i64 mtime_ns, u8 delim,
+//            u32 datetime/date/time column (UINT32_MAX = none),
+//            u32 ncols, ncols x { u32 index, u8 role, f64 confidence, str format, str header,
+//                                 u8 value_type, u8 has_sentinel, f64 sentinel }
+//   where str = u32 length + bytes
+
+class ResultCache {
+public:
+    // Opens (maps) cache_path if it exists; a missing or unreadable file
+    // starts an empty cache that save() will create.
+    explicit ResultCache(std::string cache_path);
+
+    // Cached result for csv_path if the file's size and mtime still match.
+    std::optional<DetectionResult> find(const std::string &csv_path) const;
+
+    void put(const std::string &csv_path, const DetectionResult &res);
+
+    // find(), else run detect() and remember its result.
+    DetectionResult get_or_detect(const std::string &csv_path, const std::function<DetectionResult()> &detect);
+
+    bool dirty() const;
+
+    // Write mapped + overlay entries to a temporary file, rename it over the
+    // cache and map the result. Entries are not re-validated against the
+    // disk here; stale ones are replaced the next time their file is
+    // detected. Safe to call while other threads use find()/put(): they
+    // keep reading the mapping they started with, which is unmapped once
+    // the last of them lets go of it. Concurrent save() calls are serialized.
+    // Returns false, keeping the unsaved entries, if the file could not be
+    // written or read back (as DetectionCache::save does).
+    bool save();
+
+private:
+    static constexpr uint32_t kVersion = 2;
+
+    // One mapped cache file and its index.
+    struct Snapshot;
+
+    std::string path_;
+    std::mutex save_mutex_;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Snapshot> snap_;
+    std::unordered_map<std::string, std::pair<FileStamp, DetectionResult>> overlay_;
+};
+
+// --- header-signature schema registry ---------------------------------------
+//
+// Files from one rig (daily rollovers and the like) share a header line and,
+// nearly always, the formats under it. The registry keeps a DetectionResult
+// per signature (header cells + delimiter, as sniffed). A file with a known
+// signature only has its first rows converted with that mapping and gets
+// full detection when any of them does not parse, so a folder of same-schema
+// logs costs one full detection plus a short read per file. Results without
+// a timestamp mapping have nothing to check against and are not reused.
+// Thread-safe; lives in memory (ResultCache covers reuse across runs).
+
+class SchemaRegistry {
+public:
+    struct Options {
+        size_t check_rows{16};     // rows a reused mapping must convert
+        size_t detect_rows{1000};  // sample for full detection
+        unsigned threads{1};       // as for Detector::detect
+    };
+
+    SchemaRegistry() : SchemaRegistry(Options{}) {}
+    explicit SchemaRegistry(Options opt) : opt_(opt) {}
+
+    static uint64_t signature(const std::vector<std::string> &headers, char delim);
+
+    // Detection for `path`, reusing a registered mapping when its signature
+    // matches and the check rows convert. `reused` reports which happened.
+    DetectionResult detect(const std::string &path, bool *reused = nullptr);
+
+    // Registers a result (e.g. from ResultCache) for files with these headers.
+    void add(const std::vector<std::string> &headers, const DetectionResult &res);
+
+    size_t size() const;
+    void clear();
+
+private:
+    struct Entry {
+        std::vector<std::string> headers; // guards against hash collisions
+        DetectionResult result;
+        std::unique_ptr<TimestampExtractor> ts;
+    };
+
+    // Every sampled row converts with the registered mapping.
+    static bool matches(const Entry &e, const Detector::Table &t);
+
+    Options opt_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<const Entry>> entries_;
+};
+
+// --- tail follow ------------------------------------------------------------
+//
+// Follows a CSV log that is still being written (IR sensor and weather rigs
+// append continuously). The DetectionResult is settled once and kept; every
+// update reads only the bytes past the last committed offset, tokenizes the
+// complete records among them and hands rows plus timestamps to the
+// subscribers in batches. A trailing partial record stays uncommitted until
+// its newline arrives, so an update costs a couple of syscalls plus the
+// appended bytes, whatever the file size.
+//
+// Truncation (size below the committed offset, or the bytes just before it
+// changed) and rotation (the path now names another file; what the old one
+// still had is read first) restart at the first data row of the new content
+// and flag the next batch with reset. Detection is only redone if the header
+// line changed.
+//
+// On Linux start() sleeps on inotify events for the file's directory, which
+// also sees the rename/create of a rotation. poll_ms is the fallback period
+// for filesystems that don't report changes (NFS, SMB) and other platforms.
+
+class LogFollower {
+public:
+    struct Batch {
+        bool reset{false};               // rows delivered before this are gone
+        uint64_t first_row{0};           // data-row number of row 0, since the last reset
+        uint64_t begin_offset{0};        // byte range the rows came from
+        uint64_t end_offset{0};
+        Detector::Table rows;            // padded/trimmed to the header width
+        std::vector<int64_t> timestamps; // one per row; kInvalid if unparsed or no mapping
+    };
+    using Subscriber = std::function<void(const Batch&)>;
+
+    struct Options {
+        size_t max_batch_rows{4096};
+        size_t detect_rows{1000};      // Detector sample size
+        size_t min_detect_rows{16};    // without a timestamp mapping, wait for this many rows before settling
+        bool start_at_end{false};      // skip what the file already holds when first opened
+        int poll_ms{500};
+        size_t read_chunk{1u << 20};
+        TimestampExtractor::Options timestamps{};
+    };
+
+    explicit LogFollower(std::string path) : LogFollower(std::move(path), Options{}) {}
+    LogFollower(std::string path, Options opt);
+
+    // Starts from a known result (e.g. from ResultCache); it is kept as long
+    // as the file's header matches its columns.
+    LogFollower(std::string path, DetectionResult det, Options opt);
+
+    ~LogFollower();
+
+    LogFollower(const LogFollower&) = delete;
+    LogFollower &operator=(const LogFollower&) = delete;
+
+    // Subscribers run on the updating thread and must not throw. Returns an
+    // id for unsubscribe().
+    size_t subscribe(Subscriber fn);
+    void unsubscribe(size_t id);
+
+    // One update on the calling thread; returns the number of rows delivered.
+    // Not to be mixed with start().
+    size_t poll();
+
+    // Update on a background thread whenever the file changes.
+    void start();
+    void stop();
+
+    // The result rows are parsed with, once settled.
+    std::optional<DetectionResult> detection() const;
+
+    // Bytes of the current file consumed so far (header included).
+    uint64_t committed_offset() const { return committed_.load(std::memory_order_acquire); }
+
+private:
+    // The followed file, kept open so a rotated-away file can still be
+    // drained.
+    class TailFile;
+
+    static constexpr size_t kAnchorBytes = 32;
+
+    bool reopen();
+    void restart();
+    bool anchor_matches();
+    void commit(std::string_view bytes, uint64_t end);
+    bool ensure_header();
+    bool same_columns(const DetectionResult &det) const;
+    void skip_to_end();
+    size_t drain();
+    size_t emit(std::string_view block);
+    void publish_reset();
+    void publish(const Batch &b);
+    bool wait();
+
+    std::string path_;
+    Options opt_;
+
+    // Touched by the updating thread only (det_ is also read by detection()).
+    std::unique_ptr<TailFile> file_;
+    std::optional<DetectionResult> det_;
+    mutable std::mutex det_mutex_;
+    std::unique_ptr<TimestampExtractor> extractor_;
+    std::unique_ptr<CsvTokenizer> tok_;
+    std::string header_line_;
+    std::vector<std::string> headers_;
+    uint64_t offset_{0}, header_end_{0}, rows_{0};
+    std::string anchor_, buf_;
+    bool opened_{false}, started_{false}, pending_reset_{false}, parser_ready_{false};
+    std::atomic<uint64_t> committed_{0};
+
+    std::mutex subs_mutex_;
+    std::vector<std::pair<size_t, std::shared_ptr<Subscriber>>> subs_;
+    size_t next_sub_{1};
+
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+#if defined(__linux__)
+    int notify_{-1};
+    int wake_[2]{-1, -1};
+    std::string name_;
+#endif
+};
+
+// --- sparse time index ------------------------------------------------------
+//
+// One entry per ~64 KB of records: byte offset, row number and the min/max
+// timestamp of its rows. A time-range query then touches only the blocks that
+// can hold matching rows, found by binary search when the log is in time
+// order (the usual case) and by a pass over the block table otherwise; the
+// rows before the window are never read.
+//
+// The index is kept next to the log (<log>.tidx) and trusted for the same
+// size, mtime and timestamp mapping. If the log has grown and the bytes just
+// before the indexed end are unchanged, refresh() indexes only the appended
+// records (redoing a short last block so blocks stay full); any other change
+// rebuilds. Blocks are summarized in parallel over the mapped file.
+//
+// Layout (host byte order):
+//   "CDTI" u32 version u32 block_bytes u32 sorted
+//   u64 size i64 mtime_ns u64 indexed_end u64 mapping_hash u64 rows
+//   u32 anchor_len, 32 bytes anchor (the bytes just before indexed_end)
+//   u64 count, count x { u64 offset, u64 first_row, u32 rows, u32 valid, i64 min_ts, i64 max_ts }
+
+class TimeIndex {
+public:
+    struct Block {
+        uint64_t offset{0};     // record aligned; the block ends where the next one starts
+        uint64_t first_row{0};  // data-row number of its first row
+        uint32_t rows{0};
+        uint32_t valid{0};      // rows whose timestamp parsed
+        int64_t min_ts{0};      // over valid rows; a block without any repeats
+        int64_t max_ts{0};      // the previous block's max_ts in both
+    };
+
+    struct Options {
+        size_t block_bytes{64u << 10};
+        unsigned threads{0};      // 0 = hardware concurrency
+        bool persist{true};       // read and write the sidecar
+        TimestampExtractor::Options timestamps{};
+    };
+
+    // Called for each matching row, in file order; return false to stop.
+    using RowFn = std::function<bool(uint64_t row, int64_t ts, const std::vector<std::string_view> &fields)>;
+
+    static std::string sidecar_path(const std::string &csv_path) { return csv_path + ".tidx"; }
+
+    TimeIndex(std::string csv_path, const DetectionResult &det) : TimeIndex(std::move(csv_path), det, Options{}) {}
+
+    // Uses the sidecar when it still matches, indexes what is missing, and
+    // saves the result. Throws if det has no timestamp mapping.
+    TimeIndex(std::string csv_path, const DetectionResult &det, Options opt);
+
+    // Catches up with the file; true if the index changed.
+    bool refresh();
+
+    // Byte ranges [begin, end) that may hold rows with from <= ts < to,
+    // adjacent blocks merged.
+    std::vector<std::pair<uint64_t, uint64_t>> byte_ranges(int64_t from, int64_t to) const;
+
+    // Streams the rows with from <= ts < to; returns how many were delivered.
+    size_t query(int64_t from, int64_t to, const RowFn &fn) const;
+
+    const std::vector<Block> &blocks() const { return blocks_; }
+    uint64_t rows() const { return rows_; }
+    uint64_t indexed_bytes() const { return indexed_end_; }
+    bool sorted() const { return sorted_; } // timestamps never decrease (unparsed rows aside)
+
+private:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kAnchorBytes = 32;
+
+    uint64_t end_of(size_t i) const { return i + 1 < blocks_.size() ? blocks_[i + 1].offset : indexed_end_; }
+
+    std::vector<size_t> candidates(int64_t from, int64_t to) const;
+    bool extends(std::string_view data) const;
+    void index_tail(std::string_view data);
+    bool load();
+    void save() const;
+
+    std::string path_;
+    char delim_;
+    TimestampExtractor ts_;
+    Options opt_;
+    uint64_t mapping_{0};
+
+    std::vector<Block> blocks_;
+    FileStamp stamp_;
+    uint64_t indexed_end_{0}, rows_{0};
+    bool sorted_{true};
+    uint32_t anchor_len_{0};
+    char anchor_[kAnchorBytes]{};
+};
+
+// --- time alignment ---------------------------------------------------------
+//
+// Relates timestamped streams without loading them. A reference stream
+// (typically IR movie frame times) drives the output; every other stream is
+// matched against each reference time with its own policy and tolerance.
+// Streams must be in time order. Each secondary is read through a cursor that
+// only moves forward and keeps just the samples on either side of the current
+// reference time, so memory stays O(streams) whatever the row counts. Several
+// files of one kind (daily logs, split recordings) are combined into one
+// stream with MergeSource, a heap-based k-way merge.
+
+struct TimedSample {
+    int64_t ts{0};
+    uint64_t row{0};            // position within its source
+    std::vector<double> values; // selected numeric columns, NaN where unparsed
+};
+
+class TimeSource {
+public:
+    virtual ~TimeSource() = default;
+    // Next sample in time order; false at the end.
+    virtual bool next(TimedSample &out) = 0;
+};
+
+// Rows of a CSV log, timed through a DetectionResult. Rows whose timestamp
+// doesn't parse are skipped. The file is mapped and read front to back, so
+// only the page cache grows with the file; gzip/zstd files are decoded into a
+// small rolling buffer instead.
+class CsvTimeSource : public TimeSource {
+public:
+    CsvTimeSource(const std::string &path, const DetectionResult &det, std::vector<size_t> value_columns = {});
+    ~CsvTimeSource() override;
+
+    // Index of a header in det (for value_columns); throws if absent.
+    static size_t column(const DetectionResult &det, const std::string &header);
+
+    // Skips ahead to the first index block that can hold rows at or after
+    // `from` (the index must be for this file and in time order).
+    void seek(const TimeIndex &index, int64_t from);
+
+    bool next(TimedSample &out) override;
+
+private:
+    bool refill();
+
+    std::unique_ptr<MappedFile> file_;
+    TimestampExtractor ts_;
+    std::unique_ptr<CsvTokenizer> tok_;
+    std::vector<size_t> columns_;
+    std::unique_ptr<DecodeStream> decode_;
+    std::string buf_;
+    std::string_view data_;
+    size_t pos_{0};
+    uint64_t row_{0};
+};
+
+// Samples produced by a callback, e.g. frame times read from an IR movie.
+class FunctionSource : public TimeSource {
+public:
+    explicit FunctionSource(std::function<bool(TimedSample&)> fn) : fn_(std::move(fn)) {}
+    bool next(TimedSample &out) override { return fn_(out); }
+
+private:
+    std::function<bool(TimedSample&)> fn_;
+};
+
+// Several sources as one time-ordered stream; rows stay per part, see
+// last_part().
+class MergeSource : public TimeSource {
+public:
+    explicit MergeSource(std::vector<std::unique_ptr<TimeSource>> parts);
+
+    bool next(TimedSample &out) override;
+
+    // Which part the last sample came from.
+    size_t last_part() const { return last_; }
+
+private:
+    using Entry = std::pair<int64_t, size_t>;
+    static bool later(const Entry &a, const Entry &b) { return a > b; } // min-heap on (ts, part)
+
+    void refill(size_t i);
+
+    std::vector<std::unique_ptr<TimeSource>> parts_;
+    std::vector<TimedSample> heads_;
+    std::vector<Entry> heap_;
+    size_t last_{0};
+};
+
+class TimeAligner {
+public:
+    enum class Policy {
+        Nearest,     // the closest sample within tolerance (the earlier one on a tie)
+        Interpolate  // linear between the samples either side, both within tolerance
+    };
+
+    struct Match {
+        bool found{false};
+        int64_t ts{0};      // the sample's time; the reference time when interpolated
+        uint64_t row{0};    // the sample's row; the earlier one when interpolated
+        std::vector<double> values;
+    };
+
+    struct Record {
+        TimedSample reference;
+        std::vector<Match> matches; // one per add()ed stream, in order
+    };
+
+    // Return false to stop.
+    using RecordFn = std::function<bool(const Record&)>;
+
+    // Returns the stream's position in Record::matches.
+    size_t add(std::unique_ptr<TimeSource> src, Policy policy, int64_t tolerance_ns);
+
+    // Emits one record per reference sample (only fully matched ones with
+    // require_all); returns how many were emitted.
+    size_t run(TimeSource &reference, const RecordFn &fn, bool require_all = false);
+
+    // Samples dropped for going back in time (reference: SIZE_MAX).
+    uint64_t out_of_order(size_t stream) const {
+        return stream < streams_.size() ? streams_[stream].dropped : ref_out_of_order_;
+    }
+
+private:
+    struct Stream {
+        std::unique_ptr<TimeSource> src;
+        Policy policy{Policy::Nearest};
+        int64_t tolerance{0};
+        TimedSample prev, next;
+        bool has_prev{false}, has_next{false}, primed{false};
+        uint64_t dropped{0};
+
+        void prime();
+        void fetch();
+        void advance_to(int64_t t);
+        bool match(int64_t t, Match &m) const;
+    };
+
+    std::vector<Stream> streams_;
+    uint64_t ref_out_of_order_{0};
+};
+
+// --- columnar cache ---------------------------------------------------------
+//
+// A parsed copy of a log (<log>.tcol) for loads that would otherwise tokenize
+// and convert the whole CSV again: the epoch-ns time column plus one
+// fixed-width column per other source column, typed by the detected
+// DetectedColumn::value_type where every value in the file fits it: i64 for
+// Int (kMissingInt where missing), u8 for Bool (1 / 0, kMissingBool where
+// missing), f64 for other columns whose values all parse as numbers (NaN
+// where missing, see ValueTyper) and u32 codes into a string dictionary
+// otherwise. An Int column with a decimal past the sample becomes f64.
+// Columns consumed by the timestamp mapping are folded into the time column. Opening a current sidecar maps it and parses nothing; the
+// arrays point straight into the mapping.
+//
+// The footer records the source size/mtime, the timestamp mapping and the
+// columns' value types; any difference rebuilds. The file is written once and renamed into place, so
+// other processes can map it concurrently and see either version. A build
+// that cannot be saved (read-only location) is kept in memory.
+//
+// Layout (host byte order, every block 8-byte aligned):
+//   "CDCL" u32 version
+//   blocks: time column (rows x i64), per column rows x f64, i64, u8 or u32,
+//           per dictionary (count + 1) x u64 end offsets then the bytes
+//   footer: u64 size i64 mtime_ns u64 mapping_hash u64 rows u64 time_offset (0 = none)
+//           u32 ncols, ncols x { str header, u32 source_index, u8 type,
+//                                u64 data_offset, u64 dict_offset, u32 dict_count }
+//   u64 footer_offset, "CDCL"
+
+class ColumnarCache {
+public:
+    enum class Type : uint8_t { Float64, Dictionary, Int64, Bool };
+
+    static constexpr int64_t kMissingInt = INT64_MIN;
+    static constexpr uint8_t kMissingBool = 0xFF;
+
+    struct Column {
+        std::string header;
+        size_t source_index{0};
+        Type type{Type::Float64};
+        const double *values{nullptr};    // Float64
+        const int64_t *ints{nullptr};     // Int64
+        const uint8_t *flags{nullptr};    // Bool
+        const uint32_t *codes{nullptr};   // Dictionary
+        size_t dict_count{0};
+        const uint64_t *dict_ends{nullptr};
+        const char *dict_bytes{nullptr};
+
+        // Codes are checked against dict_count when the sidecar is mapped.
+        std::string_view text(uint32_t code) const {
+            const uint64_t begin = code ? dict_ends[code - 1] : 0;
+            return {dict_bytes + begin, static_cast<size_t>(dict_ends[code] - begin)};
+        }
+    };
+
+    struct Options {
+        bool persist{true};
+        TimestampExtractor::Options timestamps{};
+    };
+
+    static std::string sidecar_path(const std::string &csv_path) { return csv_path + ".tcol"; }
+
+    ColumnarCache(std::string csv_path, const DetectionResult &det) : ColumnarCache(std::move(csv_path), det, Options{}) {}
+
+    // Maps the sidecar when it is current, otherwise parses the log once and
+    // writes it. A det without a timestamp mapping gives no time column.
+    ColumnarCache(std::string csv_path, const DetectionResult &det, Options opt);
+    ~ColumnarCache();
+
+    ColumnarCache(const ColumnarCache&) = delete;
+    ColumnarCache &operator=(const ColumnarCache&) = delete;
+
+    size_t rows() const { return static_cast<size_t>(rows_); }
+    // Epoch ns per row (TimestampExtractor::kInvalid where unparsed), or
+    // nullptr without a timestamp mapping.
+    const int64_t *timestamps() const { return time_; }
+    const std::vector<Column> &columns() const { return columns_; }
+    // Column by header; nullptr if absent or folded into the time column.
+    const Column *column(const std::string &header) const {
+        for (auto &c : columns_) if (c.header == header) return &c;
+        return nullptr;
+    }
+    // True if this open parsed the log (the sidecar was missing or stale).
+    bool rebuilt() const { return rebuilt_; }
+
+private:
+    static constexpr uint32_t kVersion = 3;
+
+    template <class Fn> void each_record(char delim, Fn fn) const;
+    std::string build(const DetectionResult &det, const FileStamp &st, uint64_t mapping) const;
+    bool parse(std::string_view data, const FileStamp &st, uint64_t mapping);
+
+    std::string path_;
+    Options opt_;
+    std::unique_ptr<MappedFile> file_;
+    std::string owned_;
+    uint64_t rows_{0};
+    const int64_t *time_{nullptr};
+    std::vector<Column> columns_;
+    bool rebuilt_{false};
+};
+
+} // namespace csvdt
@@ -0,0 +1,170 @@
+// column_detector_align.cpp
+// csvdt time alignment: CsvTimeSource, MergeSource and TimeAligner
+// (see column_detector.h).
+
+#include "column_detector_p.h"
+
+namespace csvdt {
+
+// --- time alignment ---------------------------------------------------------
+
+static inline double parse_double(std::string_view s) {
+    double v;
+    return parse_float_cell(s, v) ? v : std::nan("");
+}
+
+CsvTimeSource::CsvTimeSource(const std::string &path, const DetectionResult &det, std::vector<size_t> value_columns)
+    : file_(std::make_unique<MappedFile>(path, MappedFile::Access::Sequential)), ts_(det),
+      tok_(std::make_unique<CsvTokenizer>(det.delimiter)), columns_(std::move(value_columns)) {
+    data_ = file_->view();
+    const Compression kind = compression_of(data_);
+    if (kind != Compression::None) {
+        decode_ = std::make_unique<DecodeStream>(data_, kind);
+        refill();
+    }
+    tok_->next_record(data_, pos_); // header
+}
+
+CsvTimeSource::~CsvTimeSource() = default;
+
+size_t CsvTimeSource::column(const DetectionResult &det, const std::string &header) {
+    for (auto &c : det.all_columns) if (c.header == header) return c.index;
+    throw std::runtime_error("No column named " + header);
+}
+
+void CsvTimeSource::seek(const TimeIndex &index, int64_t from) {
+    if (decode_ || !index.sorted()) return;
+    for (auto &b : index.blocks()) {
+        if (b.valid && b.max_ts >= from) {
+            if (b.offset > pos_) { pos_ = static_cast<size_t>(b.offset); row_ = b.first_row; }
+            return;
+        }
+    }
+    pos_ = static_cast<size_t>(std::max<uint64_t>(pos_, index.indexed_bytes()));
+    row_ = index.rows();
+}
+
+bool CsvTimeSource::next(TimedSample &out) {
+    do {
+        while (tok_->next_record(data_, pos_)) {
+            const auto &f = tok_->fields();
+            if (f.size() == 1 && f[0].empty()) continue; // blank line
+            const uint64_t row = row_++;
+            const int64_t t = ts_.convert(f);
+            if (t == TimestampExtractor::kInvalid) continue;
+            out.ts = t;
+            out.row = row;
+            out.values.resize(columns_.size());
+            for (size_t i = 0; i < columns_.size(); ++i)
+                out.values[i] = columns_[i] < f.size() ? parse_double(f[columns_[i]]) : std::nan("");
+            return true;
+        }
+    } while (decode_ && refill());
+    return false;
+}
+
+// Drops the records already read and decodes until at least one more
+// complete record is buffered; false at the end of the data.
+bool CsvTimeSource::refill() {
+    buf_.erase(0, pos_);
+    pos_ = 0;
+    size_t end = 0;
+    bool more = true;
+    while (more && (end = complete_prefix(buf_)) == 0) more = decode_->read(buf_, 1u << 20) != 0;
+    if (!more) end = buf_.size();
+    data_ = std::string_view(buf_).substr(0, end);
+    return end > 0;
+}
+
+MergeSource::MergeSource(std::vector<std::unique_ptr<TimeSource>> parts) : parts_(std::move(parts)), heads_(parts_.size()) {
+    for (size_t i = 0; i < parts_.size(); ++i) refill(i);
+}
+
+bool MergeSource::next(TimedSample &out) {
+    if (heap_.empty()) return false;
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    last_ = heap_.back().second;
+    heap_.pop_back();
+    std::swap(out, heads_[last_]);
+    refill(last_);
+    return true;
+}
+
+void MergeSource::refill(size_t i) {
+    if (!parts_[i]->next(heads_[i])) return;
+    heap_.emplace_back(heads_[i].ts, i);
+    std::push_heap(heap_.begin(), heap_.end(), later);
+}
+
+size_t TimeAligner::add(std::unique_ptr<TimeSource> src, Policy policy, int64_t tolerance_ns) {
+    streams_.emplace_back();
+    Stream &s = streams_.back();
+    s.src = std::move(src);
+    s.policy = policy;
+    s.tolerance = tolerance_ns;
+    return streams_.size() - 1;
+}
+
+size_t TimeAligner::run(TimeSource &reference, const RecordFn &fn, bool require_all) {
+    Record rec;
+    rec.matches.resize(streams_.size());
+    for (auto &s : streams_) s.prime();
+    size_t emitted = 0;
+    int64_t last = INT64_MIN;
+    while (reference.next(rec.reference)) {
+        if (rec.reference.ts < last) { ++ref_out_of_order_; continue; }
+        last = rec.reference.ts;
+        bool all = true;
+        for (size_t i = 0; i < streams_.size(); ++i) {
+            streams_[i].advance_to(last);
+            all &= streams_[i].match(last, rec.matches[i]);
+        }
+        if (require_all && !all) continue;
+        ++emitted;
+        if (!fn(rec)) break;
+    }
+    return emitted;
+}
+
+void TimeAligner::Stream::prime() {
+    if (primed) return;
+    primed = true;
+    has_next = src->next(next);
+}
+
+void TimeAligner::Stream::fetch() {
+    while ((has_next = src->next(next)) && has_prev && next.ts < prev.ts) ++dropped;
+}
+
+void TimeAligner::Stream::advance_to(int64_t t) {
+    while (has_next && next.ts <= t) {
+        std::swap(prev, next);
+        has_prev = true;
+        fetch();
+    }
+}
+
+bool TimeAligner::Stream::match(int64_t t, Match &m) const {
+    m.found = false;
+    const bool before = has_prev && t - prev.ts <= tolerance;
+    const bool after = has_next && next.ts - t <= tolerance;
+    if (policy == Policy::Nearest || (before && prev.ts == t)) {
+        const TimedSample *s = before && (!after || t - prev.ts <= next.ts - t) ? &prev : after ? &next : nullptr;
+        if (!s) return false;
+        m.ts = s->ts;
+        m.row = s->row;
+        m.values.assign(s->values.begin(), s->values.end());
+    } else {
+        if (!before || !after) return false;
+        const double w = double(t - prev.ts) / double(next.ts - prev.ts);
+        m.ts = t;
+        m.row = prev.row;
+        m.values.resize(prev.values.size());
+        for (size_t i = 0; i < m.values.size(); ++i)
+            m.values[i] = prev.values[i] + (i < next.values.size() ? next.values[i] - prev.values[i] : std::nan("")) * w;
+    }
+    m.found = true;
+    return true;
+}
+
+} // namespace csvdt
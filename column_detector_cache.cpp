@@ -0,0 +1,287 @@
+// column_detector_cache.cpp
+// csvdt result reuse: the persistent ResultCache and the in-memory
+// SchemaRegistry (see column_detector.h).
+
+#include "column_detector_p.h"
+
+#include <algorithm>
+
+namespace csvdt {
+
+// --- persistent result cache ------------------------------------------------
+
+static constexpr uint32_t kNone = UINT32_MAX;
+
+static void write_record(std::string &out, const std::string &path, const FileStamp &st, const DetectionResult &res) {
+    put_str(out, path);
+    put_raw(out, st.size);
+    put_raw(out, st.mtime_ns);
+    put_raw(out, res.delimiter);
+    for (auto *col : {&res.datetime_col, &res.date_col, &res.time_col})
+        put_u32(out, *col ? static_cast<uint32_t>((*col)->index) : kNone);
+    put_u32(out, static_cast<uint32_t>(res.all_columns.size()));
+    for (auto &d : res.all_columns) {
+        put_u32(out, static_cast<uint32_t>(d.index));
+        put_raw(out, static_cast<uint8_t>(d.role));
+        put_raw(out, d.confidence);
+        put_str(out, d.format);
+        put_str(out, d.header);
+        put_raw(out, static_cast<uint8_t>(d.value_type));
+        put_raw(out, static_cast<uint8_t>(d.sentinel ? 1 : 0));
+        put_raw(out, d.sentinel.value_or(0.0));
+    }
+}
+
+static bool read_record(ByteReader &r, std::string &path, FileStamp &st, DetectionResult &res) {
+    path = std::string(r.str());
+    st.size = r.get<uint64_t>();
+    st.mtime_ns = r.get<int64_t>();
+    res.delimiter = r.get<char>();
+    uint32_t picks[3];
+    for (auto &p : picks) p = r.get<uint32_t>();
+    const uint32_t ncols = r.get<uint32_t>();
+    if (!r.ok || ncols > r.data.size()) return false;
+    res.all_columns.resize(ncols);
+    for (auto &d : res.all_columns) {
+        d.index = r.get<uint32_t>();
+        const uint8_t role = r.get<uint8_t>();
+        if (role > static_cast<uint8_t>(Role::EpochMillis)) return false;
+        d.role = static_cast<Role>(role);
+        d.confidence = r.get<double>();
+        d.format = std::string(r.str());
+        d.header = std::string(r.str());
+        const uint8_t type = r.get<uint8_t>();
+        if (type > static_cast<uint8_t>(ValueType::Categorical)) return false;
+        d.value_type = static_cast<ValueType>(type);
+        const uint8_t hasSentinel = r.get<uint8_t>();
+        const double sentinel = r.get<double>();
+        if (hasSentinel) d.sentinel = sentinel;
+    }
+    if (!r.ok) return false;
+    std::optional<DetectedColumn> *slots[3] = {&res.datetime_col, &res.date_col, &res.time_col};
+    for (int k = 0; k < 3; ++k) {
+        if (picks[k] == kNone) continue;
+        if (picks[k] >= ncols) return false;
+        *slots[k] = res.all_columns[picks[k]];
+    }
+    return true;
+}
+
+// One mapped cache file and its index. Immutable once opened; readers
+// share it through shared_ptr, so save() can publish a new one while
+// lookups on the old one finish.
+struct ResultCache::Snapshot {
+    std::unique_ptr<MappedFile> file;
+    std::string_view index;
+    uint32_t count{0};
+
+    // nullptr if the file is not a readable cache of this version.
+    static std::shared_ptr<const Snapshot> open(const std::string &path) {
+        auto s = std::make_shared<Snapshot>();
+        s->file = std::make_unique<MappedFile>(path, MappedFile::Access::Random);
+        if (!s->parse_index()) return nullptr;
+        return s;
+    }
+
+    std::string_view view() const { return file->view(); }
+    uint64_t index_hash(uint32_t i) const { uint64_t v; std::memcpy(&v, index.data() + size_t(i) * 16, 8); return v; }
+    uint64_t index_offset(uint32_t i) const { uint64_t v; std::memcpy(&v, index.data() + size_t(i) * 16 + 8, 8); return v; }
+
+    bool parse_index() {
+        ByteReader r{view(), 0};
+        if (view().substr(0, 4) != "CDTC") return false;
+        r.pos = 4;
+        const uint32_t version = r.get<uint32_t>();
+        const uint32_t n = r.get<uint32_t>();
+        if (!r.ok || version != kVersion || (view().size() - r.pos) / 16 < n) return false;
+        index = view().substr(r.pos, size_t(n) * 16);
+        count = n;
+        for (uint32_t i = 0; i < count; ++i) if (index_offset(i) >= view().size()) return false;
+        return true;
+    }
+
+    std::optional<DetectionResult> find(const std::string &csv_path, const FileStamp &st) const {
+        const uint64_t h = fnv1a(csv_path);
+        uint32_t lo = 0, hi = count;
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (index_hash(mid) < h) lo = mid + 1; else hi = mid;
+        }
+        for (; lo < count && index_hash(lo) == h; ++lo) {
+            ByteReader r{view(), static_cast<size_t>(index_offset(lo))};
+            if (r.str() != csv_path || !r.ok) continue;
+            r.pos = static_cast<size_t>(index_offset(lo));
+            std::string p; FileStamp cached; DetectionResult res;
+            if (!read_record(r, p, cached, res) || !(cached == st)) return std::nullopt;
+            return res;
+        }
+        return std::nullopt;
+    }
+};
+
+ResultCache::ResultCache(std::string cache_path) : path_(std::move(cache_path)) {
+    try {
+        snap_ = Snapshot::open(path_);
+    } catch (const std::runtime_error &) {}
+}
+
+std::optional<DetectionResult> ResultCache::find(const std::string &csv_path) const {
+    FileStamp st;
+    if (!stat_file(csv_path, st)) return std::nullopt;
+    std::shared_ptr<const Snapshot> snap;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        auto it = overlay_.find(csv_path);
+        if (it != overlay_.end()) {
+            if (it->second.first == st) return it->second.second;
+            return std::nullopt;
+        }
+        snap = snap_;
+    }
+    return snap ? snap->find(csv_path, st) : std::nullopt;
+}
+
+void ResultCache::put(const std::string &csv_path, const DetectionResult &res) {
+    FileStamp st;
+    if (!stat_file(csv_path, st)) return;
+    std::lock_guard<std::mutex> lk(mutex_);
+    overlay_[csv_path] = {st, res};
+}
+
+DetectionResult ResultCache::get_or_detect(const std::string &csv_path, const std::function<DetectionResult()> &detect) {
+    if (auto hit = find(csv_path)) return *hit;
+    DetectionResult res = detect();
+    put(csv_path, res);
+    return res;
+}
+
+bool ResultCache::dirty() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return !overlay_.empty();
+}
+
+bool ResultCache::save() {
+    std::lock_guard<std::mutex> saving(save_mutex_);
+    struct Entry { uint64_t hash; std::string path; FileStamp st; DetectionResult res; };
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, FileStamp> fresh;
+    std::shared_ptr<const Snapshot> old;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (auto &kv : overlay_) {
+            entries.push_back({fnv1a(kv.first), kv.first, kv.second.first, kv.second.second});
+            fresh.emplace(kv.first, kv.second.first);
+        }
+        old = snap_;
+    }
+    for (uint32_t i = 0; old && i < old->count; ++i) {
+        ByteReader r{old->view(), static_cast<size_t>(old->index_offset(i))};
+        Entry e{old->index_hash(i), {}, {}, {}};
+        if (read_record(r, e.path, e.st, e.res) && !fresh.count(e.path)) entries.push_back(std::move(e));
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b){ return a.hash < b.hash; });
+
+    std::string out("CDTC", 4);
+    put_u32(out, kVersion);
+    put_u32(out, static_cast<uint32_t>(entries.size()));
+    const size_t indexAt = out.size();
+    out.resize(indexAt + entries.size() * 16);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const uint64_t at = out.size();
+        std::memcpy(&out[indexAt + i * 16], &entries[i].hash, 8);
+        std::memcpy(&out[indexAt + i * 16 + 8], &at, 8);
+        write_record(out, entries[i].path, entries[i].st, entries[i].res);
+    }
+
+    bool written = true;
+    try {
+        const std::string tmp = write_temp(path_, out);
+        old.reset();
+#if defined(_WIN32)
+        // Windows cannot replace a file that is still mapped; finds miss the
+        // saved entries until the new mapping is in place.
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            snap_.reset();
+        }
+#endif
+        rename_over(tmp, path_);
+    } catch (const std::runtime_error &) {
+        written = false;
+    }
+
+    // Whatever is at path_ now: the new file, or the old one if it stayed.
+    std::shared_ptr<const Snapshot> next;
+    try { next = Snapshot::open(path_); } catch (const std::runtime_error &) {}
+    std::lock_guard<std::mutex> lk(mutex_);
+    snap_ = std::move(next);
+    if (!written || !snap_) return false;
+    // Keep what was put() while writing.
+    for (auto &kv : fresh) {
+        auto it = overlay_.find(kv.first);
+        if (it != overlay_.end() && it->second.first == kv.second) overlay_.erase(it);
+    }
+    return true;
+}
+
+// --- header-signature schema registry ---------------------------------------
+
+uint64_t SchemaRegistry::signature(const std::vector<std::string> &headers, char delim) {
+    std::string key(1, delim);
+    for (auto &h : headers) { key += '\x1f'; key += h; }
+    return fnv1a(key);
+}
+
+DetectionResult SchemaRegistry::detect(const std::string &path, bool *reused) {
+    if (reused) *reused = false;
+    const Detector::Table head = Detector::read_csv_sample(path, opt_.check_rows);
+    const uint64_t sig = signature(head.headers, head.delim);
+
+    std::shared_ptr<const Entry> known;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        auto it = entries_.find(sig);
+        if (it != entries_.end()) known = it->second;
+    }
+    if (known && matches(*known, head)) {
+        hps::count(stats::kSchemaHits);
+        if (reused) *reused = true;
+        return known->result;
+    }
+
+    DetectionResult res = Detector::detect(Detector::read_csv_sample(path, opt_.detect_rows), opt_.threads);
+    add(head.headers, res);
+    return res;
+}
+
+void SchemaRegistry::add(const std::vector<std::string> &headers, const DetectionResult &res) {
+    auto e = std::make_shared<Entry>();
+    e->headers = headers;
+    e->result = res;
+    try { e->ts = std::make_unique<TimestampExtractor>(res); } catch (const std::runtime_error &) { return; }
+    std::lock_guard<std::mutex> lk(mutex_);
+    entries_[signature(headers, res.delimiter)] = std::move(e);
+}
+
+size_t SchemaRegistry::size() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return entries_.size();
+}
+
+void SchemaRegistry::clear() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    entries_.clear();
+}
+
+bool SchemaRegistry::matches(const Entry &e, const Detector::Table &t) {
+    hps::Scope s(stats::kSchemaCheck);
+    if (e.headers != t.headers || e.result.delimiter != t.delim || t.rows() == 0) return false;
+    std::vector<std::string_view> row(t.cols());
+    for (size_t r = 0; r < t.rows(); ++r) {
+        for (size_t c = 0; c < t.cols(); ++c) row[c] = t.cell(r, c);
+        if (e.ts->convert(row) == TimestampExtractor::kInvalid) return false;
+    }
+    return true;
+}
+
+} // namespace csvdt
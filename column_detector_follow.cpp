@@ -0,0 +1,428 @@
+// column_detector_follow.cpp
+// csvdt LogFollower: parses only what is appended to a growing log
+// (see column_detector.h).
+
+#include "column_detector_p.h"
+
+#include <chrono>
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  if defined(__linux__)
+#    include <poll.h>
+#    include <sys/inotify.h>
+#  endif
+#endif
+
+namespace csvdt {
+
+// The followed file, kept open so a rotated-away file can still be drained.
+class LogFollower::TailFile {
+public:
+    TailFile() = default;
+    ~TailFile() { close(); }
+    TailFile(const TailFile&) = delete;
+    TailFile &operator=(const TailFile&) = delete;
+
+    bool open(const std::string &path) {
+        close();
+#if defined(_WIN32)
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return false;
+        id_ = id_of(file_);
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) return false;
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) { close(); return false; }
+        id_ = { uint64_t(st.st_dev), uint64_t(st.st_ino) };
+#endif
+        return true;
+    }
+
+    void close() {
+#if defined(_WIN32)
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+    }
+
+    bool is_open() const {
+#if defined(_WIN32)
+        return file_ != INVALID_HANDLE_VALUE;
+#else
+        return fd_ >= 0;
+#endif
+    }
+
+    uint64_t size() const {
+#if defined(_WIN32)
+        LARGE_INTEGER sz{};
+        if (!GetFileSizeEx(file_, &sz)) throw std::runtime_error("Cannot stat followed file");
+        return uint64_t(sz.QuadPart);
+#else
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) throw std::runtime_error("Cannot stat followed file");
+        return uint64_t(st.st_size);
+#endif
+    }
+
+    // Up to n bytes at `off`; fewer at end of file.
+    size_t read_at(uint64_t off, char *dst, size_t n) const {
+        size_t got = 0;
+        while (got < n) {
+#if defined(_WIN32)
+            OVERLAPPED ov{};
+            ov.Offset = DWORD(off + got);
+            ov.OffsetHigh = DWORD((off + got) >> 32);
+            DWORD r = 0;
+            if (!ReadFile(file_, dst + got, DWORD(std::min<size_t>(n - got, 1u << 30)), &r, &ov)) {
+                if (GetLastError() == ERROR_HANDLE_EOF) break;
+                throw std::runtime_error("Cannot read followed file");
+            }
+#else
+            const ssize_t r = ::pread(fd_, dst + got, n - got, off_t(off + got));
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) throw std::runtime_error("Cannot read followed file");
+#endif
+            if (r == 0) break;
+            got += size_t(r);
+        }
+        return got;
+    }
+
+    // False once `path` names another file (rotation). A missing path
+    // counts as unchanged: the open file is kept until a new one appears.
+    bool still_at(const std::string &path) const {
+#if defined(_WIN32)
+        HANDLE h = CreateFileA(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return true;
+        const auto id = id_of(h);
+        CloseHandle(h);
+        return id == id_;
+#else
+        struct stat st{};
+        if (::stat(path.c_str(), &st) != 0) return true;
+        return uint64_t(st.st_dev) == id_.first && uint64_t(st.st_ino) == id_.second;
+#endif
+    }
+
+private:
+#if defined(_WIN32)
+    static std::pair<uint64_t, uint64_t> id_of(HANDLE h) {
+        BY_HANDLE_FILE_INFORMATION fi{};
+        GetFileInformationByHandle(h, &fi);
+        return { fi.dwVolumeSerialNumber, (uint64_t(fi.nFileIndexHigh) << 32) | fi.nFileIndexLow };
+    }
+    HANDLE file_{INVALID_HANDLE_VALUE};
+#else
+    int fd_{-1};
+#endif
+    std::pair<uint64_t, uint64_t> id_{0, 0}; // (device, inode) / (volume, file index)
+};
+
+LogFollower::LogFollower(std::string path, Options opt)
+    : path_(std::move(path)), opt_(opt), file_(std::make_unique<TailFile>()), tok_(std::make_unique<CsvTokenizer>()) {
+    opt_.max_batch_rows = std::max<size_t>(1, opt_.max_batch_rows);
+    opt_.read_chunk = std::max<size_t>(4096, opt_.read_chunk);
+}
+
+LogFollower::LogFollower(std::string path, DetectionResult det, Options opt) : LogFollower(std::move(path), opt) {
+    det_ = std::move(det);
+}
+
+LogFollower::~LogFollower() { stop(); }
+
+size_t LogFollower::subscribe(Subscriber fn) {
+    std::lock_guard<std::mutex> lk(subs_mutex_);
+    subs_.emplace_back(next_sub_, std::make_shared<Subscriber>(std::move(fn)));
+    return next_sub_++;
+}
+
+void LogFollower::unsubscribe(size_t id) {
+    std::lock_guard<std::mutex> lk(subs_mutex_);
+    subs_.erase(std::remove_if(subs_.begin(), subs_.end(), [&](const auto &s){ return s.first == id; }), subs_.end());
+}
+
+size_t LogFollower::poll() {
+    hps::Scope s(stats::kFollow);
+    if (!file_->is_open() && !reopen()) return 0;
+    if (file_->size() < offset_ || !anchor_matches()) restart();
+    size_t delivered = drain();
+    if (!file_->still_at(path_)) {
+        file_->close();
+        if (reopen()) delivered += drain();
+    }
+    if (pending_reset_ && header_end_) publish_reset();
+    return delivered;
+}
+
+void LogFollower::start() {
+    if (thread_.joinable()) return;
+    stop_.store(false);
+#if defined(__linux__)
+    if (::pipe(wake_) != 0) wake_[0] = wake_[1] = -1;
+    notify_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify_ >= 0) {
+        const size_t slash = path_.rfind('/');
+        const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash);
+        name_ = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+        if (::inotify_add_watch(notify_, dir.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                                                      IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB) < 0) {
+            ::close(notify_);
+            notify_ = -1;
+        }
+    }
+#endif
+    thread_ = std::thread([this]{
+        do {
+            // A failed read is retried on the next wake-up.
+            try { poll(); } catch (const std::exception &) {}
+        } while (wait());
+    });
+}
+
+void LogFollower::stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(stop_mutex_);
+        stop_.store(true);
+    }
+    stop_cv_.notify_all();
+#if defined(__linux__)
+    if (wake_[1] >= 0) { const char c = 0; (void)!::write(wake_[1], &c, 1); }
+#endif
+    thread_.join();
+#if defined(__linux__)
+    for (int fd : { notify_, wake_[0], wake_[1] }) if (fd >= 0) ::close(fd);
+    notify_ = wake_[0] = wake_[1] = -1;
+#endif
+}
+
+std::optional<DetectionResult> LogFollower::detection() const {
+    std::lock_guard<std::mutex> lk(det_mutex_);
+    return det_;
+}
+
+bool LogFollower::reopen() {
+    if (!file_->open(path_)) return false;
+    if (opened_) restart();
+    opened_ = true;
+    return true;
+}
+
+void LogFollower::restart() {
+    offset_ = header_end_ = rows_ = 0;
+    anchor_.clear();
+    pending_reset_ = true;
+    committed_.store(0, std::memory_order_release);
+}
+
+// The committed bytes are still there (catches truncate-and-rewrite
+// that outgrew the old size between two updates).
+bool LogFollower::anchor_matches() {
+    if (anchor_.empty()) return true;
+    buf_.resize(anchor_.size());
+    return file_->read_at(offset_ - anchor_.size(), &buf_[0], buf_.size()) == anchor_.size() && buf_ == anchor_;
+}
+
+// `bytes` ends at `end`; when shorter than the anchor it must start at
+// the previous offset.
+void LogFollower::commit(std::string_view bytes, uint64_t end) {
+    if (bytes.size() >= kAnchorBytes) {
+        anchor_.assign(bytes.data() + bytes.size() - kAnchorBytes, kAnchorBytes);
+    } else {
+        anchor_.append(bytes.data(), bytes.size());
+        if (anchor_.size() > kAnchorBytes) anchor_.erase(0, anchor_.size() - kAnchorBytes);
+    }
+    offset_ = end;
+    committed_.store(end, std::memory_order_release);
+}
+
+// Header line of the current file, then the detection; false until both are
+// available.
+bool LogFollower::ensure_header() {
+    if (!header_end_) {
+        const uint64_t size = file_->size();
+        std::string head;
+        size_t nl = std::string::npos;
+        while (nl == std::string::npos && head.size() < size) {
+            const size_t old = head.size();
+            head.resize(std::min<uint64_t>(size, old + opt_.read_chunk));
+            head.resize(old + file_->read_at(old, &head[old], head.size() - old));
+            if (head.size() == old) break;
+            nl = head.find('\n', old);
+        }
+        if (nl == std::string::npos) return false;
+        header_line_ = head.substr(0, nl);
+        if (!header_line_.empty() && header_line_.back() == '\r') header_line_.pop_back();
+        if (det_ && !same_columns(*det_)) {
+            std::lock_guard<std::mutex> lk(det_mutex_);
+            det_.reset();
+        }
+        parser_ready_ = false;
+        header_end_ = nl + 1;
+        commit(std::string_view(head).substr(0, header_end_), header_end_);
+        if (!started_ && opt_.start_at_end) skip_to_end();
+        started_ = true;
+    }
+
+    if (!det_) {
+        Detector::Table t;
+        try { t = Detector::read_csv_sample(path_, opt_.detect_rows); }
+        catch (const std::runtime_error &) { return false; }
+        DetectionResult d = Detector::detect(t);
+        // A header keyword alone can name a column (with no format) when
+        // there are no rows yet.
+        const bool mapped = t.rows() && ((d.datetime_col && (d.datetime_col->role != Role::DateTime ||
+                                                             !d.datetime_col->format.empty())) ||
+                                         (d.date_col && !d.date_col->format.empty()));
+        if (!mapped && t.rows() < opt_.min_detect_rows) return false;
+        std::lock_guard<std::mutex> lk(det_mutex_);
+        det_ = std::move(d);
+    }
+    if (!parser_ready_) {
+        tok_->set_delimiter(det_->delimiter);
+        headers_ = split_csv_line(header_line_, det_->delimiter);
+        extractor_.reset();
+        if (det_->datetime_col || det_->date_col) extractor_ = std::make_unique<TimestampExtractor>(*det_, opt_.timestamps);
+        parser_ready_ = true;
+    }
+    return true;
+}
+
+bool LogFollower::same_columns(const DetectionResult &det) const {
+    if (det.all_columns.empty()) return true;
+    const auto hdr = split_csv_line(header_line_, det.delimiter);
+    if (hdr.size() != det.all_columns.size()) return false;
+    for (size_t i = 0; i < hdr.size(); ++i) if (hdr[i] != det.all_columns[i].header) return false;
+    return true;
+}
+
+// start_at_end: commit up to the last newline already in the file (taken
+// to end a record; a quoted newline in the very last record would split it).
+void LogFollower::skip_to_end() {
+    const uint64_t size = file_->size();
+    uint64_t from = size;
+    std::string tail;
+    while (from > offset_) {
+        const uint64_t begin = std::max<uint64_t>(offset_, from - std::min<uint64_t>(from, opt_.read_chunk));
+        tail.resize(size_t(from - begin));
+        tail.resize(file_->read_at(begin, &tail[0], tail.size()));
+        const size_t nl = tail.rfind('\n');
+        if (nl != std::string::npos) {
+            commit(std::string_view(tail).substr(0, nl + 1), begin + nl + 1);
+            return;
+        }
+        from = begin;
+    }
+}
+
+size_t LogFollower::drain() {
+    if (!ensure_header()) return 0;
+    const uint64_t size = file_->size();
+    size_t delivered = 0, chunk = opt_.read_chunk;
+    while (offset_ < size) {
+        const size_t want = size_t(std::min<uint64_t>(size - offset_, chunk));
+        buf_.resize(want);
+        buf_.resize(file_->read_at(offset_, &buf_[0], want));
+        const size_t cut = complete_prefix(buf_);
+        if (!cut) {
+            if (buf_.size() < want || offset_ + want >= size) break; // waiting for the record's end
+            chunk *= 2;                                              // one record longer than a chunk
+            continue;
+        }
+        delivered += emit(std::string_view(buf_).substr(0, cut));
+        chunk = opt_.read_chunk;
+    }
+    return delivered;
+}
+
+size_t LogFollower::emit(std::string_view block) {
+    const uint64_t base = offset_;
+    const size_t cols = headers_.size();
+    size_t pos = 0, total = 0;
+    while (pos < block.size()) {
+        Batch b;
+        b.first_row = rows_;
+        b.begin_offset = base + pos;
+        TableBuilder tb(cols, std::min(opt_.max_batch_rows, block.size() / 16 + 1));
+        while (tb.rows() < opt_.max_batch_rows && tok_->next_record(block, pos)) {
+            const auto &f = tok_->fields();
+            if (f.size() == 1 && f[0].empty()) continue; // blank line
+            tb.add_row(f);
+            b.timestamps.push_back(extractor_ ? extractor_->convert(f) : TimestampExtractor::kInvalid);
+        }
+        b.end_offset = base + pos;
+        b.rows = tb.finish(det_->delimiter, headers_);
+        b.reset = pending_reset_;
+        pending_reset_ = false;
+        rows_ += b.rows.rows();
+        total += b.rows.rows();
+        if (b.rows.rows() || b.reset) publish(b);
+        commit(block.substr(0, pos), base + pos);
+    }
+    return total;
+}
+
+void LogFollower::publish_reset() {
+    Batch b;
+    b.reset = true;
+    b.begin_offset = b.end_offset = offset_;
+    b.rows = TableBuilder(headers_.size(), 0).finish(det_ ? det_->delimiter : ',', headers_);
+    pending_reset_ = false;
+    publish(b);
+}
+
+void LogFollower::publish(const Batch &b) {
+    std::vector<std::shared_ptr<Subscriber>> subs;
+    {
+        std::lock_guard<std::mutex> lk(subs_mutex_);
+        for (auto &s : subs_) subs.push_back(s.second);
+    }
+    for (auto &fn : subs) (*fn)(b);
+}
+
+bool LogFollower::wait() {
+#if defined(__linux__)
+    if (wake_[0] >= 0) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(opt_.poll_ms);
+        for (;;) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd fds[2] = { { wake_[0], POLLIN, 0 }, { notify_, POLLIN, 0 } };
+            const int n = ::poll(fds, notify_ >= 0 ? 2 : 1, int(std::max<int64_t>(0, left.count())));
+            if (stop_.load()) return false;
+            if (n <= 0 || !(fds[1].revents & POLLIN)) return true; // timeout: periodic check
+            // Only events for our file (or a dropped queue) warrant an update.
+            alignas(inotify_event) char ev[4096];
+            bool ours = false;
+            ssize_t got;
+            while ((got = ::read(notify_, ev, sizeof ev)) > 0) {
+                for (char *p = ev; p < ev + got; ) {
+                    const auto *e = reinterpret_cast<const inotify_event*>(p);
+                    if ((e->mask & IN_Q_OVERFLOW) || (e->len && name_ == e->name)) ours = true;
+                    p += sizeof(inotify_event) + e->len;
+                }
+            }
+            if (ours) return true;
+        }
+    }
+#endif
+    std::unique_lock<std::mutex> lk(stop_mutex_);
+    stop_cv_.wait_for(lk, std::chrono::milliseconds(opt_.poll_ms), [this]{ return stop_.load(); });
+    return !stop_.load();
+}
+
+} // namespace csvdt
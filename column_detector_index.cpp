@@ -0,0 +1,551 @@
+// column_detector_index.cpp
+// csvdt sidecars over a whole log: TimeIndex (<log>.tidx) and
+// ColumnarCache (<log>.tcol); layouts are described in column_detector.h.
+
+#include "column_detector_p.h"
+
+namespace csvdt {
+
+// --- sparse time index ------------------------------------------------------
+
+TimeIndex::TimeIndex(std::string csv_path, const DetectionResult &det, Options opt)
+    : path_(std::move(csv_path)), delim_(det.delimiter), ts_(det, opt.timestamps), opt_(opt) {
+    opt_.block_bytes = std::max<size_t>(4096, opt_.block_bytes);
+    mapping_ = mapping_hash(det, opt_.timestamps);
+    if (opt_.persist) load();
+    refresh();
+}
+
+bool TimeIndex::refresh() {
+    FileStamp st;
+    if (!stat_file(path_, st)) throw std::runtime_error("Cannot stat file: " + path_);
+    if (st == stamp_ && indexed_end_) return false;
+
+    MappedFile file(path_, MappedFile::Access::Sequential);
+    const std::string_view data = file.view();
+    if (compression_of(data) != Compression::None)
+        throw std::runtime_error("Time index needs an uncompressed file: " + path_);
+    if (!extends(data)) {
+        blocks_.clear();
+        indexed_end_ = rows_ = 0;
+        anchor_len_ = 0;
+        sorted_ = true;
+    }
+    index_tail(data);
+    stamp_ = st;
+    if (opt_.persist) {
+        try { save(); } catch (const std::runtime_error &) {} // read-only location: keep it in memory
+    }
+    return true;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> TimeIndex::byte_ranges(int64_t from, int64_t to) const {
+    std::vector<std::pair<uint64_t, uint64_t>> out;
+    for (size_t i : candidates(from, to)) {
+        if (!out.empty() && out.back().second == blocks_[i].offset) out.back().second = end_of(i);
+        else out.emplace_back(blocks_[i].offset, end_of(i));
+    }
+    return out;
+}
+
+size_t TimeIndex::query(int64_t from, int64_t to, const RowFn &fn) const {
+    const std::vector<size_t> blocks = candidates(from, to);
+    if (blocks.empty()) return 0;
+    MappedFile file(path_, MappedFile::Access::Random);
+    const std::string_view data = file.view();
+    if (data.size() < indexed_end_) throw std::runtime_error("Time index is stale: " + path_);
+
+    CsvTokenizer tok(delim_);
+    size_t delivered = 0;
+    for (size_t i : blocks) {
+        const std::string_view block = data.substr(0, static_cast<size_t>(end_of(i)));
+        size_t pos = static_cast<size_t>(blocks_[i].offset);
+        uint64_t row = blocks_[i].first_row;
+        while (tok.next_record(block, pos)) {
+            const auto &f = tok.fields();
+            if (f.size() == 1 && f[0].empty()) continue; // blank line
+            const int64_t t = ts_.convert(f);
+            if (t != TimestampExtractor::kInvalid && t >= from && t < to) {
+                ++delivered;
+                if (!fn(row, t, f)) return delivered;
+            }
+            ++row;
+        }
+    }
+    return delivered;
+}
+
+std::vector<size_t> TimeIndex::candidates(int64_t from, int64_t to) const {
+    std::vector<size_t> out;
+    if (from >= to) return out;
+    size_t lo = 0, hi = blocks_.size();
+    if (sorted_) {
+        // max_ts and min_ts are both non-decreasing across blocks.
+        lo = static_cast<size_t>(std::partition_point(blocks_.begin(), blocks_.end(),
+                                                      [&](const Block &b){ return b.max_ts < from; }) - blocks_.begin());
+        hi = static_cast<size_t>(std::partition_point(blocks_.begin() + static_cast<std::ptrdiff_t>(lo), blocks_.end(),
+                                                      [&](const Block &b){ return b.min_ts < to; }) - blocks_.begin());
+    }
+    for (size_t i = lo; i < hi; ++i) {
+        const Block &b = blocks_[i];
+        if (b.valid && b.max_ts >= from && b.min_ts < to) out.push_back(i);
+    }
+    return out;
+}
+
+// The indexed prefix is still what the file starts with.
+bool TimeIndex::extends(std::string_view data) const {
+    if (!indexed_end_ || data.size() < indexed_end_) return false;
+    return std::memcmp(data.data() + indexed_end_ - anchor_len_, anchor_, anchor_len_) == 0;
+}
+
+void TimeIndex::index_tail(std::string_view data) {
+    uint64_t from = indexed_end_;
+    if (!blocks_.empty() && indexed_end_ - blocks_.back().offset < opt_.block_bytes / 2) {
+        from = blocks_.back().offset;
+        rows_ = blocks_.back().first_row;
+        blocks_.pop_back();
+    }
+    if (!from) {
+        CsvTokenizer tok(delim_);
+        size_t body = 0;
+        tok.next_record(data, body); // header
+        if (!body || data[body - 1] != '\n') return;
+        from = body;
+    }
+    if (from >= data.size()) return;
+
+    // Record-aligned pieces of about block_bytes; the last one may end in
+    // a record that is still being written, which is left out.
+    const size_t bytes = data.size() - static_cast<size_t>(from);
+    const size_t parts = bytes / opt_.block_bytes + 1;
+    ThreadPool &pool = ThreadPool::shared(parts > 1 ? opt_.threads : 1);
+    std::vector<size_t> cuts = split_record_aligned(data, static_cast<size_t>(from), data.size(), parts, pool);
+    const size_t last = cuts[cuts.size() - 2];
+    cuts.back() = last + complete_prefix(data.substr(last));
+    if (cuts.back() == last) cuts.pop_back();
+    if (cuts.size() < 2) return;
+
+    const size_t n = cuts.size() - 1;
+    std::vector<Block> fresh(n);
+    std::vector<char> ordered(n, 1);
+    pool.parallel_for(n, [&](size_t i){
+        const std::string_view block = data.substr(0, cuts[i + 1]);
+        Block &b = fresh[i];
+        b.offset = cuts[i];
+        b.min_ts = INT64_MAX;
+        b.max_ts = INT64_MIN;
+        CsvTokenizer tok(delim_);
+        size_t pos = cuts[i];
+        while (tok.next_record(block, pos)) {
+            const auto &f = tok.fields();
+            if (f.size() == 1 && f[0].empty()) continue; // blank line
+            ++b.rows;
+            const int64_t t = ts_.convert(f);
+            if (t == TimestampExtractor::kInvalid) continue;
+            if (b.valid && t < b.max_ts) ordered[i] = 0;
+            ++b.valid;
+            b.min_ts = std::min(b.min_ts, t);
+            b.max_ts = std::max(b.max_ts, t);
+        }
+    });
+
+    int64_t carry = blocks_.empty() ? INT64_MIN : blocks_.back().max_ts;
+    for (size_t i = 0; i < n; ++i) {
+        Block &b = fresh[i];
+        b.first_row = rows_;
+        rows_ += b.rows;
+        if (!b.valid) {
+            b.min_ts = b.max_ts = carry;
+        } else {
+            if (!ordered[i] || b.min_ts < carry) sorted_ = false;
+            carry = b.max_ts;
+        }
+        blocks_.push_back(b);
+    }
+    indexed_end_ = cuts.back();
+    anchor_len_ = static_cast<uint32_t>(std::min<uint64_t>(kAnchorBytes, indexed_end_));
+    std::memcpy(anchor_, data.data() + indexed_end_ - anchor_len_, anchor_len_);
+}
+
+bool TimeIndex::load() {
+    std::unique_ptr<MappedFile> file;
+    try { file = std::make_unique<MappedFile>(sidecar_path(path_), MappedFile::Access::Sequential); }
+    catch (const std::runtime_error &) { return false; }
+    const std::string_view data = file->view();
+    if (data.substr(0, 4) != "CDTI") return false;
+    ByteReader r{data, 4};
+    const uint32_t version = r.get<uint32_t>(), block_bytes = r.get<uint32_t>(), sorted = r.get<uint32_t>();
+    FileStamp st;
+    st.size = r.get<uint64_t>();
+    st.mtime_ns = r.get<int64_t>();
+    const uint64_t end = r.get<uint64_t>(), mapping = r.get<uint64_t>(), rows = r.get<uint64_t>();
+    const uint32_t anchor_len = r.get<uint32_t>();
+    char anchor[kAnchorBytes];
+    for (char &c : anchor) c = r.get<char>();
+    const uint64_t count = r.get<uint64_t>();
+    if (!r.ok || version != kVersion || block_bytes != opt_.block_bytes || mapping != mapping_ ||
+        anchor_len > kAnchorBytes || (data.size() - r.pos) / 40 < count)
+        return false;
+
+    std::vector<Block> blocks(static_cast<size_t>(count));
+    for (Block &b : blocks) {
+        b.offset = r.get<uint64_t>();
+        b.first_row = r.get<uint64_t>();
+        b.rows = r.get<uint32_t>();
+        b.valid = r.get<uint32_t>();
+        b.min_ts = r.get<int64_t>();
+        b.max_ts = r.get<int64_t>();
+    }
+    if (!r.ok) return false;
+
+    // Offsets are trusted by query() and refresh(); a table that doesn't
+    // add up is rebuilt rather than read.
+    uint64_t at = 0, row = 0;
+    for (const Block &b : blocks) {
+        if (b.offset < at || b.offset >= end || b.first_row != row || b.valid > b.rows) return false;
+        at = b.offset + 1;
+        row += b.rows;
+    }
+    if (row != rows || end > st.size || anchor_len > end || (end && blocks.empty())) return false;
+    blocks_ = std::move(blocks);
+    stamp_ = st;
+    indexed_end_ = end;
+    rows_ = rows;
+    sorted_ = sorted != 0;
+    anchor_len_ = anchor_len;
+    std::memcpy(anchor_, anchor, sizeof anchor);
+    return true;
+}
+
+void TimeIndex::save() const {
+    std::string out("CDTI", 4);
+    put_u32(out, kVersion);
+    put_u32(out, static_cast<uint32_t>(opt_.block_bytes));
+    put_u32(out, sorted_ ? 1 : 0);
+    put_raw(out, stamp_.size);
+    put_raw(out, stamp_.mtime_ns);
+    put_raw(out, indexed_end_);
+    put_raw(out, mapping_);
+    put_raw(out, rows_);
+    put_u32(out, anchor_len_);
+    out.append(anchor_, kAnchorBytes);
+    put_raw(out, static_cast<uint64_t>(blocks_.size()));
+    out.reserve(out.size() + blocks_.size() * 40);
+    for (const Block &b : blocks_) {
+        put_raw(out, b.offset);
+        put_raw(out, b.first_row);
+        put_raw(out, b.rows);
+        put_raw(out, b.valid);
+        put_raw(out, b.min_ts);
+        put_raw(out, b.max_ts);
+    }
+    const std::string sidecar = sidecar_path(path_);
+    rename_over(write_temp(sidecar, out), sidecar);
+}
+
+// --- columnar cache ---------------------------------------------------------
+
+// Missing markers and sentinels decide which cells become NaN.
+static uint64_t typing_hash(const DetectionResult &det) {
+    std::string key;
+    for (auto &d : det.all_columns) {
+        key += std::to_string(d.index) + ':' + std::to_string(int(d.value_type));
+        if (d.sentinel) key += '=' + std::to_string(*d.sentinel);
+        key += '|';
+    }
+    return fnv1a(key) * 31;
+}
+
+static void align8(std::string &out) { out.resize((out.size() + 7) & ~size_t(7)); }
+
+ColumnarCache::ColumnarCache(std::string csv_path, const DetectionResult &det, Options opt) : path_(std::move(csv_path)), opt_(opt) {
+    FileStamp st;
+    if (!stat_file(path_, st)) throw std::runtime_error("Cannot stat file: " + path_);
+    const uint64_t mapping = mapping_hash(det, opt_.timestamps) ^ typing_hash(det);
+    if (opt_.persist) {
+        try {
+            file_ = std::make_unique<MappedFile>(sidecar_path(path_), MappedFile::Access::Random);
+            if (parse(file_->view(), st, mapping)) return;
+        } catch (const std::runtime_error &) {}
+        file_.reset();
+    }
+
+    std::string image = build(det, st, mapping);
+    if (opt_.persist) {
+        try {
+            const std::string sidecar = sidecar_path(path_);
+            rename_over(write_temp(sidecar, image), sidecar);
+            file_ = std::make_unique<MappedFile>(sidecar, MappedFile::Access::Random);
+            if (parse(file_->view(), st, mapping)) { rebuilt_ = true; return; }
+        } catch (const std::runtime_error &) {}
+        file_.reset();
+    }
+    owned_ = std::move(image);
+    if (!parse(owned_, st, mapping)) throw std::runtime_error("Cannot read back columnar cache: " + path_);
+    rebuilt_ = true;
+}
+
+ColumnarCache::~ColumnarCache() = default;
+
+// Every record of the log, header first. Plain logs are read through the
+// mapping; gzip/zstd logs are decoded a piece at a time, so memory stays
+// bounded by the piece size whatever the decoded size. Fields point into
+// a buffer that is reused after fn returns.
+template <class Fn> void ColumnarCache::each_record(char delim, Fn fn) const {
+    MappedFile file(path_, MappedFile::Access::Sequential);
+    const std::string_view raw = file.view();
+    CsvTokenizer tok(delim);
+    bool header = true;
+    auto records = [&](std::string_view data) {
+        size_t pos = 0;
+        while (tok.next_record(data, pos)) {
+            const auto &f = tok.fields();
+            if (!header && f.size() == 1 && f[0].empty()) continue; // blank line
+            fn(header, f);
+            header = false;
+        }
+    };
+    const Compression kind = compression_of(raw);
+    if (kind == Compression::None) return records(raw);
+
+    constexpr size_t kPiece = 16u << 20;
+    DecodeStream in(raw, kind);
+    std::string buf;
+    bool more = true;
+    while (more) {
+        more = in.read(buf, kPiece) != 0;
+        const size_t end = more ? complete_prefix(buf) : buf.size();
+        records(std::string_view(buf).substr(0, end));
+        buf.erase(0, end);
+    }
+}
+
+std::string ColumnarCache::build(const DetectionResult &det, const FileStamp &st, uint64_t mapping) const {
+    std::optional<TimestampExtractor> ts;
+    try { ts.emplace(det, opt_.timestamps); } catch (const std::runtime_error &) {}
+    std::vector<bool> folded;
+    for (auto *col : {&det.datetime_col, &det.date_col, &det.time_col}) {
+        if (!ts || !*col) continue;
+        if (folded.size() <= (*col)->index) folded.resize((*col)->index + 1);
+        folded[(*col)->index] = true;
+    }
+
+    // Pass 1: headers, row count and which columns are all-numeric,
+    // all-integer or all-boolean over the whole file.
+    std::vector<std::string> headers;
+    std::vector<bool> numeric, integral, boolean;
+    uint64_t rows = 0;
+    each_record(det.delimiter, [&](bool header, const std::vector<std::string_view> &f){
+        if (header) {
+            headers.assign(f.begin(), f.end());
+            numeric.assign(headers.size(), true);
+            integral.assign(headers.size(), true);
+            boolean.assign(headers.size(), true);
+            return;
+        }
+        ++rows;
+        double v;
+        int64_t i;
+        for (size_t c = 0; c < f.size() && c < numeric.size(); ++c) {
+            const std::string_view s = trim_view(f[c]);
+            if (is_missing_token(s)) continue;
+            if (numeric[c] && !parse_float_cell(s, v)) numeric[c] = false;
+            if (integral[c] && (!parse_int_cell(s, i) || i == kMissingInt)) integral[c] = false;
+            if (boolean[c] && bool_token(s) < 0) boolean[c] = false;
+        }
+    });
+    folded.resize(headers.size());
+
+    struct Out {
+        size_t source;
+        Type type;
+        DetectedColumn typed;  // value type and sentinel from detection
+        std::vector<double> values;
+        std::vector<int64_t> ints;
+        std::vector<uint8_t> flags;
+        std::vector<uint32_t> codes;
+        std::unordered_map<std::string, uint32_t> dict;
+        std::vector<std::string_view> dict_order;
+    };
+    std::vector<Out> outs;
+    for (size_t c = 0; c < headers.size(); ++c) {
+        if (folded[c]) continue;
+        Out o{c, numeric[c] ? Type::Float64 : Type::Dictionary, {}, {}, {}, {}, {}, {}, {}};
+        for (auto &d : det.all_columns) if (d.index == c) o.typed = d;
+        if (o.typed.value_type == ValueType::Int && integral[c]) o.type = Type::Int64;
+        else if (o.typed.value_type == ValueType::Bool && boolean[c]) o.type = Type::Bool;
+        switch (o.type) {
+            case Type::Float64:    o.values.reserve(static_cast<size_t>(rows)); break;
+            case Type::Int64:      o.ints.reserve(static_cast<size_t>(rows)); break;
+            case Type::Bool:       o.flags.reserve(static_cast<size_t>(rows)); break;
+            case Type::Dictionary: o.codes.reserve(static_cast<size_t>(rows)); break;
+        }
+        outs.push_back(std::move(o));
+    }
+    std::vector<int64_t> times;
+    if (ts) times.reserve(static_cast<size_t>(rows));
+
+    // Pass 2: convert, gathering rows into columnar blocks so every
+    // column is parsed in bulk (see parse_*_column).
+    constexpr size_t kBlockRows = 16384;
+    std::unique_ptr<TableBuilder> tb;
+    std::vector<double> f64;
+    std::vector<int64_t> i64;
+    std::vector<uint8_t> u8, valid;
+    auto flush = [&]{
+        if (!tb || !tb->rows()) return;
+        const Detector::Table t = tb->finish(det.delimiter, {});
+        for (Out &o : outs) {
+            const ColumnView col = t.column(o.source);
+            switch (o.type) {
+                case Type::Float64:
+                    parse_float_column(col, o.typed, f64);
+                    o.values.insert(o.values.end(), f64.begin(), f64.end());
+                    break;
+                case Type::Int64:
+                    parse_int_column(col, o.typed, i64, valid);
+                    for (size_t r = 0; r < col.size(); ++r) o.ints.push_back(valid[r] ? i64[r] : kMissingInt);
+                    break;
+                case Type::Bool:
+                    parse_bool_column(col, u8);
+                    o.flags.insert(o.flags.end(), u8.begin(), u8.end());
+                    break;
+                case Type::Dictionary:
+                    for (size_t r = 0; r < col.size(); ++r) {
+                        auto it = o.dict.emplace(std::string(col[r]), static_cast<uint32_t>(o.dict.size())).first;
+                        if (it->second == o.dict_order.size()) o.dict_order.push_back(it->first);
+                        o.codes.push_back(it->second);
+                    }
+                    break;
+            }
+        }
+        tb.reset();
+    };
+    each_record(det.delimiter, [&](bool header, const std::vector<std::string_view> &f){
+        if (header) return;
+        if (ts) times.push_back(ts->convert(f));
+        if (!tb) tb = std::make_unique<TableBuilder>(headers.size(), kBlockRows);
+        tb->add_row(f);
+        if (tb->rows() == kBlockRows) flush();
+    });
+    flush();
+
+    std::string out("CDCL", 4);
+    put_u32(out, kVersion);
+    align8(out);
+    uint64_t timeAt = 0;
+    if (ts) {
+        timeAt = out.size();
+        out.append(reinterpret_cast<const char*>(times.data()), times.size() * sizeof(int64_t));
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> at(outs.size());
+    for (size_t i = 0; i < outs.size(); ++i) {
+        Out &o = outs[i];
+        align8(out);
+        at[i].first = out.size();
+        switch (o.type) {
+            case Type::Float64:
+                out.append(reinterpret_cast<const char*>(o.values.data()), o.values.size() * sizeof(double));
+                continue;
+            case Type::Int64:
+                out.append(reinterpret_cast<const char*>(o.ints.data()), o.ints.size() * sizeof(int64_t));
+                continue;
+            case Type::Bool:
+                out.append(reinterpret_cast<const char*>(o.flags.data()), o.flags.size());
+                continue;
+            case Type::Dictionary:
+                break;
+        }
+        out.append(reinterpret_cast<const char*>(o.codes.data()), o.codes.size() * sizeof(uint32_t));
+        align8(out);
+        at[i].second = out.size();
+        uint64_t end = 0;
+        for (auto s : o.dict_order) put_raw(out, end += s.size());
+        for (auto s : o.dict_order) out.append(s);
+    }
+
+    align8(out);
+    const uint64_t footer = out.size();
+    put_raw(out, st.size);
+    put_raw(out, st.mtime_ns);
+    put_raw(out, mapping);
+    put_raw(out, rows);
+    put_raw(out, timeAt);
+    put_u32(out, static_cast<uint32_t>(outs.size()));
+    for (size_t i = 0; i < outs.size(); ++i) {
+        put_str(out, headers[outs[i].source]);
+        put_u32(out, static_cast<uint32_t>(outs[i].source));
+        put_raw(out, static_cast<uint8_t>(outs[i].type));
+        put_raw(out, at[i].first);
+        put_raw(out, at[i].second);
+        put_u32(out, static_cast<uint32_t>(outs[i].dict_order.size()));
+    }
+    put_raw(out, footer);
+    out.append("CDCL", 4);
+    return out;
+}
+
+// Points the accessors into `data`; false if it is not a current,
+// well-formed cache for this log.
+bool ColumnarCache::parse(std::string_view data, const FileStamp &st, uint64_t mapping) {
+    if (data.size() < 28 || data.substr(0, 4) != "CDCL" || data.substr(data.size() - 4) != "CDCL") return false;
+    ByteReader r{data, 4};
+    if (r.get<uint32_t>() != kVersion) return false;
+    r.pos = data.size() - 12;
+    r.pos = static_cast<size_t>(std::min<uint64_t>(r.get<uint64_t>(), data.size()));
+    FileStamp cached;
+    cached.size = r.get<uint64_t>();
+    cached.mtime_ns = r.get<int64_t>();
+    const uint64_t cachedMapping = r.get<uint64_t>(), rows = r.get<uint64_t>(), timeAt = r.get<uint64_t>();
+    const uint32_t ncols = r.get<uint32_t>();
+    if (!r.ok || !(cached == st) || cachedMapping != mapping || ncols > data.size()) return false;
+
+    // An array of n elements of `size` bytes at `off`, aligned and in bounds.
+    auto fits = [&](uint64_t off, uint64_t n, uint64_t size) {
+        return off % 8 == 0 && off <= data.size() && n <= (data.size() - off) / size;
+    };
+    if (timeAt && !fits(timeAt, rows, sizeof(int64_t))) return false;
+
+    std::vector<Column> cols(ncols);
+    for (Column &c : cols) {
+        c.header = std::string(r.str());
+        c.source_index = r.get<uint32_t>();
+        const uint8_t type = r.get<uint8_t>();
+        const uint64_t dataAt = r.get<uint64_t>(), dictAt = r.get<uint64_t>();
+        c.dict_count = r.get<uint32_t>();
+        if (!r.ok || type > uint8_t(Type::Bool)) return false;
+        c.type = static_cast<Type>(type);
+        switch (c.type) {
+            case Type::Float64:
+                if (!fits(dataAt, rows, sizeof(double))) return false;
+                c.values = reinterpret_cast<const double*>(data.data() + dataAt);
+                continue;
+            case Type::Int64:
+                if (!fits(dataAt, rows, sizeof(int64_t))) return false;
+                c.ints = reinterpret_cast<const int64_t*>(data.data() + dataAt);
+                continue;
+            case Type::Bool:
+                if (!fits(dataAt, rows, 1)) return false;
+                c.flags = reinterpret_cast<const uint8_t*>(data.data() + dataAt);
+                for (uint64_t row = 0; row < rows; ++row) if (c.flags[row] > 1 && c.flags[row] != kMissingBool) return false;
+                continue;
+            case Type::Dictionary:
+                break;
+        }
+        if (!fits(dataAt, rows, sizeof(uint32_t)) || !fits(dictAt, c.dict_count, sizeof(uint64_t))) return false;
+        c.codes = reinterpret_cast<const uint32_t*>(data.data() + dataAt);
+        c.dict_ends = reinterpret_cast<const uint64_t*>(data.data() + dictAt);
+        c.dict_bytes = data.data() + dictAt + c.dict_count * sizeof(uint64_t);
+        const uint64_t bytes = c.dict_count ? c.dict_ends[c.dict_count - 1] : 0;
+        if (bytes > uint64_t(data.data() + data.size() - c.dict_bytes)) return false;
+        for (size_t i = 1; i < c.dict_count; ++i) if (c.dict_ends[i] < c.dict_ends[i - 1]) return false;
+        for (uint64_t row = 0; row < rows; ++row) if (c.codes[row] >= c.dict_count) return false;
+    }
+    rows_ = rows;
+    time_ = timeAt ? reinterpret_cast<const int64_t*>(data.data() + timeAt) : nullptr;
+    columns_ = std::move(cols);
+    return true;
+}
+
+} // namespace csvdt
@@ -0,0 +1,296 @@
+// column_detector_main.cpp
+// Command-line front ends for csvdt: the demo (-DCSV_DT_DEMO_MAIN) and the
+// tokenizer microbenchmark (-DCSV_DT_BENCH_MAIN). Without either flag this
+// file compiles to nothing, so `column_detector*.cpp` can be globbed.
+
+#include "column_detector_p.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// -------------------- demo usage --------------------
+#ifdef CSV_DT_DEMO_MAIN
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: smart_datetime_detector <csv-file> [max_rows] [--stratified | --adaptive] [--threads N] [--cache FILE] [--extract] [--stats] [--trace FILE] [--follow] [--range FROM_NS TO_NS] [--columnar]\n";
+        return 1;
+    }
+    std::string path = argv[1];
+    csvdt::Detector::SampleOptions sample;
+    unsigned threads = 1;
+    bool extract = false, adaptive = false;
+    bool stats = false, follow = false, columnar = false;
+    int64_t rangeFrom = 0, rangeTo = 0;
+    std::string cachePath, tracePath;
+    for (int i = 2; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--extract") extract = true;
+        else if (a == "--adaptive") adaptive = true;
+        else if (a == "--cache" && i + 1 < argc) cachePath = argv[++i];
+        else if (a == "--stats") stats = true;
+        else if (a == "--follow") follow = true;
+        else if (a == "--columnar") columnar = true;
+        else if (a == "--range" && i + 2 < argc) { rangeFrom = std::stoll(argv[++i]); rangeTo = std::stoll(argv[++i]); }
+        else if (a == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if (a == "--stratified") sample.mode = csvdt::Detector::SampleMode::Stratified;
+        else if (a == "--threads" && i + 1 < argc) threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        else sample.max_rows = static_cast<size_t>(std::stoul(a));
+    }
+
+    hps::enable(stats || !tracePath.empty());
+    if (!tracePath.empty()) hps::enable_trace(true);
+
+    if (follow) {
+        // Report appended rows until interrupted.
+        csvdt::LogFollower follower(path);
+        follower.subscribe([](const csvdt::LogFollower::Batch &b){
+            if (b.reset) std::cout << "-- truncated or rotated, starting over --\n";
+            if (!b.rows.rows()) return;
+            std::cout << b.rows.rows() << " rows from #" << b.first_row
+                      << " (bytes " << b.begin_offset << ".." << b.end_offset << ")";
+            if (b.timestamps.back() != csvdt::TimestampExtractor::kInvalid) std::cout << ", last=" << b.timestamps.back() << " ns";
+            std::cout << std::endl;
+        });
+        follower.start();
+        for (;;) std::this_thread::sleep_for(std::chrono::hours(1));
+    }
+
+    try {
+        auto run = [&]{
+            if (!adaptive) return csvdt::Detector::detect(csvdt::Detector::read_csv_sample(path, sample), threads);
+            csvdt::Detector::AdaptiveOptions aopt;
+            aopt.max_rows = sample.max_rows;
+            size_t used = 0;
+            auto r = csvdt::Detector::detect_adaptive(path, aopt, &used);
+            std::cout << "Adaptive sample: " << used << " rows\n";
+            return r;
+        };
+        csvdt::DetectionResult res;
+        if (!cachePath.empty()) {
+            csvdt::ResultCache cache(cachePath);
+            res = cache.get_or_detect(path, run);
+            std::cout << (cache.dirty() ? "Cache miss\n" : "Cache hit\n");
+            if (cache.dirty() && !cache.save()) std::cerr << "Cannot save cache: " << cachePath << "\n";
+        } else {
+            res = run();
+        }
+
+        std::cout << "Delimiter: '" << (res.delimiter=='\t' ? ' ' : res.delimiter) << "' (\\t shown as space)\n";
+        std::cout << "Headers:\n";
+        for (auto &d : res.all_columns) {
+            std::cout << "  ["<<d.index<<"] " << d.header << "\n";
+        }
+        std::cout << "\nColumn roles (all):\n";
+        auto role_to_str = [](csvdt::Role r){
+            switch (r) {
+                case csvdt::Role::Date: return "Date";
+                case csvdt::Role::Time: return "Time";
+                case csvdt::Role::DateTime: return "DateTime";
+                case csvdt::Role::EpochSeconds: return "EpochSeconds";
+                case csvdt::Role::EpochMillis: return "EpochMillis";
+                default: return "Unknown";
+            }
+        };
+        auto type_to_str = [](csvdt::ValueType t){
+            switch (t) {
+                case csvdt::ValueType::Int: return "int";
+                case csvdt::ValueType::Float: return "float";
+                case csvdt::ValueType::Bool: return "bool";
+                case csvdt::ValueType::Categorical: return "categorical";
+                default: return "text";
+            }
+        };
+        for (auto &d : res.all_columns) {
+            std::cout << "  ["<<d.index<<"] header='"<<d.header<<"' role="<<role_to_str(d.role)
+                      << " conf="<<std::fixed<<std::setprecision(2)<<d.confidence
+                      << (d.format.empty() ? "" : (" fmt='" + d.format + "'"))
+                      << " type="<<type_to_str(d.value_type);
+            if (d.sentinel) std::cout << " sentinel=" << std::setprecision(0) << *d.sentinel;
+            std::cout << "\n";
+        }
+
+        std::cout << "\nBest mapping:\n";
+        if (res.datetime_col) {
+            auto &d = *res.datetime_col;
+            std::cout << "  DateTime column: #" << d.index << " ('" << d.header << "')";
+            if (d.role==csvdt::Role::EpochSeconds || d.role==csvdt::Role::EpochMillis) {
+                std::cout << " [epoch]\n";
+            } else {
+                std::cout << " fmt='" << d.format << "'\n";
+            }
+        } else {
+            if (res.date_col) {
+                auto &d = *res.date_col;
+                std::cout << "  Date column:    #" << d.index << " ('" << d.header << "') fmt='" << d.format << "'\n";
+            }
+            if (res.time_col) {
+                auto &d = *res.time_col;
+                std::cout << "  Time column:    #" << d.index << " ('" << d.header << "') fmt='" << d.format << "'\n";
+            }
+            if (!res.date_col && !res.time_col) {
+                std::cout << "  (No confident date/time mapping found.)\n";
+            }
+        }
+
+        if (extract) {
+            const auto t0 = std::chrono::steady_clock::now();
+            csvdt::TimestampExtractor::Options opt;
+            opt.threads = threads;
+            const auto ts = csvdt::TimestampExtractor(res, opt).extract(path);
+            const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            const size_t bad = static_cast<size_t>(std::count(ts.begin(), ts.end(), csvdt::TimestampExtractor::kInvalid));
+            std::cout << "\nExtracted " << ts.size() << " timestamps (" << bad << " unparsed) in "
+                      << std::fixed << std::setprecision(3) << sec << " s\n";
+            if (!ts.empty()) std::cout << "  first=" << ts.front() << " ns, last=" << ts.back() << " ns\n";
+        }
+
+        if (rangeFrom < rangeTo) {
+            csvdt::TimeIndex::Options iopt;
+            iopt.threads = threads;
+            const csvdt::TimeIndex index(path, res, iopt);
+            uint64_t bytes = 0;
+            for (auto &r : index.byte_ranges(rangeFrom, rangeTo)) bytes += r.second - r.first;
+            const size_t n = index.query(rangeFrom, rangeTo, [](uint64_t, int64_t, const std::vector<std::string_view>&){ return true; });
+            std::cout << "\nTime index: " << index.blocks().size() << " blocks over " << index.rows() << " rows"
+                      << (index.sorted() ? " (sorted)" : "") << "\n"
+                      << "  " << n << " rows in range, " << bytes << " of " << index.indexed_bytes() << " bytes read\n";
+        }
+
+        if (columnar) {
+            const auto t0 = std::chrono::steady_clock::now();
+            const csvdt::ColumnarCache cols(path, res);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "\nColumnar cache: " << cols.rows() << " rows, " << cols.columns().size() << " columns"
+                      << (cols.timestamps() ? " + time" : "") << ", " << (cols.rebuilt() ? "built" : "mapped")
+                      << " in " << std::fixed << std::setprecision(3) << ms << " ms\n";
+            static const char *const kTypeNames[] = { "f64", "dictionary", "i64", "bool" };
+            for (const auto &c : cols.columns())
+                std::cout << "  " << c.header << ": " << kTypeNames[static_cast<int>(c.type)]
+                          << (c.dict_count ? " (" + std::to_string(c.dict_count) + " values)" : std::string()) << "\n";
+        }
+
+        if (stats) {
+            std::cout << "\nStage timings (us):\n";
+            for (const auto &st : hps::snapshot()) {
+                std::cout << "  " << std::left << std::setw(24) << st.name << std::right
+                          << " calls=" << st.calls;
+                if (st.total_ns)
+                    std::cout << std::fixed << std::setprecision(1)
+                              << " total=" << st.total_ns / 1e3 << " mean=" << st.mean_ns / 1e3
+                              << " p50=" << st.p50_ns / 1e3 << " p99=" << st.p99_ns / 1e3
+                              << " max=" << st.max_ns / 1e3;
+                std::cout << "\n";
+            }
+        }
+        if (!tracePath.empty() && !hps::write_chrome_trace(tracePath))
+            std::cerr << "Could not write trace to " << tracePath << "\n";
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+    return 0;
+}
+#endif
+
+// -------------------- tokenizer microbenchmark --------------------
+#ifdef CSV_DT_BENCH_MAIN
+namespace {
+
+// The pre-tokenizer splitter, kept verbatim as the baseline.
+std::vector<std::string> legacy_split_csv_line(const std::string &line, char delim) {
+    std::vector<std::string> out;
+    std::string cur;
+    bool inQuotes = false;
+    for (size_t i=0;i<line.size();++i) {
+        char c = line[i];
+        if (c == '"') {
+            if (inQuotes && i+1<line.size() && line[i+1]=='"') {
+                cur.push_back('"'); // escaped quote
+                ++i;
+            } else {
+                inQuotes = !inQuotes;
+            }
+        } else if (c == delim && !inQuotes) {
+            out.push_back(cur);
+            cur.clear();
+        } else {
+            cur.push_back(c);
+        }
+    }
+    out.push_back(cur);
+    return out;
+}
+
+std::vector<std::string> make_lines(size_t n, size_t cols, unsigned seed) {
+    std::vector<std::string> lines;
+    lines.reserve(n);
+    unsigned x = seed;
+    auto rnd = [&]{ x = x * 1664525u + 1013904223u; return x >> 8; };
+    for (size_t r=0;r<n;++r) {
+        std::string l;
+        for (size_t c=0;c<cols;++c) {
+            if (c) l.push_back(',');
+            switch (rnd() % 8) {
+                case 0: l += "\"quoted, with delimiter\""; break;
+                case 1: l += "\"say \"\"hi\"\"\""; break;
+                case 2: l += "2023-05-17 12:34:56.789"; break;
+                default: l += std::to_string(rnd() % 100000) + "." + std::to_string(rnd() % 1000); break;
+            }
+        }
+        lines.push_back(std::move(l));
+    }
+    return lines;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t n    = (argc >= 2) ? static_cast<size_t>(std::stoul(argv[1])) : 200000;
+    const size_t cols = (argc >= 3) ? static_cast<size_t>(std::stoul(argv[2])) : 24;
+    const auto lines = make_lines(n, cols, 12345u);
+    size_t bytes = 0;
+    for (auto &l : lines) bytes += l.size() + 1;
+
+    csvdt::CsvTokenizer tok(',');
+    for (auto &l : lines) {
+        const auto &a = tok.split_line(l);
+        const auto b = legacy_split_csv_line(l, ',');
+        if (a.size() != b.size() || !std::equal(a.begin(), a.end(), b.begin())) {
+            std::cerr << "Mismatch on line: " << l << "\n";
+            return 1;
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto run = [&](const char *name, auto &&fn) {
+        size_t sink = 0;
+        const auto t0 = clock::now();
+        for (int rep = 0; rep < 5; ++rep)
+            for (auto &l : lines) sink += fn(l);
+        const double sec = std::chrono::duration<double>(clock::now() - t0).count();
+        std::cout << std::left << std::setw(20) << name
+                  << std::fixed << std::setprecision(1) << (5.0 * bytes / sec / 1e6) << " MB/s"
+                  << "  (" << sink << " fields)\n";
+    };
+    run("legacy splitter", [&](const std::string &l){ return legacy_split_csv_line(l, ',').size(); });
+    run("CsvTokenizer", [&](const std::string &l){ return tok.split_line(l).size(); });
+
+    std::string block;
+    for (auto &l : lines) { block += l; block += '\n'; }
+    {
+        size_t records = 0;
+        const auto t0 = clock::now();
+        for (int rep = 0; rep < 5; ++rep) {
+            size_t pos = 0;
+            while (tok.next_record(block, pos)) records += tok.fields().size();
+        }
+        const double sec = std::chrono::duration<double>(clock::now() - t0).count();
+        std::cout << std::left << std::setw(20) << "CsvTokenizer block"
+                  << std::fixed << std::setprecision(1) << (5.0 * block.size() / sec / 1e6) << " MB/s"
+                  << "  (" << records << " fields)\n";
+    }
+    return 0;
+}
+#endif
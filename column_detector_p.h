@@ -0,0 +1,1199 @@
+#pragma once
+// column_detector_p.h
+// csvdt internals shared by the column_detector*.cpp sources and the
+// benchmarks: tokenizer, compiled format matchers, value scanning and typing,
+// thread pool, file mapping, decoding and sidecar I/O helpers. Not part of the
+// API (see column_detector.h). The hot paths stay inline here so every source
+// that parses rows gets them inlined.
+
+#include "column_detector.h"
+#include "HotPathStats.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+// SIMD level for the tokenizer is picked at compile time (-mavx2 etc.);
+// x86-64 always has SSE2, everything else uses the scalar loop.
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define CSVDT_SIMD_AVX2 1
+#  define CSVDT_SIMD_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define CSVDT_SIMD_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace csvdt {
+
+// --- instrumentation --------------------------------------------------------
+//
+// Stage timings reported through HotPathStats.h (off unless hps::enable).
+// With mmap'd input, page-in cost shows up in csvdt.tokenize rather than
+// csvdt.map.
+
+namespace stats {
+inline const hps::StageId kMap      = hps::stage("csvdt.map");
+inline const hps::StageId kTokenize = hps::stage("csvdt.tokenize");
+inline const hps::StageId kScore[]  = { hps::stage("csvdt.score.epoch"), hps::stage("csvdt.score.date"),
+                                        hps::stage("csvdt.score.time"), hps::stage("csvdt.score.datetime"),
+                                        hps::stage("csvdt.score.isolike") };
+inline const hps::StageId kProbes   = hps::stage("csvdt.format_probes");
+inline const hps::StageId kDecide   = hps::stage("csvdt.decide");
+inline const hps::StageId kAdaptive = hps::stage("csvdt.detect_adaptive");
+inline const hps::StageId kExtract  = hps::stage("csvdt.extract_chunk");
+inline const hps::StageId kFollow   = hps::stage("csvdt.follow.update");
+inline const hps::StageId kTypes    = hps::stage("csvdt.value_types");
+inline const hps::StageId kSchemaCheck = hps::stage("csvdt.schema.check");
+inline const hps::StageId kSchemaHits  = hps::stage("csvdt.schema.reused");
+}
+
+// --- small helpers ----------------------------------------------------------
+
+inline std::string_view trim_view(std::string_view s) {
+    size_t a = 0, b = s.size();
+    while (a < b && std::isspace(static_cast<unsigned char>(s[a]))) ++a;
+    while (b > a && std::isspace(static_cast<unsigned char>(s[b-1]))) --b;
+    return s.substr(a, b - a);
+}
+
+inline std::string tolower_copy(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return std::tolower(c); });
+    return s;
+}
+
+inline char sniff_delimiter(const std::string &headerLine) {
+    // Look for common delimiters; choose the one with the most occurrences
+    const std::array<char,4> cands{',',';','\t','|'};
+    size_t bestCount = 0;
+    char best = ',';
+    for (char d : cands) {
+        size_t cnt = std::count(headerLine.begin(), headerLine.end(), d);
+        if (cnt > bestCount) { bestCount = cnt; best = d; }
+    }
+    return best;
+}
+
+// --- tokenizer --------------------------------------------------------------
+
+#if defined(CSVDT_SIMD_SSE2)
+inline unsigned lowest_bit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long i; _BitScanForward(&i, mask); return static_cast<unsigned>(i);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+// First byte in [p,end) equal to a, b or c (end if none).
+inline const char *find_special(const char *p, const char *end, char a, char b, char c) {
+#if defined(CSVDT_SIMD_AVX2)
+    {
+        const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b), vc = _mm256_set1_epi8(c);
+        for (; end - p >= 32; p += 32) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, va),
+                                                              _mm256_cmpeq_epi8(x, vb)),
+                                              _mm256_cmpeq_epi8(x, vc));
+            const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+            if (mask) return p + lowest_bit(mask);
+        }
+    }
+#endif
+#if defined(CSVDT_SIMD_SSE2)
+    {
+        const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c);
+        for (; end - p >= 16; p += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                           _mm_cmpeq_epi8(x, vc));
+            const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+            if (mask) return p + lowest_bit(mask);
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == a || *p == b || *p == c) return p;
+    }
+    return end;
+}
+
+// Zero-copy CSV tokenizer. Fields come back as string_views into the caller's
+// buffer; only fields whose quoting must be rewritten ("" escapes, quotes in
+// the middle of a field) are materialized into a scratch buffer owned by the
+// tokenizer. Views stay valid until the next split on the same tokenizer.
+//
+// Quote handling is the same as the old per-char splitter: a quote toggles
+// quoted mode, "" inside quotes is a literal quote, delimiters inside quotes
+// are content.
+class CsvTokenizer {
+public:
+    explicit CsvTokenizer(char delim = ',') : delim_(delim) {}
+
+    void set_delimiter(char d) { delim_ = d; }
+    char delimiter() const { return delim_; }
+
+    // Split one line; newline bytes have no special meaning.
+    const std::vector<std::string_view> &split_line(std::string_view line) {
+        split<false>(line, 0);
+        return fields_;
+    }
+
+    // Split the record starting at `pos` inside a block buffer. An unquoted
+    // '\n' (with an optional preceding '\r') ends the record; newlines inside
+    // quotes belong to the field. Advances `pos` past the terminator.
+    bool next_record(std::string_view block, size_t &pos) {
+        if (pos >= block.size()) return false;
+        pos = split<true>(block, pos);
+        return true;
+    }
+
+    const std::vector<std::string_view> &fields() const { return fields_; }
+
+private:
+    template <bool Block>
+    size_t split(std::string_view buf, size_t pos) {
+        fields_.clear();
+        scratch_.clear();
+        spilled_.clear();
+
+        const char *const base = buf.data();
+        const char *const end = base + buf.size();
+        const char nl = Block ? '\n' : delim_;
+        const char *p = base + pos;
+
+        for (;;) {
+            const char *start = p;
+            const char *hit = find_special(p, end, delim_, '"', nl);
+
+            if (hit == end || *hit != '"') {
+                // Fast path: no quotes in this field.
+                fields_.emplace_back(start, static_cast<size_t>(hit - start));
+                if (hit == end) return trim_cr<Block>(buf.size());
+                if (Block && *hit == '\n') return trim_cr<Block>(static_cast<size_t>(hit - base) + 1);
+                p = hit + 1;
+                continue;
+            }
+
+            // "abc" followed by a terminator: view between the quotes.
+            if (hit == start) {
+                const char *q = static_cast<const char*>(std::memchr(start + 1, '"', static_cast<size_t>(end - start - 1)));
+                if (q && (q + 1 == end || q[1] == delim_ || (Block && q[1] == '\n'))) {
+                    fields_.emplace_back(start + 1, static_cast<size_t>(q - start - 1));
+                    p = q + 1;
+                    if (p == end) return trim_cr<Block>(buf.size());
+                    if (Block && *p == '\n') return trim_cr<Block>(static_cast<size_t>(p - base) + 1);
+                    ++p;
+                    continue;
+                }
+            }
+
+            // General case: rebuild the field into scratch.
+            const size_t off = scratch_.size();
+            bool inQuotes = false;
+            p = start;
+            for (;;) {
+                if (inQuotes) {
+                    const char *q = static_cast<const char*>(std::memchr(p, '"', static_cast<size_t>(end - p)));
+                    if (!q) { scratch_.append(p, end); p = end; break; }
+                    scratch_.append(p, q);
+                    if (q + 1 < end && q[1] == '"') { scratch_.push_back('"'); p = q + 2; }
+                    else { inQuotes = false; p = q + 1; }
+                } else {
+                    const char *h = find_special(p, end, delim_, '"', nl);
+                    scratch_.append(p, h);
+                    p = h;
+                    if (h == end || *h != '"') break;
+                    inQuotes = true;
+                    ++p;
+                }
+            }
+            spilled_.push_back({fields_.size(), off, scratch_.size() - off});
+            fields_.emplace_back();
+
+            if (p == end) return trim_cr<Block>(buf.size());
+            if (Block && *p == '\n') return trim_cr<Block>(static_cast<size_t>(p - base) + 1);
+            ++p;
+        }
+    }
+
+    // Record is complete: drop a CR left by a CRLF terminator (block mode only;
+    // line mode keeps bytes exactly as given) and point spilled fields at scratch.
+    template <bool Block>
+    size_t trim_cr(size_t next) {
+        fix_spilled();
+        if (Block && !fields_.empty()) {
+            auto &last = fields_.back();
+            if (!last.empty() && last.back() == '\r') last.remove_suffix(1);
+        }
+        return next;
+    }
+
+    void fix_spilled() {
+        for (auto &sp : spilled_) fields_[sp.field] = std::string_view(scratch_.data() + sp.off, sp.len);
+    }
+
+    struct Spill { size_t field, off, len; };
+
+    char delim_;
+    std::vector<std::string_view> fields_;
+    std::string scratch_;           // unescaped copies of rewritten fields
+    std::vector<Spill> spilled_;    // fields living in scratch_ (fixed up per record)
+};
+
+// Owning split, for the few places that keep the strings (headers).
+inline std::vector<std::string> split_csv_line(const std::string &line, char delim) {
+    CsvTokenizer tok(delim);
+    const auto &f = tok.split_line(line);
+    return std::vector<std::string>(f.begin(), f.end());
+}
+
+// Length of the prefix of `buf` made of complete records: up to the last
+// newline outside quotes. `buf` must start on a record boundary. Used where
+// a file is still being written and its last record may be partial.
+inline size_t complete_prefix(std::string_view buf) {
+    const char *const base = buf.data(), *const end = base + buf.size();
+    bool quoted = false;
+    size_t cut = 0;
+    for (const char *p = base; (p = find_special(p, end, '"', '\n', '\n')) < end; ++p) {
+        if (*p == '"') quoted = !quoted;
+        else if (!quoted) cut = static_cast<size_t>(p - base) + 1;
+    }
+    return cut;
+}
+
+// --- compiled format matchers -----------------------------------------------
+//
+// The strftime-style patterns used by the detector are compiled (at compile
+// time for the built-in banks) into short op lists and matched without any
+// allocation. Matching mirrors what std::get_time / libstdc++ time_get::get
+// accepted when it was used here:
+//  - leading whitespace is skipped; a format space skips any run of spaces
+//  - numbers take up to N digits and stop early once the value exceeds the
+//    field maximum; %d may be preceded by one space (" 5")
+//  - %b and %p match full or abbreviated names case-insensitively
+//  - literals compare case-insensitively
+//  - input ending right after a conversion is a (partial) match; trailing
+//    input after the last directive is ignored
+
+struct DateTimeFields {
+    int year{1900}, month{1}, day{0};
+    int hour{0}, minute{0}, second{0};
+};
+
+constexpr bool is_space_c(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+constexpr CompiledFormat compile_format(std::string_view fmt) {
+    CompiledFormat cf{};
+    cf.text = fmt;
+    auto push = [&cf](CompiledFormat::Op op, char ch) {
+        if (cf.count == cf.steps.size()) { cf.valid = false; return; }
+        cf.steps[cf.count].op = op;
+        cf.steps[cf.count].ch = ch;
+        ++cf.count;
+    };
+    for (size_t i = 0; i < fmt.size(); ++i) {
+        const char c = fmt[i];
+        if (c == '%') {
+            if (++i == fmt.size()) { cf.valid = false; break; }
+            switch (fmt[i]) {
+                case 'Y': push(CompiledFormat::Year, 0); break;
+                case 'm': push(CompiledFormat::Month, 0); break;
+                case 'd': push(CompiledFormat::Day, 0); break;
+                case 'H': push(CompiledFormat::Hour, 0); break;
+                case 'I': push(CompiledFormat::Hour12, 0); break;
+                case 'M': push(CompiledFormat::Minute, 0); break;
+                case 'S': push(CompiledFormat::Second, 0); break;
+                case 'b': push(CompiledFormat::MonthName, 0); break;
+                case 'p': push(CompiledFormat::AmPm, 0); break;
+                case '%': push(CompiledFormat::Lit, '%'); break;
+                default:  cf.valid = false; break;
+            }
+        } else if (is_space_c(c)) {
+            push(CompiledFormat::Space, 0);
+            while (i + 1 < fmt.size() && is_space_c(fmt[i+1])) ++i;
+        } else {
+            push(CompiledFormat::Lit, c);
+        }
+    }
+    return cf;
+}
+
+template <size_t N>
+constexpr std::array<CompiledFormat, N> compile_formats(const std::array<std::string_view, N> &fmts) {
+    std::array<CompiledFormat, N> out{};
+    for (size_t i = 0; i < N; ++i) out[i] = compile_format(fmts[i]);
+    return out;
+}
+
+inline char lower_c(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Up to `len` digits, stopping before a digit that would push past `max`.
+inline bool match_number(std::string_view s, size_t &i, int min, int max, size_t len, int &out) {
+    size_t k = 0;
+    int v = 0;
+    while (i < s.size() && k < len) {
+        const char c = s[i];
+        if (c < '0' || c > '9') break;
+        v = v * 10 + (c - '0');
+        if (v > max) break;
+        ++i; ++k;
+    }
+    if (k == 0 || v < min || v > max) return false;
+    out = v;
+    return true;
+}
+
+// Longest case-insensitive match among `names`; returns the index or -1.
+template <size_t N>
+inline int match_name(std::string_view s, size_t &i, const std::array<std::string_view, N> &names) {
+    bool alive[N];
+    for (size_t n = 0; n < N; ++n) alive[n] = true;
+    size_t pos = 0;
+    for (;;) {
+        if (i + pos >= s.size()) break;
+        const char c = lower_c(s[i + pos]);
+        bool any = false;
+        for (size_t n = 0; n < N; ++n) {
+            if (alive[n] && names[n].size() > pos && lower_c(names[n][pos]) == c) any = true;
+        }
+        if (!any) break;
+        for (size_t n = 0; n < N; ++n) {
+            alive[n] = alive[n] && names[n].size() > pos && lower_c(names[n][pos]) == c;
+        }
+        ++pos;
+    }
+    for (size_t n = 0; n < N; ++n) {
+        if (alive[n] && names[n].size() == pos) { i += pos; return static_cast<int>(n); }
+    }
+    return -1;
+}
+
+inline constexpr std::array<std::string_view, 24> kMonthNames = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
+    "January", "February", "March", "April", "May", "June",
+    "July", "August", "September", "October", "November", "December"
+};
+inline constexpr std::array<std::string_view, 2> kAmPm = { "AM", "PM" };
+
+// Match `value` against a compiled format; fills `out` on success. With
+// `exact`, partial matches and trailing input are rejected (full-file
+// parsing wants the whole value, detection keeps get_time's leniency).
+inline bool try_get_time(std::string_view value, const CompiledFormat &fmt, DateTimeFields *out = nullptr,
+                         bool exact = false) {
+    if (!fmt.valid) return false;
+    size_t i = 0;
+    const size_t n = value.size();
+    while (i < n && is_space_c(value[i])) ++i;
+    if (i == n) return false;
+
+    DateTimeFields f;
+    int hour12 = -1, pm = 0;
+    bool eof = false;
+    for (size_t k = 0; k < fmt.count; ++k) {
+        if (eof) {
+            if (exact) return false;
+            break;
+        }
+        if (i == n) return false;
+        const auto &st = fmt.steps[k];
+        bool ok = true;
+        switch (st.op) {
+            case CompiledFormat::Lit:
+                if (lower_c(value[i]) != lower_c(st.ch)) return false;
+                ++i;
+                continue;
+            case CompiledFormat::Space:
+                while (i < n && is_space_c(value[i])) ++i;
+                continue;
+            case CompiledFormat::Year:   ok = match_number(value, i, 0, 9999, 4, f.year); break;
+            case CompiledFormat::Month:  ok = match_number(value, i, 1, 12, 2, f.month); break;
+            case CompiledFormat::Day:
+                if (is_space_c(value[i])) ++i;
+                ok = match_number(value, i, 1, 31, 2, f.day);
+                break;
+            case CompiledFormat::Hour:   ok = match_number(value, i, 0, 23, 2, f.hour); break;
+            case CompiledFormat::Hour12: ok = match_number(value, i, 1, 12, 2, hour12); break;
+            case CompiledFormat::Minute: ok = match_number(value, i, 0, 59, 2, f.minute); break;
+            case CompiledFormat::Second: ok = match_number(value, i, 0, 60, 2, f.second); break;
+            case CompiledFormat::MonthName: {
+                const int m = match_name(value, i, kMonthNames);
+                ok = m >= 0;
+                if (ok) f.month = m % 12 + 1;
+                break;
+            }
+            case CompiledFormat::AmPm: {
+                const int m = match_name(value, i, kAmPm);
+                ok = m >= 0;
+                if (ok) pm = m;
+                break;
+            }
+        }
+        if (!ok) return false;
+        eof = (i == n);
+    }
+    if (exact && i != n) return false;
+    if (hour12 >= 0) f.hour = hour12 % 12 + (pm ? 12 : 0);
+    if (out) *out = f;
+    return true;
+}
+
+// Candidate format banks
+inline constexpr std::array<std::string_view, 8> kDateFormatText = {
+    "%Y-%m-%d", "%Y/%m/%d", "%m/%d/%Y", "%d/%m/%Y", "%d.%m.%Y",
+    "%d-%b-%Y", "%b %d, %Y", "%Y%m%d"
+};
+inline constexpr std::array<std::string_view, 6> kTimeFormatText = {
+    "%H:%M:%S", "%H:%M", "%I:%M:%S %p", "%I:%M %p", "%H%M%S", "%H%M"
+};
+// Some common datetime mixes (we also try ISO-ish via normalization)
+inline constexpr std::array<std::string_view, 12> kDateTimeFormatText = {
+    "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M",
+    "%m/%d/%Y %H:%M:%S", "%m/%d/%Y %H:%M",
+    "%d/%m/%Y %H:%M:%S", "%d/%m/%Y %H:%M",
+    "%Y/%m/%d %H:%M:%S", "%Y/%m/%d %H:%M",
+    "%d-%b-%Y %H:%M:%S", "%d-%b-%Y %H:%M",
+    "%Y%m%d %H%M%S", "%Y-%m-%d_%H-%M-%S"
+};
+// ISO-like (we normalize then try)
+inline constexpr std::array<std::string_view, 4> kIsoLikeFormatText = {
+    "%Y-%m-%dT%H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M"
+};
+
+inline constexpr auto kDateFormats     = compile_formats(kDateFormatText);
+inline constexpr auto kTimeFormats     = compile_formats(kTimeFormatText);
+inline constexpr auto kDateTimeFormats = compile_formats(kDateTimeFormatText);
+inline constexpr auto kIsoLikeFormats  = compile_formats(kIsoLikeFormatText);
+
+// --- value scanning ---------------------------------------------------------
+//
+// One pass over a sample value, in place. The ISO-like formats are matched
+// against `iso_core`: the trimmed value minus a trailing 'Z', a +hh:mm /
+// +hhmm offset and trailing fractional seconds. The stripped parts are kept
+// (offset, fraction) so full-file parsing doesn't have to look again.
+
+struct ValueScan {
+    std::string_view value;     // trimmed input
+    std::string_view iso_core;  // value without Z / offset / fraction
+    size_t digit_run{0};        // leading digits of `value`
+    bool all_digits{false};     // value is non-empty and only digits
+    bool zulu{false};           // trailing Z
+    bool has_offset{false};     // trailing Z or numeric offset
+    int offset_minutes{0};      // east of UTC, e.g. +05:30 -> 330
+    int frac_digits{0};         // 0 if no fraction; capped at 9
+    int32_t frac_nanos{0};      // fraction scaled to nanoseconds
+};
+
+inline bool is_digit_c(char c) { return c >= '0' && c <= '9'; }
+
+inline ValueScan scan_value(std::string_view raw) {
+    ValueScan r;
+    std::string_view v = trim_view(raw);
+    r.value = v;
+    while (r.digit_run < v.size() && is_digit_c(v[r.digit_run])) ++r.digit_run;
+    r.all_digits = !v.empty() && r.digit_run == v.size();
+    if (r.all_digits) { r.iso_core = v; return r; }
+
+    auto digits_at = [&](size_t pos, size_t n) {
+        for (size_t k = 0; k < n; ++k) if (!is_digit_c(v[pos + k])) return false;
+        return true;
+    };
+    auto two = [&](size_t pos) { return (v[pos] - '0') * 10 + (v[pos+1] - '0'); };
+
+    if (!v.empty() && (v.back() == 'Z' || v.back() == 'z')) {
+        v = trim_view(v.substr(0, v.size() - 1));
+        r.zulu = r.has_offset = true;
+    }
+    // +hh:mm, then +hhmm (both are stripped if stacked, as before)
+    const size_t n = v.size();
+    if (n >= 6 && (v[n-6] == '+' || v[n-6] == '-') && digits_at(n-5, 2) && v[n-3] == ':' && digits_at(n-2, 2)) {
+        const int mins = two(n-5) * 60 + two(n-2);
+        r.offset_minutes = v[n-6] == '-' ? -mins : mins;
+        r.has_offset = true;
+        v.remove_suffix(6);
+    }
+    const size_t m = v.size();
+    if (m >= 5 && (v[m-5] == '+' || v[m-5] == '-') && digits_at(m-4, 4)) {
+        const int mins = two(m-4) * 60 + two(m-2);
+        r.offset_minutes = v[m-5] == '-' ? -mins : mins;
+        r.has_offset = true;
+        v.remove_suffix(5);
+    }
+    v = trim_view(v);
+
+    // Trailing ".sss" (fraction digits beyond nanoseconds are dropped)
+    size_t d = v.size();
+    while (d > 0 && is_digit_c(v[d-1])) --d;
+    if (d > 0 && d < v.size() && v[d-1] == '.') {
+        const size_t digits = v.size() - d;
+        r.frac_digits = static_cast<int>(std::min<size_t>(digits, 9));
+        int32_t ns = 0;
+        for (int k = 0; k < 9; ++k) ns = ns * 10 + (k < r.frac_digits ? v[d + k] - '0' : 0);
+        r.frac_nanos = ns;
+        v = v.substr(0, d - 1);
+    }
+    r.iso_core = v;
+    return r;
+}
+
+struct FormatHit {
+    const CompiledFormat *fmt;
+    size_t hits{};
+};
+
+inline bool is_epoch_seconds(const ValueScan &v) { return v.all_digits && v.digit_run == 10; }
+inline bool is_epoch_millis(const ValueScan &v)  { return v.all_digits && v.digit_run == 13; }
+
+// Score a column against candidate formats; return best format and score
+template <size_t N>
+inline std::pair<std::string_view,double> best_format_for(
+    const ColumnView &samples,
+    const std::array<CompiledFormat, N> &formats,
+    bool normalize_iso=false)
+{
+    std::array<FormatHit, N> tally{};
+    for (size_t i = 0; i < N; ++i) tally[i].fmt = &formats[i];
+
+    size_t nonEmpty = 0;
+    for (size_t r = 0; r < samples.size(); ++r) {
+        std::string_view s = trim_view(samples[r]);
+        if (s.empty()) continue;
+        ++nonEmpty;
+        if (normalize_iso) s = scan_value(s).iso_core;
+        for (auto &fh : tally) {
+            if (try_get_time(s, *fh.fmt)) {
+                fh.hits++;
+            }
+        }
+    }
+    hps::count(stats::kProbes, nonEmpty * N);
+    // If column is empty in all sample rows, avoid division by zero
+    if (nonEmpty == 0) return {"", 0.0};
+
+    // Pick best
+    auto it = std::max_element(tally.begin(), tally.end(),
+        [](const FormatHit&a, const FormatHit&b){ return a.hits < b.hits; });
+
+    double score = static_cast<double>(it->hits) / static_cast<double>(nonEmpty);
+    return {it->fmt->text, score};
+}
+
+// The five independent scoring passes run for every column. Each is a
+// separate work item when detection runs on a pool.
+enum class Bank { Epoch, Date, Time, DateTime, IsoLike, Count };
+
+struct BankScore {
+    std::string_view fmt;
+    double score{0.0};
+    double score_ms{0.0}; // Bank::Epoch only: score is seconds, this is millis
+};
+
+inline BankScore score_bank(const ColumnView &samples, Bank bank) {
+    switch (bank) {
+        case Bank::Epoch: {
+            size_t nonEmpty=0, secHits=0, msHits=0;
+            for (size_t r = 0; r < samples.size(); ++r) {
+                const ValueScan x = scan_value(samples[r]);
+                if (x.value.empty()) continue;
+                ++nonEmpty;
+                if (is_epoch_seconds(x)) ++secHits;
+                else if (is_epoch_millis(x)) ++msHits;
+            }
+            BankScore b;
+            b.score    = nonEmpty? double(secHits)/nonEmpty : 0.0;
+            b.score_ms = nonEmpty? double(msHits)/nonEmpty : 0.0;
+            return b;
+        }
+        case Bank::Date:     { auto [f, sc] = best_format_for(samples, kDateFormats, false);     return {f, sc}; }
+        case Bank::Time:     { auto [f, sc] = best_format_for(samples, kTimeFormats, false);     return {f, sc}; }
+        case Bank::DateTime: { auto [f, sc] = best_format_for(samples, kDateTimeFormats, false); return {f, sc}; }
+        case Bank::IsoLike:  { auto [f, sc] = best_format_for(samples, kIsoLikeFormats, true);   return {f, sc}; }
+        case Bank::Count: break;
+    }
+    return {};
+}
+
+// Header “prior” boost
+inline double header_prior(const std::string &hdr, Role role) {
+    std::string h = tolower_copy(hdr);
+    auto has = [&](std::initializer_list<const char*> kws){
+        for (auto k: kws) if (h.find(k) != std::string::npos) return true;
+        return false;
+    };
+    double bonus = 0.0;
+    if (role == Role::DateTime) {
+        if (has({"datetime","timestamp","ts","date_time","date-time"})) bonus += 0.15;
+    }
+    if (role == Role::Date) {
+        if (has({"date","day","ymd","mdy","dmy"})) bonus += 0.10;
+    }
+    if (role == Role::Time) {
+        if (has({"time","hour","minute","second"})) bonus += 0.10;
+    }
+    // UTC hints
+    if (has({"utc","zulu","tz"})) bonus += 0.05;
+    return bonus;
+}
+
+// --- value types ------------------------------------------------------------
+//
+// Every column is also typed from the sample: Bool, Int, Float, Categorical
+// (few distinct strings) or Text. Missing markers (empty, NA, N/A, NaN,
+// null, None, -, --, ?) never count against a type. A numeric column may
+// also carry a sentinel for missing data: one of the usual logger codes
+// (-9999, 9999, -32768, ...) whose magnitude is at least ten times that of
+// every other sampled value. The parse_*_column functions convert whole
+// columns with the same rules, straight from the cells into typed arrays.
+
+inline bool equals_nocase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) if (lower_c(a[i]) != lower_c(b[i])) return false;
+    return true;
+}
+
+// `s` trimmed.
+inline bool is_missing_token(std::string_view s) {
+    if (s.empty()) return true;
+    if (s.size() > 4) return false;
+    for (std::string_view m : {"na", "n/a", "nan", "null", "none", "-", "--", "?"})
+        if (equals_nocase(s, m)) return true;
+    return false;
+}
+
+// 1 / 0 for true / false words, -1 otherwise. 0/1 digits are Int, not Bool.
+inline int bool_token(std::string_view s) {
+    if (s.size() > 5) return -1;
+    for (std::string_view t : {"true", "yes", "on", "t", "y"}) if (equals_nocase(s, t)) return 1;
+    for (std::string_view f : {"false", "no", "off", "f", "n"}) if (equals_nocase(s, f)) return 0;
+    return -1;
+}
+
+// Every byte in [p, end) is an ASCII digit. Cells of one column are stored
+// back to back in the sample arena, so an all-digit column is validated in
+// one pass and its cells then parsed without per-byte checks.
+inline bool all_digits(const char *p, const char *end) {
+#if defined(CSVDT_SIMD_SSE2)
+    const __m128i lo = _mm_set1_epi8('0' - 1), hi = _mm_set1_epi8('9' + 1);
+    for (; end - p >= 16; p += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(x, lo), _mm_cmplt_epi8(x, hi));
+        if (_mm_movemask_epi8(ok) != 0xFFFF) return false;
+    }
+#endif
+    for (; p < end; ++p) if (!is_digit_c(*p)) return false;
+    return true;
+}
+
+// Whole-cell integer (optional sign, surrounding spaces); false otherwise.
+inline bool parse_int_cell(std::string_view s, int64_t &out) {
+    s = trim_view(s);
+    if (!s.empty() && s[0] == '+') {
+        s.remove_prefix(1);
+        if (!s.empty() && s[0] == '-') return false; // from_chars would take "+-5" as -5
+    }
+    if (s.empty()) return false;
+    const auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+// Whole-cell decimal/scientific number, inf or nan; false otherwise.
+inline bool parse_float_cell(std::string_view s, double &out) {
+    s = trim_view(s);
+    if (!s.empty() && s[0] == '+') {
+        s.remove_prefix(1);
+        if (!s.empty() && s[0] == '-') return false;
+    }
+    if (s.empty()) return false;
+    const auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+inline constexpr double kSentinels[] = {-9999.0, 9999.0, -99999.0, 99999.0, -999.0, 999.0,
+                                        -32768.0, 32767.0, 65535.0, -1e30, 1e30};
+
+struct ValueProfile {
+    ValueType type{ValueType::Text};
+    std::optional<double> sentinel;
+};
+
+// Streaming type inference over one column's cells.
+class ValueTyper {
+public:
+    void feed(std::string_view cell) {
+        const std::string_view s = trim_view(cell);
+        if (is_missing_token(s)) return;
+        ++n_;
+        if (bool_token(s) >= 0) ++bools_;
+        int64_t i;
+        double d;
+        if (parse_int_cell(s, i)) { ++ints_; number(double(i)); }
+        else if (parse_float_cell(s, d)) { ++floats_; number(d); }
+        if (distinct_.size() <= kMaxCategories) {  // stops growing once too many
+            std::string key(s);
+            if (!distinct_.count(key)) distinct_.insert(std::move(key));
+        }
+    }
+
+    ValueProfile result() const {
+        ValueProfile p;
+        if (n_ == 0) return p;
+        if (bools_ == n_) p.type = ValueType::Bool;
+        else if (ints_ == n_) p.type = ValueType::Int;
+        else if (ints_ + floats_ == n_) p.type = ValueType::Float;
+        else if (distinct_.size() <= std::min(kMaxCategories, std::max<size_t>(2, n_ / 4))) p.type = ValueType::Categorical;
+        if (p.type != ValueType::Int && p.type != ValueType::Float) return p;
+
+        // Most frequent sentinel candidate that dwarfs everything else.
+        size_t best = 0;
+        for (size_t k = 0; k < std::size(kSentinels); ++k) {
+            if (!hits_[k] || hits_[k] == n_ || std::fabs(kSentinels[k]) < 10.0 * max_abs_) continue;
+            if (!p.sentinel || hits_[k] > best) { p.sentinel = kSentinels[k]; best = hits_[k]; }
+        }
+        return p;
+    }
+
+private:
+    static constexpr size_t kMaxCategories = 32;
+
+    void number(double v) {
+        for (size_t k = 0; k < std::size(kSentinels); ++k) {
+            if (v == kSentinels[k]) { ++hits_[k]; return; }
+        }
+        max_abs_ = std::max(max_abs_, std::fabs(v));
+    }
+
+    size_t n_{0}, bools_{0}, ints_{0}, floats_{0};
+    double max_abs_{0.0};  // over values that are not sentinel candidates
+    std::array<size_t, std::size(kSentinels)> hits_{};
+    std::unordered_set<std::string> distinct_;
+};
+
+// Cell is missing for `col`: a missing marker or its sentinel.
+inline bool is_missing_value(std::string_view trimmed, double v, const DetectedColumn &col) {
+    return is_missing_token(trimmed) || (col.sentinel && v == *col.sentinel);
+}
+
+// Float column -> out[r] (NaN where missing or unparsed). Returns the count
+// of values parsed.
+template <class Cells>
+inline size_t parse_float_column(const Cells &cells, const DetectedColumn &col, std::vector<double> &out) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    out.resize(cells.size());
+    size_t good = 0;
+    for (size_t r = 0; r < cells.size(); ++r) {
+        double v;
+        const std::string_view s = cells[r];
+        if (!parse_float_cell(s, v) || is_missing_value(trim_view(s), v, col)) { out[r] = nan; continue; }
+        out[r] = v;
+        ++good;
+    }
+    return good;
+}
+
+// Int column -> out[r], valid[r] = 0 where missing or unparsed (out[r] = 0).
+template <class Cells>
+inline size_t parse_int_column(const Cells &cells, const DetectedColumn &col, std::vector<int64_t> &out,
+                               std::vector<uint8_t> &valid) {
+    out.assign(cells.size(), 0);
+    valid.assign(cells.size(), 0);
+    size_t good = 0;
+    for (size_t r = 0; r < cells.size(); ++r) {
+        int64_t v;
+        const std::string_view s = cells[r];
+        if (!parse_int_cell(s, v) || is_missing_value(trim_view(s), double(v), col)) continue;
+        out[r] = v;
+        valid[r] = 1;
+        ++good;
+    }
+    return good;
+}
+
+// Sampled columns: when the whole column is unsigned digits (one SIMD pass
+// over its arena span) and no cell can overflow, cells are summed directly.
+inline size_t parse_int_column(const ColumnView &cells, const DetectedColumn &col, std::vector<int64_t> &out,
+                               std::vector<uint8_t> &valid) {
+    const char *begin = cells.arena + (cells.rows ? cells.offsets[0] : 0);
+    const char *end = cells.arena + (cells.rows ? cells.offsets[cells.rows] : 0);
+    bool fast = cells.rows > 0 && all_digits(begin, end);
+    for (size_t r = 0; fast && r < cells.rows; ++r) {
+        const size_t n = cells.offsets[r + 1] - cells.offsets[r];
+        fast = n > 0 && n <= 18;
+    }
+    if (!fast) return parse_int_column<ColumnView>(cells, col, out, valid);
+
+    out.resize(cells.rows);
+    valid.assign(cells.rows, 1);
+    size_t good = cells.rows;
+    for (size_t r = 0; r < cells.rows; ++r) {
+        int64_t v = 0;
+        for (const char *p = cells.arena + cells.offsets[r], *e = cells.arena + cells.offsets[r + 1]; p < e; ++p)
+            v = v * 10 + (*p - '0');
+        out[r] = v;
+        if (col.sentinel && double(v) == *col.sentinel) { out[r] = 0; valid[r] = 0; --good; }
+    }
+    return good;
+}
+
+// Bool column -> out[r] = 1 / 0, or kMissingBool.
+inline constexpr uint8_t kMissingBool = 0xFF;
+
+template <class Cells>
+inline size_t parse_bool_column(const Cells &cells, std::vector<uint8_t> &out) {
+    out.resize(cells.size());
+    size_t good = 0;
+    for (size_t r = 0; r < cells.size(); ++r) {
+        const int b = bool_token(trim_view(cells[r]));
+        out[r] = b < 0 ? kMissingBool : uint8_t(b);
+        good += b >= 0;
+    }
+    return good;
+}
+
+// --- threads & file mapping -------------------------------------------------
+
+// Small fixed-size work-stealing pool for data-parallel loops. parallel_for
+// gives every participant (the workers plus the calling thread) a
+// contiguous slice of the index range; whoever runs out steals the back half
+// of another participant's remaining slice. It returns once every index has
+// run; the first exception thrown by a task is rethrown on the caller. A
+// pool already running a loop (for another caller, or from inside one of its
+// own tasks) runs the new one on the calling thread instead of waiting.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 1; i < threads; ++i) workers_.emplace_back([this, i]{ worker_loop(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto &t : workers_) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool of `threads` participants (0 = hardware concurrency),
+    // created on first use, for callers that run many short loops.
+    static ThreadPool &shared(unsigned threads);
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    template <class F>
+    void parallel_for(size_t n, F &&fn) {
+        if (n == 0) return;
+        if (workers_.empty() || n == 1 || n > UINT32_MAX || busy_.exchange(true, std::memory_order_acquire)) {
+            for (size_t i = 0; i < n; ++i) fn(i);
+            return;
+        }
+        struct Release {
+            std::atomic<bool> &busy;
+            ~Release() { busy.store(false, std::memory_order_release); }
+        } release{busy_};
+        Job job(size(), n);
+        job.fn = [&fn](size_t i){ fn(i); };
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            job_ = &job;
+            ++generation_;
+        }
+        cv_.notify_all();
+        run(job, 0);
+        std::unique_lock<std::mutex> lk(mu_);
+        done_cv_.wait(lk, [&]{ return job.done == job.n && job.active == 0; });
+        job_ = nullptr;
+        lk.unlock();
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+private:
+    // [begin, end) packed into one word so owner pops and steals are a CAS.
+    struct alignas(64) Slice {
+        std::atomic<uint64_t> range{0};
+    };
+    static uint64_t pack(uint64_t b, uint64_t e) { return (e << 32) | b; }
+    static uint64_t lo(uint64_t r) { return r & 0xffffffffu; }
+    static uint64_t hi(uint64_t r) { return r >> 32; }
+
+    struct Job {
+        Job(unsigned parts, size_t count) : n(count), slices(parts) {
+            for (unsigned p = 0; p < parts; ++p)
+                slices[p].range.store(pack(n * p / parts, n * (p + 1) / parts), std::memory_order_relaxed);
+        }
+        size_t n;
+        std::function<void(size_t)> fn;
+        std::vector<Slice> slices;
+        size_t done{0};                 // guarded by mu_
+        unsigned active{0};             // workers inside run(), guarded by mu_
+        std::exception_ptr error;       // guarded by mu_
+    };
+
+    static bool pop(Slice &s, size_t &i) {
+        uint64_t r = s.range.load(std::memory_order_relaxed);
+        while (lo(r) < hi(r)) {
+            if (s.range.compare_exchange_weak(r, pack(lo(r) + 1, hi(r)), std::memory_order_relaxed)) {
+                i = static_cast<size_t>(lo(r));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool steal(Job &job, unsigned self) {
+        const unsigned parts = static_cast<unsigned>(job.slices.size());
+        for (unsigned k = 1; k < parts; ++k) {
+            Slice &victim = job.slices[(self + k) % parts];
+            uint64_t r = victim.range.load(std::memory_order_relaxed);
+            while (lo(r) < hi(r)) {
+                const uint64_t mid = lo(r) + (hi(r) - lo(r)) / 2;
+                if (victim.range.compare_exchange_weak(r, pack(lo(r), mid), std::memory_order_relaxed)) {
+                    job.slices[self].range.store(pack(mid, hi(r)), std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void run(Job &job, unsigned self) {
+        size_t finished = 0;
+        std::exception_ptr err;
+        for (;;) {
+            size_t i;
+            if (pop(job.slices[self], i)) {
+                try { job.fn(i); }
+                catch (...) { if (!err) err = std::current_exception(); }
+                ++finished;
+            } else if (!steal(job, self)) {
+                break;
+            }
+        }
+        std::lock_guard<std::mutex> lk(mu_);
+        job.done += finished;
+        if (err && !job.error) job.error = err;
+        if (job.done == job.n) done_cv_.notify_all();
+    }
+
+    void worker_loop(unsigned self) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lk(mu_);
+        for (;;) {
+            cv_.wait(lk, [&]{ return stop_ || (job_ && generation_ != seen); });
+            if (stop_) return;
+            seen = generation_;
+            Job *job = job_;
+            ++job->active;
+            lk.unlock();
+            run(*job, self);
+            lk.lock();
+            if (--job->active == 0) done_cv_.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::atomic<bool> busy_{false};     // one loop at a time
+    std::mutex mu_;
+    std::condition_variable cv_, done_cv_;
+    Job *job_{nullptr};
+    uint64_t generation_{0};
+    bool stop_{false};
+};
+
+// Read-only memory map of a whole file (platform code in column_detector.cpp).
+class MappedFile {
+public:
+    enum class Access { Sequential, Random };
+
+    explicit MappedFile(const std::string &path, Access access = Access::Sequential);
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    std::string_view view() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+
+private:
+    void close();
+
+    const char *data_{nullptr};
+    size_t size_{0};
+#if defined(_WIN32)
+    void *file_{nullptr};     // HANDLEs; nullptr when not open
+    void *mapping_{nullptr};
+#else
+    int fd_{-1};
+#endif
+};
+
+// Split [begin, end) of `data` into about `parts` ranges that each start at a
+// record boundary. Cutting at the first newline after an arbitrary offset is
+// wrong when that newline sits inside a quoted field, so every candidate
+// chunk is scanned (in parallel) for its quote count and for its first
+// newline under both possible starting quote states; a serial prefix pass
+// over the quote parities then picks the real boundary in each chunk.
+std::vector<size_t> split_record_aligned(std::string_view data, size_t begin, size_t end,
+                                         size_t parts, ThreadPool &pool);
+
+// --- compressed input -------------------------------------------------------
+//
+// Archived logs are usually .csv.gz or .csv.zst. They are recognized by their
+// magic bytes (whatever the suffix) and decoded in memory as they are read,
+// never to a temporary file. gzip needs zlib and zstd needs libzstd at build
+// time; each is used when its header is found. zstd files in the seekable
+// format (independent frames plus a seek table in a trailing skippable frame,
+// as written by zstd's contrib/seekable_format) can also decode any byte
+// range on its own, which stratified sampling relies on.
+
+enum class Compression { None, Gzip, Zstd };
+
+inline Compression compression_of(std::string_view head) {
+    if (head.size() >= 2 && uint8_t(head[0]) == 0x1f && uint8_t(head[1]) == 0x8b) return Compression::Gzip;
+    if (head.size() >= 4 && std::memcmp(head.data(), "\x28\xb5\x2f\xfd", 4) == 0) return Compression::Zstd;
+    return Compression::None;
+}
+
+// Sequential decoder over compressed bytes (which must outlive it).
+// Concatenated gzip members and zstd frames are decoded back to back.
+class DecodeStream {
+public:
+    DecodeStream(std::string_view src, Compression kind);
+    ~DecodeStream();
+
+    DecodeStream(const DecodeStream&) = delete;
+    DecodeStream &operator=(const DecodeStream&) = delete;
+
+    // Appends up to `max` decoded bytes to `out`; 0 once the data is exhausted.
+    size_t read(std::string &out, size_t max);
+
+private:
+    struct Codec; // zlib / zstd state; the codec headers stay in column_detector.cpp
+
+    std::string_view src_;
+    Compression kind_;
+    size_t in_{0};
+    std::unique_ptr<Codec> codec_;
+};
+
+// --- sample tables ----------------------------------------------------------
+
+// Collects rows into a row-major staging arena (no per-cell allocations)
+// and transposes it into the columnar Table once sampling is done.
+class TableBuilder {
+public:
+    TableBuilder(size_t cols, size_t expected_rows) : cols_(cols) {
+        ends_.reserve(cols_ * expected_rows);
+    }
+
+    size_t rows() const { return rows_; }
+
+    void add_row(const std::vector<std::string_view> &fields) {
+        for (size_t c = 0; c < cols_; ++c) {
+            if (c < fields.size()) staging_.append(fields[c].data(), fields[c].size());
+            ends_.push_back(staging_.size());
+        }
+        ++rows_;
+    }
+
+    Detector::Table finish(char delim, std::vector<std::string> headers) {
+        Detector::Table t;
+        t.delim = delim;
+        t.headers = std::move(headers);
+        t.row_count = rows_;
+        if (staging_.size() > UINT32_MAX) throw std::runtime_error("Sample too large");
+        t.arena.resize(staging_.size());
+        t.offsets.resize(cols_ * (rows_ + 1));
+        uint32_t out = 0;
+        for (size_t c = 0; c < cols_; ++c) {
+            uint32_t *off = t.offsets.data() + c * (rows_ + 1);
+            for (size_t r = 0; r < rows_; ++r) {
+                const size_t i = r * cols_ + c;
+                const size_t b = i ? ends_[i-1] : 0, e = ends_[i];
+                off[r] = out;
+                std::memcpy(&t.arena[out], staging_.data() + b, e - b);
+                out += static_cast<uint32_t>(e - b);
+            }
+            off[rows_] = out;
+        }
+        return t;
+    }
+
+private:
+    size_t cols_;
+    size_t rows_{0};
+    std::string staging_;
+    std::vector<size_t> ends_; // end of cell (r, c) in staging_, row-major
+};
+
+// --- sidecar files ----------------------------------------------------------
+
+// Metadata only; never opens the file.
+bool stat_file(const std::string &path, FileStamp &out);
+
+inline uint64_t fnv1a(std::string_view s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : s) { h ^= c; h *= 0x100000001b3ULL; }
+    return h;
+}
+
+// Identity of the timestamp mapping a sidecar was built with.
+inline uint64_t mapping_hash(const DetectionResult &det, const TimestampExtractor::Options &opt) {
+    std::string key(1, det.delimiter);
+    for (auto *col : {&det.datetime_col, &det.date_col, &det.time_col}) {
+        key += '|';
+        if (*col) key += std::to_string((*col)->index) + ':' + std::to_string(int((*col)->role)) + ':' + (*col)->format;
+    }
+    key += '|' + std::to_string(opt.assume_utc_offset_minutes);
+    return fnv1a(key);
+}
+
+// Bounds-checked reads from a binary sidecar; any overrun clears ok.
+struct ByteReader {
+    std::string_view data;
+    size_t pos;
+    bool ok{true};
+
+    template <class T> T get() {
+        T v{};
+        if (!ok || pos > data.size() || data.size() - pos < sizeof(T)) { ok = false; return v; }
+        std::memcpy(&v, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+    std::string_view str() {
+        const uint32_t n = get<uint32_t>();
+        if (!ok || data.size() - pos < n) { ok = false; return {}; }
+        std::string_view s = data.substr(pos, n);
+        pos += n;
+        return s;
+    }
+};
+
+template <class T> inline void put_raw(std::string &out, T v) { out.append(reinterpret_cast<const char*>(&v), sizeof(T)); }
+inline void put_u32(std::string &out, uint32_t v) { put_raw(out, v); }
+inline void put_str(std::string &out, std::string_view s) { put_u32(out, static_cast<uint32_t>(s.size())); out.append(s); }
+
+// Sidecars are replaced atomically: write_temp() next to the target, then
+// rename_over() it, so readers see either the old file or the new one.
+std::string write_temp(const std::string &path, std::string_view bytes);
+void rename_over(const std::string &tmp, const std::string &path);
+
+} // namespace csvdt
@@ -0,0 +1,168 @@
+#pragma once
+// csvdt_test.h
+// What the csvdt tests (tests/test_*.cpp other than test_detection_cache.cpp)
+// share: CHECK, a scratch directory, sample logs from bench/generators.h,
+// result comparison, sidecar corruption and the runner.
+//
+// Plain C++17, no test framework. Each test file is its own program; build
+// and run one from the repository root, e.g.:
+//
+//   g++ -std=c++17 -O1 -g -pthread -fsanitize=address,undefined -o test_time_index
+//       tests/test_time_index.cpp column_detector*.cpp && ./test_time_index [name-filter]
+//
+// Files are written to a fresh directory under the system temp directory
+// and removed at exit. A test program exits non-zero if any check failed.
+
+#include "../column_detector.h"
+#include "../bench/generators.h"
+
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace csvdt_test {
+
+namespace fs = std::filesystem;
+
+inline int g_failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            ++csvdt_test::g_failures;                                                 \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                             \
+    } while (0)
+
+constexpr int64_t kSecond = 1000000000;
+
+// --- files ------------------------------------------------------------------
+
+inline fs::path scratch_dir() {
+#if defined(_WIN32)
+    static const fs::path dir = fs::temp_directory_path() / "csvdt_test";
+#else
+    static const fs::path dir = fs::temp_directory_path() / ("csvdt_test_" + std::to_string(::getpid()));
+#endif
+    fs::create_directories(dir);
+    return dir;
+}
+
+// A path in the scratch directory, with any earlier file and sidecars removed.
+inline std::string fresh_path(const std::string &name) {
+    const fs::path p = scratch_dir() / name;
+    for (const char *ext : { "", ".tidx", ".tcol" }) fs::remove(p.string() + ext);
+    return p.string();
+}
+
+inline std::string read_file(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(f), {});
+}
+
+inline void append_file(const std::string &path, const std::string &bytes) {
+    std::ofstream f(path, std::ios::binary | std::ios::app);
+    f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// A log with a "%Y-%m-%d %H:%M:%S" timestamp column, one row per second
+// from spec.start_epoch (or backwards with a negative step).
+inline benchgen::CsvSpec log_spec(size_t rows, unsigned seed) {
+    benchgen::CsvSpec spec;
+    spec.rows = rows;
+    spec.cols = 5;
+    spec.seed = seed;
+    return spec;
+}
+
+// Data lines only (make_csv output without its header line).
+inline std::string data_lines(const benchgen::CsvSpec &spec) {
+    const std::string csv = benchgen::make_csv(spec);
+    return csv.substr(csv.find('\n') + 1);
+}
+
+inline csvdt::DetectionResult detect_file(const std::string &path) {
+    return csvdt::Detector::detect(csvdt::Detector::read_csv_sample(path, 1000));
+}
+
+// --- results ----------------------------------------------------------------
+
+inline bool same_column(const csvdt::DetectedColumn &a, const csvdt::DetectedColumn &b) {
+    return a.index == b.index && a.role == b.role && a.format == b.format && a.confidence == b.confidence &&
+           a.header == b.header && a.value_type == b.value_type && a.sentinel == b.sentinel;
+}
+
+inline bool same_pick(const std::optional<csvdt::DetectedColumn> &a, const std::optional<csvdt::DetectedColumn> &b) {
+    return a.has_value() == b.has_value() && (!a || same_column(*a, *b));
+}
+
+inline bool same_result(const csvdt::DetectionResult &a, const csvdt::DetectionResult &b) {
+    if (a.delimiter != b.delimiter || a.all_columns.size() != b.all_columns.size()) return false;
+    if (!same_pick(a.datetime_col, b.datetime_col) || !same_pick(a.date_col, b.date_col) ||
+        !same_pick(a.time_col, b.time_col))
+        return false;
+    for (size_t i = 0; i < a.all_columns.size(); ++i)
+        if (!same_column(a.all_columns[i], b.all_columns[i])) return false;
+    return true;
+}
+
+// --- sidecars ---------------------------------------------------------------
+
+// Calls fn with the sidecar at `path` replaced by every corruption the
+// tests care about: truncations, then each byte flipped in turn. The
+// original bytes are restored before each call. A corrupt file must be
+// rejected or read within bounds, which the sanitizers check.
+template <class Fn> void each_corruption(const std::string &path, const std::string &good, Fn fn) {
+    auto with = [&](const std::string &bytes) {
+        benchgen::write_file(path, bytes);
+        fn(bytes);
+    };
+    for (size_t n : { size_t(0), size_t(3), size_t(4), size_t(12), good.size() / 2, good.size() - 8, good.size() - 1 })
+        if (n < good.size()) with(good.substr(0, n));
+    for (size_t i = 0; i < good.size(); ++i) {
+        std::string bad = good;
+        bad[i] = static_cast<char>(bad[i] ^ 0xFF);
+        with(bad);
+    }
+    benchgen::write_file(path, good);
+}
+
+// --- runner -----------------------------------------------------------------
+
+struct Test {
+    const char *name;
+    void (*fn)();
+};
+
+// Runs the tests whose name contains argv[1] (all without one).
+template <size_t N> int run(int argc, char **argv, const Test (&tests)[N]) {
+    const std::string filter = argc > 1 ? argv[1] : "";
+    int failed = 0, ran = 0;
+    for (const Test &t : tests) {
+        if (!filter.empty() && std::string(t.name).find(filter) == std::string::npos) continue;
+        const int before = g_failures;
+        try {
+            t.fn();
+        } catch (const std::exception &e) {
+            ++g_failures;
+            std::fprintf(stderr, "%s: exception: %s\n", t.name, e.what());
+        }
+        ++ran;
+        const bool ok = g_failures == before;
+        failed += !ok;
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", t.name);
+    }
+    std::error_code ec;
+    fs::remove_all(scratch_dir(), ec);
+    std::printf("%d of %d tests failed\n", failed, ran);
+    return failed ? 1 : 0;
+}
+
+} // namespace csvdt_test
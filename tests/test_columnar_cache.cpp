@@ -0,0 +1,242 @@
+// Tests for ColumnarCache (column_detector_index.cpp): columns typed from
+// the detected value types, sidecar reuse and rebuilds, and corrupt
+// sidecars.
+//
+// Build and run as described in csvdt_test.h.
+
+#include "csvdt_test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+using namespace csvdt;
+using namespace csvdt_test;
+
+// The cells the generators and typed_csv() leave missing, plus the
+// detected sentinel.
+bool missing_cell(const std::string &cell, const DetectionResult &det, size_t index) {
+    if (cell.empty() || cell == "NA") return true;
+    for (auto &d : det.all_columns)
+        if (d.index == index && d.sentinel) return std::strtod(cell.c_str(), nullptr) == *d.sentinel;
+    return false;
+}
+
+// Every column agrees with the CSV text and the timestamps with extract().
+bool matches_log(const ColumnarCache &cache, const std::string &path, const DetectionResult &det) {
+    const Detector::Table t = Detector::read_csv_sample(path, 1u << 20);
+    if (cache.rows() != t.rows()) return false;
+    const std::vector<int64_t> ts = TimestampExtractor(det).extract(path);
+    if (!cache.timestamps() || !std::equal(ts.begin(), ts.end(), cache.timestamps())) return false;
+    for (auto &c : cache.columns()) {
+        if (c.source_index >= t.cols() || t.headers[c.source_index] != c.header) return false;
+        for (size_t r = 0; r < t.rows(); ++r) {
+            const std::string cell(t.cell(r, c.source_index));
+            const bool missing = missing_cell(cell, det, c.source_index);
+            bool ok = false;
+            switch (c.type) {
+                case ColumnarCache::Type::Float64:
+                    ok = missing ? std::isnan(c.values[r]) : c.values[r] == std::strtod(cell.c_str(), nullptr);
+                    break;
+                case ColumnarCache::Type::Int64:
+                    ok = c.ints[r] == (missing ? ColumnarCache::kMissingInt : std::strtoll(cell.c_str(), nullptr, 10));
+                    break;
+                case ColumnarCache::Type::Bool:
+                    ok = c.flags[r] == (missing ? ColumnarCache::kMissingBool : uint8_t(cell == "true" || cell == "yes"));
+                    break;
+                case ColumnarCache::Type::Dictionary:
+                    ok = c.text(c.codes[r]) == cell;
+                    break;
+            }
+            if (!ok) return false;
+        }
+    }
+    return true;
+}
+
+// What a caller may rely on for any cache that opened.
+bool in_bounds(const ColumnarCache &cache) {
+    for (auto &c : cache.columns()) {
+        for (size_t r = 0; r < cache.rows(); ++r) {
+            if (c.type == ColumnarCache::Type::Bool && c.flags[r] > 1 && c.flags[r] != ColumnarCache::kMissingBool)
+                return false;
+            if (c.type != ColumnarCache::Type::Dictionary) continue;
+            if (c.codes[r] >= c.dict_count) return false;
+            (void)c.text(c.codes[r]).size();
+        }
+    }
+    return true;
+}
+
+// Replaces the first copy of `block` in the sidecar with `with`; false if
+// it is not there.
+bool patch_sidecar(const std::string &sidecar, const std::string &good, const std::string &block, const std::string &with) {
+    std::string bad = good;
+    const size_t pos = bad.find(block);
+    if (pos == std::string::npos) return false;
+    bad.replace(pos, with.size(), with);
+    benchgen::write_file(sidecar, bad);
+    return true;
+}
+
+// --- typing -----------------------------------------------------------------
+
+constexpr int64_t kBig = 9007199254740993; // 2^53 + 1, not exact as a double
+
+// Column types that hold in the first 100 rows; the late_* columns break
+// theirs after that.
+std::string typed_csv() {
+    std::string out = "timestamp,count,flag,late_int,late_bool,big\n";
+    for (int r = 0; r < 200; ++r) {
+        out += benchgen::format_time("%Y-%m-%d %H:%M:%S", 1700000000 + r);
+        out += ',' + (r % 10 == 3 ? std::string("NA") : r % 25 == 7 ? std::string("-9999") : std::to_string(r % 17));
+        out += ',' + (r % 7 == 0 ? std::string() : std::string(r % 2 ? "true" : "false"));
+        out += ',' + std::to_string(r) + (r == 150 ? ".5" : "");
+        out += ',' + std::string(r == 180 ? "maybe" : r % 3 ? "yes" : "no");
+        out += ',' + std::to_string(kBig + r) + '\n';
+    }
+    return out;
+}
+
+void columnar_types() {
+    const std::string log = fresh_path("ct.csv");
+    benchgen::write_file(log, typed_csv());
+    const DetectionResult det = Detector::detect(Detector::read_csv_sample(log, 100));
+    const ColumnarCache cache(log, det);
+    CHECK(cache.rows() == 200);
+    CHECK(matches_log(cache, log, det));
+    auto type_of = [&](const char *header) {
+        const ColumnarCache::Column *c = cache.column(header);
+        return c ? int(c->type) : -1;
+    };
+    CHECK(type_of("count") == int(ColumnarCache::Type::Int64));
+    CHECK(type_of("flag") == int(ColumnarCache::Type::Bool));
+    CHECK(type_of("late_int") == int(ColumnarCache::Type::Float64));    // a decimal past the sample
+    CHECK(type_of("late_bool") == int(ColumnarCache::Type::Dictionary)); // a word past the sample
+    CHECK(type_of("big") == int(ColumnarCache::Type::Int64));
+    if (!cache.column("count") || !cache.column("flag") || !cache.column("late_int") || !cache.column("big")) return;
+
+    const ColumnarCache::Column &count = *cache.column("count"), &flag = *cache.column("flag");
+    CHECK(count.ints[1] == 1 && count.ints[16] == 16);
+    CHECK(count.ints[3] == ColumnarCache::kMissingInt);  // NA
+    CHECK(count.ints[7] == ColumnarCache::kMissingInt);  // the sentinel
+    CHECK(flag.flags[0] == ColumnarCache::kMissingBool);
+    CHECK(flag.flags[1] == 1 && flag.flags[2] == 0);
+    CHECK(cache.column("late_int")->values[150] == 150.5 && cache.column("late_int")->values[151] == 151.0);
+    bool exact = true;
+    for (size_t r = 0; r < cache.rows(); ++r) exact &= cache.column("big")->ints[r] == kBig + int64_t(r);
+    CHECK(exact);
+
+    // A flag byte other than 1, 0 or missing is rejected on open.
+    const std::string sidecar = ColumnarCache::sidecar_path(log);
+    const std::string good = read_file(sidecar);
+    const std::string flags(reinterpret_cast<const char*>(flag.flags), cache.rows());
+    CHECK(patch_sidecar(sidecar, good, flags, std::string(1, '\x02')));
+    const ColumnarCache reread(log, det);
+    CHECK(reread.rebuilt());
+    CHECK(matches_log(reread, log, det));
+}
+
+// --- sidecar ----------------------------------------------------------------
+
+void columnar_round_trip() {
+    const std::string log = fresh_path("cc.csv");
+    benchgen::CsvSpec spec = log_spec(500, 10);
+    spec.cols = 7;
+    spec.empty_rate = 0.1;
+    benchgen::write_file(log, benchgen::make_csv(spec));
+    const DetectionResult det = detect_file(log);
+
+    {
+        ColumnarCache built(log, det);
+        CHECK(built.rebuilt());
+        CHECK(fs::exists(ColumnarCache::sidecar_path(log)));
+        CHECK(built.columns().size() == 6); // the timestamp column is folded into timestamps()
+        CHECK(!built.column("timestamp"));
+        CHECK(built.column("col1") && built.column("col1")->type == ColumnarCache::Type::Int64);
+        CHECK(built.column("col2") && built.column("col2")->type == ColumnarCache::Type::Dictionary);
+        CHECK(built.column("col3") && built.column("col3")->type == ColumnarCache::Type::Float64);
+        CHECK(matches_log(built, log, det));
+    }
+    {
+        ColumnarCache mapped(log, det);
+        CHECK(!mapped.rebuilt());
+        CHECK(matches_log(mapped, log, det));
+    }
+
+    // The log grew: the sidecar is stale.
+    append_file(log, data_lines([&]{ auto s = spec; s.rows = 20; s.start_epoch += 500; return s; }()));
+    {
+        ColumnarCache grown(log, det);
+        CHECK(grown.rebuilt());
+        CHECK(grown.rows() == 520);
+        CHECK(matches_log(grown, log, det));
+    }
+
+    // Another mapping (here: a UTC offset) rebuilds too.
+    ColumnarCache::Options shifted;
+    shifted.timestamps.assume_utc_offset_minutes = 60;
+    ColumnarCache offset(log, det, shifted);
+    CHECK(offset.rebuilt());
+    CHECK(offset.timestamps()[0] == TimestampExtractor(det).extract(log)[0] - 3600 * kSecond);
+
+    // Without persist nothing is written.
+    const std::string other = fresh_path("cc_mem.csv");
+    benchgen::write_file(other, benchgen::make_csv(spec));
+    ColumnarCache::Options mem;
+    mem.persist = false;
+    ColumnarCache in_memory(other, det, mem);
+    CHECK(in_memory.rebuilt());
+    CHECK(!fs::exists(ColumnarCache::sidecar_path(other)));
+    CHECK(matches_log(in_memory, other, det));
+}
+
+void columnar_corrupt() {
+    const std::string log = fresh_path("ccc.csv");
+    benchgen::CsvSpec spec = log_spec(60, 11);
+    spec.cols = 4;
+    benchgen::write_file(log, benchgen::make_csv(spec));
+    const DetectionResult det = detect_file(log);
+    { ColumnarCache built(log, det); }
+    const std::string sidecar = ColumnarCache::sidecar_path(log);
+    const std::string good = read_file(sidecar);
+
+    size_t rejected = 0;
+    each_corruption(sidecar, good, [&](const std::string &bytes) {
+        const ColumnarCache cache(log, det);
+        CHECK(in_bounds(cache));
+        if (cache.rebuilt()) {
+            ++rejected;
+            CHECK(matches_log(cache, log, det));
+        }
+        if (bytes.size() < good.size()) CHECK(cache.rebuilt());
+    });
+    CHECK(rejected > 0);
+
+    // Dictionary codes past the dictionary are rejected on open.
+    const ColumnarCache ref(log, det);
+    const ColumnarCache::Column *text = ref.column("col2");
+    CHECK(text && text->type == ColumnarCache::Type::Dictionary);
+    if (text) {
+        // Found by content: the code array is unique in a sidecar this small.
+        const std::string codes(reinterpret_cast<const char*>(text->codes), ref.rows() * sizeof(uint32_t));
+        const uint32_t past = static_cast<uint32_t>(text->dict_count);
+        CHECK(patch_sidecar(sidecar, good, codes, std::string(reinterpret_cast<const char*>(&past), sizeof past)));
+        const ColumnarCache reread(log, det);
+        CHECK(reread.rebuilt());
+        CHECK(matches_log(reread, log, det));
+    }
+}
+
+const Test kTests[] = {
+    { "columnar_types", columnar_types },
+    { "columnar_round_trip", columnar_round_trip },
+    { "columnar_corrupt", columnar_corrupt },
+};
+
+} // namespace
+
+int main(int argc, char **argv) { return csvdt_test::run(argc, argv, kTests); }
@@ -0,0 +1,303 @@
+// Tests for DetectionCache (.filemake-detect.cache): round trip, staleness,
+// corruption of the cache file, detectMany() over hits and misses, pruning
+// of files gone since the last scan, and save() under concurrent lookups.
+//
+// Plain C++17 against Qt Core, no test framework. Build and run from the
+// repository root, e.g.:
+//
+//   g++ -std=c++17 -O1 -g -pthread -fPIC -fsanitize=address,undefined -I. $(pkg-config --cflags Qt5Core)
+//       tests/test_detection_cache.cpp DetectionCache.cpp FileTypeDetector.cpp FileSniffer.cpp HeadReader.cpp
+//       -o test_detection_cache $(pkg-config --libs Qt5Core) && ./test_detection_cache
+//
+// Exits non-zero if any check failed.
+
+#include "DetectionCache.h"
+#include "FileTypeDetector.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            ++g_failures;                                                             \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                             \
+    } while (0)
+
+void writeFile(const QString& path, const QByteArray& bytes) {
+    QFile f(path);
+    if (f.open(QIODevice::WriteOnly)) f.write(bytes);
+}
+
+void appendFile(const QString& path, const QByteArray& bytes) {
+    QFile f(path);
+    if (f.open(QIODevice::WriteOnly | QIODevice::Append)) f.write(bytes);
+}
+
+QByteArray readFile(const QString& path) {
+    QFile f(path);
+    return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+// Files of a few kinds FileTypeDetector tells apart by extension and head.
+QStringList makeFiles(const QString& dir, int count) {
+    static const char* const kExts[] = { "png", "jpg", "mp4", "csv", "txt" };
+    QStringList out;
+    for (int i = 0; i < count; ++i) {
+        const QString path = dir + "/f" + QString::number(i) + "." + kExts[i % 5];
+        QByteArray head;
+        switch (i % 5) {
+            case 0: head = QByteArray("\x89PNG\r\n\x1a\n", 8); break;
+            case 1: head = QByteArray("\xFF\xD8\xFF\xE0", 4); break;
+            case 2: head = QByteArray("\0\0\0\x18" "ftypmp42", 12); break;
+            case 3: head = "timestamp,temp\n2024-01-01 00:00:00,21.5\n"; break;
+            default: head = "notes"; break;
+        }
+        writeFile(path, head + QByteArray(64 + i, 'x'));
+        out << path;
+    }
+    return out;
+}
+
+bool sameResult(const FileDetectResult& a, const FileDetectResult& b) {
+    return a.kind == b.kind && a.reason == b.reason;
+}
+
+FileDetectResult resultFor(int i) {
+    return { static_cast<FileKind>(i % 6), "reason " + QString::number(i) };
+}
+
+// --- tests ------------------------------------------------------------------
+
+void roundTrip() {
+    QTemporaryDir dir;
+    const QStringList files = makeFiles(dir.path(), 20);
+    const QString cachePath = DetectionCache::defaultPathFor(dir.path());
+    {
+        DetectionCache cache(cachePath);
+        for (int i = 0; i < files.size(); ++i) {
+            FileDetectResult r;
+            CHECK(!cache.lookup(QFileInfo(files[i]), r));
+            cache.insert(QFileInfo(files[i]), resultFor(i));
+        }
+        CHECK(cache.isDirty());
+        CHECK(cache.save());
+        CHECK(!cache.isDirty());
+    }
+
+    DetectionCache reopened(cachePath);
+    CHECK(!reopened.isDirty());
+    for (int i = 0; i < files.size(); ++i) {
+        FileDetectResult r;
+        CHECK(reopened.lookup(QFileInfo(files[i]), r) && sameResult(r, resultFor(i)));
+    }
+
+    // Another size or mtime misses.
+    appendFile(files[0], "more");
+    FileDetectResult r;
+    CHECK(!reopened.lookup(QFileInfo(files[0]), r));
+    const std::filesystem::path p1 = files[1].toStdString();
+    std::filesystem::last_write_time(p1, std::filesystem::last_write_time(p1) + std::chrono::seconds(5));
+    CHECK(!reopened.lookup(QFileInfo(files[1]), r));
+    CHECK(reopened.lookup(QFileInfo(files[2]), r) && sameResult(r, resultFor(2)));
+
+    // Saving merges new results with the mapped ones.
+    reopened.insert(QFileInfo(files[0]), resultFor(100));
+    CHECK(reopened.save());
+    DetectionCache again(cachePath);
+    CHECK(again.lookup(QFileInfo(files[0]), r) && sameResult(r, resultFor(100)));
+    for (int i = 2; i < files.size(); ++i) CHECK(again.lookup(QFileInfo(files[i]), r) && sameResult(r, resultFor(i)));
+}
+
+void corrupt() {
+    QTemporaryDir dir;
+    const QStringList files = makeFiles(dir.path(), 6);
+    const QString cachePath = DetectionCache::defaultPathFor(dir.path());
+    {
+        DetectionCache cache(cachePath);
+        for (int i = 0; i < files.size(); ++i) cache.insert(QFileInfo(files[i]), resultFor(i));
+        CHECK(cache.save());
+    }
+    const QByteArray good = readFile(cachePath);
+    CHECK(good.size() > 12);
+
+    // A truncated file still serves the records it holds in full; any
+    // flipped byte is a miss or a result read within bounds (the sanitizers
+    // check the latter), and a bad magic or version is always a miss.
+    enum class Expect { Miss, Exact, InBounds };
+    auto lookups = [&](Expect expect) {
+        DetectionCache cache(cachePath);
+        for (int i = 0; i < files.size(); ++i) {
+            FileDetectResult r;
+            const bool hit = cache.lookup(QFileInfo(files[i]), r);
+            if (expect == Expect::Miss) CHECK(!hit);
+            if (expect == Expect::Exact && hit) CHECK(sameResult(r, resultFor(i)));
+        }
+    };
+    for (int n : { 0, 3, 4, 11, 12, good.size() / 2, good.size() - 1 }) {
+        writeFile(cachePath, good.left(n));
+        lookups(n < 12 ? Expect::Miss : Expect::Exact);
+    }
+    for (int i = 0; i < good.size(); ++i) {
+        QByteArray bad = good;
+        bad[i] = char(bad[i] ^ 0xFF);
+        writeFile(cachePath, bad);
+        lookups(i < 8 ? Expect::Miss : Expect::InBounds);
+    }
+
+    // A damaged file is replaced by the next save().
+    writeFile(cachePath, good.left(good.size() / 2));
+    {
+        DetectionCache cache(cachePath);
+        cache.insert(QFileInfo(files[0]), resultFor(0));
+        CHECK(cache.save());
+    }
+    DetectionCache repaired(cachePath);
+    FileDetectResult r;
+    CHECK(repaired.lookup(QFileInfo(files[0]), r) && sameResult(r, resultFor(0)));
+}
+
+void detectMany() {
+    QTemporaryDir dir;
+    const QStringList files = makeFiles(dir.path(), 25);
+    const QString cachePath = DetectionCache::defaultPathFor(dir.path());
+    std::vector<FileDetectResult> want;
+    for (const QString& f : files) want.push_back(FileTypeDetector::detect(f));
+
+    DetectionCache cache(cachePath);
+    for (int i = 0; i < 10; ++i) cache.detect(QFileInfo(files[i]));
+
+    // Every index once, each as detect() would say; hits come first.
+    std::vector<int> seen(files.size(), 0);
+    std::vector<int> order;
+    cache.detectMany(files, [&](int i, const FileDetectResult& r) {
+        ++seen[i];
+        order.push_back(i);
+        CHECK(sameResult(r, want[i]));
+    });
+    for (int n : seen) CHECK(n == 1);
+    CHECK(order.size() == size_t(files.size()));
+    for (size_t k = 0; k < order.size() && k < 10; ++k) CHECK(order[k] < 10);
+    CHECK(cache.save());
+
+    DetectionCache reopened(cachePath);
+    for (int i = 0; i < files.size(); ++i) {
+        FileDetectResult r;
+        CHECK(reopened.lookup(QFileInfo(files[i]), r) && sameResult(r, want[i]));
+    }
+}
+
+quint32 entryCount(const QString& cachePath) {
+    const QByteArray bytes = readFile(cachePath);
+    quint32 n = 0;
+    if (bytes.size() >= 12) std::memcpy(&n, bytes.constData() + 8, 4);
+    return n;
+}
+
+void prune() {
+    QTemporaryDir dir;
+    QStringList files = makeFiles(dir.path(), 10);
+    const QString cachePath = DetectionCache::defaultPathFor(dir.path());
+    {
+        DetectionCache cache(cachePath);
+        cache.detectMany(files, [](int, const FileDetectResult&) {});
+        CHECK(cache.save());
+    }
+    CHECK(entryCount(cachePath) == 10);
+
+    // One file deleted, one renamed: the next scan writes back only the
+    // files it saw, the renamed one under its new name.
+    const QString gone = files.takeAt(3);
+    std::filesystem::remove(gone.toStdString());
+    const QString renamed = dir.path() + "/renamed.png";
+    std::filesystem::rename(files[3].toStdString(), renamed.toStdString());
+    const QString oldName = files[3];
+    files[3] = renamed;
+    {
+        DetectionCache cache(cachePath);
+        cache.detectMany(files, [](int, const FileDetectResult&) {});
+        CHECK(cache.save());
+    }
+    CHECK(entryCount(cachePath) == 9);
+    const QByteArray bytes = readFile(cachePath);
+    CHECK(!bytes.contains(QFileInfo(gone).fileName().toUtf8()));
+    CHECK(!bytes.contains(QFileInfo(oldName).fileName().toUtf8()));
+    DetectionCache reopened(cachePath);
+    for (const QString& f : files) {
+        FileDetectResult r;
+        CHECK(reopened.lookup(QFileInfo(f), r));
+    }
+}
+
+void saveUnderLookups() {
+    QTemporaryDir dir;
+    const QStringList files = makeFiles(dir.path(), 30);
+    const QString cachePath = DetectionCache::defaultPathFor(dir.path());
+    DetectionCache cache(cachePath);
+    for (int i = 0; i < files.size(); ++i) cache.insert(QFileInfo(files[i]), resultFor(i));
+    CHECK(cache.save());
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                for (int i = 0; i < files.size(); ++i) {
+                    FileDetectResult r;
+                    if (!cache.lookup(QFileInfo(files[i]), r) || !sameResult(r, resultFor(i))) ++wrong;
+                    cache.insert(QFileInfo(files[i]), resultFor(i));
+                }
+            }
+        });
+    }
+    for (int k = 0; k < 100; ++k) CHECK(cache.save());
+    stop.store(true);
+    for (auto& t : readers) t.join();
+    CHECK(wrong.load() == 0);
+}
+
+struct Test {
+    const char* name;
+    void (*fn)();
+};
+
+const Test kTests[] = {
+    { "roundTrip", roundTrip },
+    { "corrupt", corrupt },
+    { "detectMany", detectMany },
+    { "prune", prune },
+    { "saveUnderLookups", saveUnderLookups },
+};
+
+} // namespace
+
+int main() {
+    int failed = 0;
+    for (const Test& t : kTests) {
+        const int before = g_failures;
+        t.fn();
+        const bool ok = g_failures == before;
+        failed += !ok;
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", t.name);
+    }
+    std::printf("%d of %d tests failed\n", failed, int(sizeof(kTests) / sizeof(kTests[0])));
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+// Tests for csvdt detection (column_detector.cpp): detect() and extract()
+// on the shared thread pools, read_csv_sample() on CRLF files,
+// detect_adaptive() against detect(), and value typing of signed numbers.
+//
+// Build and run as described in csvdt_test.h.
+
+#include "csvdt_test.h"
+
+#include <thread>
+
+namespace {
+
+using namespace csvdt;
+using namespace csvdt_test;
+
+// --- threads ----------------------------------------------------------------
+
+void detect_threads() {
+    const std::string log = fresh_path("dt.csv");
+    benchgen::CsvSpec spec = log_spec(2000, 1);
+    spec.cols = 9;
+    spec.empty_rate = 0.1;
+    benchgen::write_file(log, benchgen::make_csv(spec));
+    const Detector::Table sample = Detector::read_csv_sample(log, 1000);
+    const DetectionResult serial = Detector::detect(sample, 1);
+    const std::vector<int64_t> want = TimestampExtractor(serial).extract(log);
+    TimestampExtractor::Options chunked;
+    chunked.min_chunk_bytes = 4096;
+
+    for (unsigned threads : { 0u, 2u, 4u, 4u }) CHECK(same_result(Detector::detect(sample, threads), serial));
+
+    // Callers on several threads share one pool: whoever finds it busy runs
+    // its loop itself, with the same results.
+    std::vector<std::thread> callers;
+    std::vector<int> wrong(6, 0);
+    for (size_t k = 0; k < wrong.size(); ++k) {
+        callers.emplace_back([&, k] {
+            for (int i = 0; i < 20; ++i) {
+                wrong[k] += !same_result(Detector::detect(sample, 4), serial);
+                wrong[k] += TimestampExtractor(serial, chunked).extract(log) != want;
+            }
+        });
+    }
+    for (auto &t : callers) t.join();
+    for (int w : wrong) CHECK(w == 0);
+}
+
+// --- sampling ---------------------------------------------------------------
+
+bool same_cells(const Detector::Table &a, const Detector::Table &b) {
+    if (a.headers != b.headers || a.rows() != b.rows() || a.delim != b.delim) return false;
+    for (size_t c = 0; c < a.cols(); ++c)
+        for (size_t r = 0; r < a.rows(); ++r)
+            if (a.cell(r, c) != b.cell(r, c)) return false;
+    return true;
+}
+
+void sample_crlf() {
+    benchgen::CsvSpec spec = log_spec(300, 2);
+    spec.empty_rate = 0.2; // empty last fields leave a bare '\r'
+    const std::string lf = benchgen::make_csv(spec);
+    std::string crlf;
+    for (char ch : lf) crlf += ch == '\n' ? std::string("\r\n") : std::string(1, ch);
+    const std::string lf_path = fresh_path("lf.csv"), crlf_path = fresh_path("crlf.csv");
+    benchgen::write_file(lf_path, lf);
+    benchgen::write_file(crlf_path, crlf);
+
+    // Both sampling modes see the same cells as in the LF file.
+    Detector::SampleOptions head, stratified;
+    stratified.mode = Detector::SampleMode::Stratified;
+    const Detector::Table want = Detector::read_csv_sample(lf_path, head);
+    CHECK(want.rows() == 300);
+    CHECK(same_cells(Detector::read_csv_sample(crlf_path, head), want));
+    CHECK(same_cells(Detector::read_csv_sample(crlf_path, stratified), want));
+    CHECK(same_result(detect_file(crlf_path), detect_file(lf_path)));
+}
+
+// --- detect_adaptive --------------------------------------------------------
+
+// Columns whose value type or missing-data code only shows after the point
+// where adaptive sampling can stop.
+std::string late_typing_csv() {
+    std::string out = "timestamp,count,level,flag,note\n";
+    for (int r = 0; r < 800; ++r) {
+        out += benchgen::format_time("%Y-%m-%dT%H:%M:%S", 1700000000 + r);
+        out += ',' + (r < 300 ? std::to_string(r % 17) : std::to_string(r % 17) + ".5");
+        out += ',' + (r > 500 && r % 9 == 0 ? std::string("-9999") : std::to_string(20 + r % 5) + ".25");
+        out += ',' + std::string(r % 2 ? "true" : "false") + (r == 700 ? "ish" : "");
+        out += ',' + std::string(r < 600 ? "ok" : "fault") + '\n';
+    }
+    return out;
+}
+
+std::pair<int, std::string> mapping(const std::optional<DetectedColumn> &c) {
+    return c ? std::make_pair(int(c->index), c->format) : std::make_pair(-1, std::string());
+}
+
+bool same_mapping(const DetectionResult &a, const DetectionResult &b) {
+    return mapping(a.datetime_col) == mapping(b.datetime_col) && mapping(a.date_col) == mapping(b.date_col) &&
+           mapping(a.time_col) == mapping(b.time_col);
+}
+
+void adaptive_equivalence() {
+    std::vector<std::string> files;
+    auto add = [&](const std::string &name, const std::string &content) {
+        files.push_back(fresh_path(name));
+        benchgen::write_file(files.back(), content);
+    };
+    const char *formats[] = { "%Y-%m-%d %H:%M:%S", "%d/%m/%Y %H:%M", "%m/%d/%Y %I:%M:%S %p", "%Y-%m-%dT%H:%M:%S",
+                              "%d.%m.%Y %H:%M:%S", "%Y%m%d %H%M%S" };
+    unsigned seed = 30;
+    for (const char *fmt : formats) {
+        benchgen::CsvSpec spec = log_spec(1500, seed++);
+        spec.format = fmt;
+        spec.step_seconds = 37;
+        add("ad" + std::to_string(seed) + ".csv", benchgen::make_csv(spec));
+    }
+    for (auto kind : { benchgen::TimeColumn::DateAndTime, benchgen::TimeColumn::DateOnly, benchgen::TimeColumn::EpochSeconds,
+                       benchgen::TimeColumn::EpochMillis, benchgen::TimeColumn::None }) {
+        benchgen::CsvSpec spec = log_spec(1500, seed++);
+        spec.time = kind;
+        if (kind == benchgen::TimeColumn::DateAndTime || kind == benchgen::TimeColumn::DateOnly) spec.format = "%Y-%m-%d";
+        spec.cols = 9;
+        spec.empty_rate = 0.2;
+        spec.delim = seed % 2 ? ';' : '\t';
+        add("ad" + std::to_string(seed) + ".csv", benchgen::make_csv(spec));
+    }
+    add("ad_late.csv", late_typing_csv());
+
+    Detector::AdaptiveOptions opt, typed;
+    typed.full_typing = true;
+    size_t stopped = 0;
+    for (auto &path : files) {
+        // Everything as detect() over the rows read...
+        size_t read = 0;
+        const DetectionResult adaptive = Detector::detect_adaptive(path, opt, &read);
+        CHECK(read > 0 && read <= opt.max_rows);
+        stopped += read < opt.max_rows;
+        CHECK(same_result(adaptive, Detector::detect(Detector::read_csv_sample(path, read))));
+
+        // ...and with full_typing, value types as over the whole sample.
+        size_t typed_read = 0;
+        const DetectionResult full_typed = Detector::detect_adaptive(path, typed, &typed_read);
+        const Detector::Table sample = Detector::read_csv_sample(path, opt.max_rows);
+        CHECK(typed_read == sample.rows());
+        const DetectionResult full = Detector::detect(sample);
+        CHECK(same_mapping(full_typed, adaptive));
+        CHECK(full_typed.all_columns.size() == full.all_columns.size());
+        if (full_typed.all_columns.size() != full.all_columns.size()) continue;
+        for (size_t i = 0; i < full.all_columns.size(); ++i) {
+            const DetectedColumn &a = adaptive.all_columns[i], &t = full_typed.all_columns[i], &f = full.all_columns[i];
+            CHECK(t.role == a.role && t.format == a.format && t.confidence == a.confidence);
+            CHECK(t.value_type == f.value_type);
+            CHECK(t.sentinel == f.sentinel);
+        }
+    }
+    CHECK(stopped > files.size() / 2);
+
+    // The late-typing file stops early, so the two samples really differ.
+    size_t read = 0;
+    const DetectionResult late = Detector::detect_adaptive(files.back(), opt, &read);
+    CHECK(read < 300);
+    const DetectionResult late_typed = Detector::detect_adaptive(files.back(), typed);
+    CHECK(late.all_columns[1].value_type != late_typed.all_columns[1].value_type);
+    CHECK(!late.all_columns[2].sentinel);
+    CHECK(late_typed.all_columns[2].sentinel && *late_typed.all_columns[2].sentinel == -9999);
+}
+
+// --- value types ------------------------------------------------------------
+
+void value_signs() {
+    // One sign at most: a '+' followed by another sign is text.
+    std::string csv = "timestamp,int,plus_minus_int,float,plus_minus_float,plus_plus\n";
+    for (int r = 0; r < 200; ++r) {
+        const std::string n = std::to_string(r % 50);
+        csv += benchgen::format_time("%Y-%m-%d %H:%M:%S", 1700000000 + r);
+        csv += ',' + std::string(r % 3 == 0 ? "+" : r % 3 == 1 ? "-" : "") + n;
+        csv += ",+-" + n;
+        csv += ',' + std::string(r % 2 ? "+" : "-") + n + ".5";
+        csv += ",+-" + n + ".5";
+        csv += ",++" + n + '\n';
+    }
+    const std::string path = fresh_path("signs.csv");
+    benchgen::write_file(path, csv);
+    const DetectionResult det = detect_file(path);
+    CHECK(det.all_columns.size() == 6);
+    if (det.all_columns.size() != 6) return;
+    CHECK(det.all_columns[1].value_type == ValueType::Int);
+    CHECK(det.all_columns[2].value_type == ValueType::Text);
+    CHECK(det.all_columns[3].value_type == ValueType::Float);
+    CHECK(det.all_columns[4].value_type == ValueType::Text);
+    CHECK(det.all_columns[5].value_type == ValueType::Text);
+}
+
+const Test kTests[] = {
+    { "detect_threads", detect_threads },
+    { "sample_crlf", sample_crlf },
+    { "adaptive_equivalence", adaptive_equivalence },
+    { "value_signs", value_signs },
+};
+
+} // namespace
+
+int main(int argc, char **argv) { return csvdt_test::run(argc, argv, kTests); }
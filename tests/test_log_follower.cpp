@@ -0,0 +1,209 @@
+// Tests for LogFollower (column_detector_follow.cpp) across appends,
+// partial records, truncation, rewrites, rotation and its own thread.
+//
+// Build and run as described in csvdt_test.h.
+
+#include "csvdt_test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+using namespace csvdt;
+using namespace csvdt_test;
+
+struct Received {
+    std::vector<LogFollower::Batch> batches;
+    size_t rows() const {
+        size_t n = 0;
+        for (auto &b : batches) n += b.rows.rows();
+        return n;
+    }
+    size_t resets() const {
+        size_t n = 0;
+        for (auto &b : batches) n += b.reset;
+        return n;
+    }
+};
+
+LogFollower::Options follow_options() {
+    LogFollower::Options opt;
+    opt.max_batch_rows = 64;
+    opt.read_chunk = 4096;
+    opt.poll_ms = 50;
+    return opt;
+}
+
+// Rows are numbered without gaps since the last reset and carry their
+// timestamps.
+bool numbered(const Received &got) {
+    uint64_t next = 0;
+    for (auto &b : got.batches) {
+        if (b.reset) next = 0;
+        if (b.first_row != next || b.timestamps.size() != b.rows.rows()) return false;
+        for (int64_t t : b.timestamps) if (t == TimestampExtractor::kInvalid) return false;
+        next += b.rows.rows();
+    }
+    return true;
+}
+
+void follow_append() {
+    const std::string log = fresh_path("fa.csv");
+    const std::string full = benchgen::make_csv(log_spec(300, 12));
+    const size_t head = full.find('\n', 4000) + 1;
+    benchgen::write_file(log, full.substr(0, head));
+
+    LogFollower follower(log, follow_options());
+    Received got;
+    follower.subscribe([&](const LogFollower::Batch &b) { got.batches.push_back(b); });
+    const size_t first = follower.poll();
+    CHECK(first > 0 && first == got.rows());
+    CHECK(follower.detection() && follower.detection()->datetime_col);
+    CHECK(follower.committed_offset() == head);
+    CHECK(!follower.poll());
+
+    // A record without its newline waits.
+    const size_t mid = full.find('\n', head + 1000) + 20;
+    append_file(log, full.substr(head, mid - head));
+    follower.poll();
+    CHECK(follower.committed_offset() < mid);
+    CHECK(follower.committed_offset() == full.rfind('\n', mid - 1) + 1);
+    append_file(log, full.substr(mid));
+    follower.poll();
+    CHECK(follower.committed_offset() == full.size());
+    CHECK(got.rows() == 300);
+    CHECK(got.resets() == 0);
+    CHECK(numbered(got));
+    for (auto &b : got.batches) CHECK(b.rows.rows() <= 64);
+}
+
+void follow_truncate() {
+    const std::string log = fresh_path("ft.csv");
+    benchgen::write_file(log, benchgen::make_csv(log_spec(200, 13)));
+    LogFollower follower(log, follow_options());
+    Received got;
+    follower.subscribe([&](const LogFollower::Batch &b) { got.batches.push_back(b); });
+    follower.poll();
+    CHECK(got.rows() == 200);
+
+    // Shorter than before.
+    got.batches.clear();
+    benchgen::write_file(log, benchgen::make_csv(log_spec(20, 14)));
+    CHECK(follower.poll() == 20);
+    CHECK(!got.batches.empty() && got.batches.front().reset);
+    CHECK(got.rows() == 20);
+    CHECK(numbered(got));
+
+    // Rewritten past the old size between two updates: the anchor catches it.
+    got.batches.clear();
+    benchgen::CsvSpec longer = log_spec(400, 15);
+    longer.start_epoch += 86400;
+    benchgen::write_file(log, benchgen::make_csv(longer));
+    CHECK(follower.poll() == 400);
+    CHECK(got.resets() == 1 && got.batches.front().reset);
+    CHECK(got.batches.front().timestamps.front() == (1700000000 + 86400) * kSecond);
+    CHECK(numbered(got));
+
+    // Truncated to the header only: a reset and no rows.
+    got.batches.clear();
+    const std::string csv = benchgen::make_csv(log_spec(1, 16));
+    benchgen::write_file(log, csv.substr(0, csv.find('\n') + 1));
+    CHECK(follower.poll() == 0);
+    CHECK(got.resets() == 1 && got.rows() == 0);
+}
+
+void follow_rotate() {
+    const std::string log = fresh_path("fr.csv");
+    const std::string rotated = log + ".1";
+    fs::remove(rotated);
+    const std::string full = benchgen::make_csv(log_spec(150, 17));
+    const size_t cut = full.find('\n', full.size() - 300) + 1;
+    benchgen::write_file(log, full.substr(0, cut));
+
+    LogFollower follower(log, follow_options());
+    Received got;
+    follower.subscribe([&](const LogFollower::Batch &b) { got.batches.push_back(b); });
+    follower.poll();
+    const size_t before = got.rows();
+
+    // The old file gets its last rows after the rename; the new one starts
+    // over with a reset.
+    append_file(log, full.substr(cut));
+    fs::rename(log, rotated);
+    benchgen::CsvSpec next = log_spec(30, 18);
+    next.start_epoch += 150;
+    benchgen::write_file(log, benchgen::make_csv(next));
+    got.batches.clear();
+    follower.poll();
+    CHECK(before + got.rows() == 150 + 30);
+    size_t reset_at = got.batches.size();
+    for (size_t i = 0; i < got.batches.size(); ++i) if (got.batches[i].reset) { reset_at = i; break; }
+    CHECK(reset_at < got.batches.size());
+    size_t old_rows = 0;
+    for (size_t i = 0; i < reset_at; ++i) old_rows += got.batches[i].rows.rows();
+    CHECK(before + old_rows == 150);
+    CHECK(got.batches[reset_at].first_row == 0);
+    CHECK(got.batches[reset_at].timestamps.front() == (1700000000 + 150) * kSecond);
+    CHECK(follower.committed_offset() == fs::file_size(log));
+
+    // A new header means a new detection.
+    fs::remove(rotated);
+    fs::rename(log, rotated);
+    benchgen::CsvSpec wider = log_spec(40, 19);
+    wider.cols = 8;
+    benchgen::write_file(log, benchgen::make_csv(wider));
+    got.batches.clear();
+    CHECK(follower.poll() == 40);
+    CHECK(got.resets() == 1);
+    CHECK(follower.detection() && follower.detection()->all_columns.size() == 8);
+    CHECK(!got.batches.empty() && got.batches.back().rows.cols() == 8);
+    CHECK(numbered(got));
+    fs::remove(rotated);
+}
+
+void follow_thread() {
+    const std::string log = fresh_path("fth.csv");
+    const std::string full = benchgen::make_csv(log_spec(100, 20));
+    const size_t cut = full.find('\n', full.size() / 2) + 1;
+    benchgen::write_file(log, full.substr(0, cut));
+
+    LogFollower follower(log, follow_options());
+    std::mutex m;
+    Received got;
+    follower.subscribe([&](const LogFollower::Batch &b) {
+        std::lock_guard<std::mutex> lk(m);
+        got.batches.push_back(b);
+    });
+    auto rows = [&] {
+        std::lock_guard<std::mutex> lk(m);
+        return got.rows();
+    };
+    auto wait_for = [&](size_t n) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (rows() < n && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return rows() == n;
+    };
+    const size_t head_rows = static_cast<size_t>(std::count(full.begin(), full.begin() + cut, '\n')) - 1;
+    follower.start();
+    CHECK(wait_for(head_rows));
+    append_file(log, full.substr(cut));
+    CHECK(wait_for(100));
+    follower.stop();
+    std::lock_guard<std::mutex> lk(m);
+    CHECK(numbered(got));
+}
+
+const Test kTests[] = {
+    { "follow_append", follow_append },
+    { "follow_truncate", follow_truncate },
+    { "follow_rotate", follow_rotate },
+    { "follow_thread", follow_thread },
+};
+
+} // namespace
+
+int main(int argc, char **argv) { return csvdt_test::run(argc, argv, kTests); }
@@ -0,0 +1,130 @@
+// Tests for ResultCache (column_detector_cache.cpp): round trip, staleness,
+// corruption of the cache file, and save() failing.
+//
+// Build and run as described in csvdt_test.h.
+
+#include "csvdt_test.h"
+
+namespace {
+
+using namespace csvdt;
+using namespace csvdt_test;
+
+void result_cache_round_trip() {
+    std::vector<std::string> logs;
+    for (unsigned i = 0; i < 3; ++i) {
+        logs.push_back(fresh_path("rc" + std::to_string(i) + ".csv"));
+        benchgen::CsvSpec spec = log_spec(200, i + 1);
+        if (i == 1) {
+            spec.time = benchgen::TimeColumn::DateAndTime;
+            spec.format = "%d/%m/%Y";
+        }
+        if (i == 2) spec.delim = ';';
+        benchgen::write_file(logs.back(), benchgen::make_csv(spec));
+    }
+    const std::string cache_path = fresh_path("rc.cache");
+    fs::remove(cache_path);
+
+    std::vector<DetectionResult> want;
+    {
+        ResultCache cache(cache_path);
+        for (auto &p : logs) {
+            CHECK(!cache.find(p));
+            want.push_back(cache.get_or_detect(p, [&]{ return detect_file(p); }));
+        }
+        CHECK(cache.dirty());
+        CHECK(cache.save());
+        CHECK(!cache.dirty());
+        for (size_t i = 0; i < logs.size(); ++i) CHECK(cache.find(logs[i]) && same_result(*cache.find(logs[i]), want[i]));
+    }
+
+    ResultCache reopened(cache_path);
+    CHECK(!reopened.dirty());
+    for (size_t i = 0; i < logs.size(); ++i) {
+        const auto hit = reopened.find(logs[i]);
+        CHECK(hit && same_result(*hit, want[i]));
+    }
+    CHECK(!reopened.find(fresh_path("rc_missing.csv")));
+
+    // A changed file misses; saving again keeps the other entries.
+    append_file(logs[0], "2023-11-14 22:13:20,1,2,x,3\n");
+    CHECK(!reopened.find(logs[0]));
+    reopened.put(logs[0], detect_file(logs[0]));
+    CHECK(reopened.save());
+    ResultCache again(cache_path);
+    CHECK(again.find(logs[0]));
+    for (size_t i = 1; i < logs.size(); ++i) CHECK(again.find(logs[i]) && same_result(*again.find(logs[i]), want[i]));
+}
+
+void result_cache_corrupt() {
+    const std::string log = fresh_path("rcc.csv");
+    benchgen::write_file(log, benchgen::make_csv(log_spec(100, 7)));
+    const DetectionResult want = detect_file(log);
+    const std::string cache_path = fresh_path("rcc.cache");
+    fs::remove(cache_path);
+    {
+        ResultCache cache(cache_path);
+        cache.put(log, want);
+        CHECK(cache.save());
+    }
+    const std::string good = read_file(cache_path);
+
+    size_t hits = 0;
+    each_corruption(cache_path, good, [&](const std::string &bytes) {
+        ResultCache cache(cache_path);
+        const auto hit = cache.find(log);
+        if (bytes.size() < good.size()) CHECK(!hit);
+        if (!hit) return;
+        ++hits;
+        // Whatever is returned is usable: the picks are among all_columns.
+        for (auto *col : { &hit->datetime_col, &hit->date_col, &hit->time_col }) {
+            if (!*col) continue;
+            bool listed = false;
+            for (auto &c : hit->all_columns) listed |= same_column(c, **col);
+            CHECK(listed);
+        }
+    });
+    CHECK(hits > 0); // flips in payload bytes (confidences, headers) still read
+
+    // A bad magic or version is an empty cache that save() replaces.
+    std::string bad = good;
+    bad[0] = 'X';
+    benchgen::write_file(cache_path, bad);
+    {
+        ResultCache cache(cache_path);
+        CHECK(!cache.find(log));
+        cache.put(log, want);
+        CHECK(cache.save());
+    }
+    bad = good;
+    bad[4] = static_cast<char>(bad[4] + 1);
+    benchgen::write_file(cache_path, bad);
+    CHECK(!ResultCache(cache_path).find(log));
+
+    benchgen::write_file(cache_path, good);
+    const auto hit = ResultCache(cache_path).find(log);
+    CHECK(hit && same_result(*hit, want));
+}
+
+void result_cache_save_fails() {
+    const std::string log = fresh_path("rcf.csv");
+    benchgen::write_file(log, benchgen::make_csv(log_spec(100, 8)));
+    const DetectionResult want = detect_file(log);
+
+    // No such directory: nothing is written and the entry stays unsaved.
+    ResultCache cache((scratch_dir() / "missing" / "rc.cache").string());
+    cache.put(log, want);
+    CHECK(!cache.save());
+    CHECK(cache.dirty());
+    CHECK(cache.find(log) && same_result(*cache.find(log), want));
+}
+
+const Test kTests[] = {
+    { "result_cache_round_trip", result_cache_round_trip },
+    { "result_cache_corrupt", result_cache_corrupt },
+    { "result_cache_save_fails", result_cache_save_fails },
+};
+
+} // namespace
+
+int main(int argc, char **argv) { return csvdt_test::run(argc, argv, kTests); }
@@ -0,0 +1,261 @@
+// Tests for time alignment (column_detector_align.cpp): TimeAligner's
+// Nearest and Interpolate policies at their tolerance edges, samples that
+// go back in time, MergeSource ordering, and CsvTimeSource seeking through
+// a TimeIndex.
+//
+// Build and run as described in csvdt_test.h.
+
+#include "csvdt_test.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+
+using namespace csvdt;
+using namespace csvdt_test;
+
+// --- sources ----------------------------------------------------------------
+
+struct Point {
+    int64_t ts;
+    double value;
+};
+
+// The points in the order given, numbered from row 0.
+std::unique_ptr<TimeSource> points(std::vector<Point> pts) {
+    auto at = std::make_shared<size_t>(0);
+    return std::make_unique<FunctionSource>([pts, at](TimedSample &out) {
+        if (*at == pts.size()) return false;
+        out.ts = pts[*at].ts;
+        out.row = *at;
+        out.values = { pts[*at].value };
+        ++*at;
+        return true;
+    });
+}
+
+std::unique_ptr<TimeSource> times(const std::vector<int64_t> &ts) {
+    std::vector<Point> pts;
+    for (int64_t t : ts) pts.push_back({ t, 0.0 });
+    return points(std::move(pts));
+}
+
+// The single stream's match for each reference time.
+std::vector<TimeAligner::Match> align(std::vector<Point> secondary, TimeAligner::Policy policy, int64_t tolerance,
+                                      const std::vector<int64_t> &reference) {
+    TimeAligner aligner;
+    aligner.add(points(std::move(secondary)), policy, tolerance);
+    std::vector<TimeAligner::Match> out;
+    auto ref = times(reference);
+    aligner.run(*ref, [&](const TimeAligner::Record &rec) {
+        out.push_back(rec.matches[0]);
+        return true;
+    });
+    return out;
+}
+
+bool is(const TimeAligner::Match &m, int64_t ts, uint64_t row, double value) {
+    return m.found && m.ts == ts && m.row == row && m.values.size() == 1 && std::fabs(m.values[0] - value) < 1e-9;
+}
+
+// --- TimeAligner ------------------------------------------------------------
+
+void aligner_nearest() {
+    const std::vector<Point> sec = { { 100, 1.0 }, { 200, 2.0 } };
+    const auto m = align(sec, TimeAligner::Policy::Nearest, 10, { 89, 90, 100, 110, 111, 189, 190, 210, 211 });
+    CHECK(m.size() == 9);
+    if (m.size() != 9) return;
+    CHECK(!m[0].found);             // 11 before the first sample
+    CHECK(is(m[1], 100, 0, 1.0));   // exactly the tolerance ahead
+    CHECK(is(m[2], 100, 0, 1.0));
+    CHECK(is(m[3], 100, 0, 1.0));   // exactly the tolerance behind
+    CHECK(!m[4].found);
+    CHECK(!m[5].found);
+    CHECK(is(m[6], 200, 1, 2.0));
+    CHECK(is(m[7], 200, 1, 2.0));
+    CHECK(!m[8].found);             // past the last sample
+
+    // Halfway between two samples: the earlier one.
+    const auto tie = align(sec, TimeAligner::Policy::Nearest, 50, { 150, 151 });
+    CHECK(tie.size() == 2 && is(tie[0], 100, 0, 1.0) && is(tie[1], 200, 1, 2.0));
+
+    // Zero tolerance: exact hits only.
+    const auto exact = align(sec, TimeAligner::Policy::Nearest, 0, { 99, 100, 101, 200 });
+    CHECK(exact.size() == 4 && !exact[0].found && is(exact[1], 100, 0, 1.0) && !exact[2].found &&
+          is(exact[3], 200, 1, 2.0));
+}
+
+void aligner_interpolate() {
+    const std::vector<Point> sec = { { 100, 10.0 }, { 200, 20.0 } };
+    const auto wide = align(sec, TimeAligner::Policy::Interpolate, 100, { 90, 100, 125, 150, 200, 210 });
+    CHECK(wide.size() == 6);
+    if (wide.size() == 6) {
+        CHECK(!wide[0].found);              // nothing before
+        CHECK(is(wide[1], 100, 0, 10.0));   // on a sample: that sample
+        CHECK(is(wide[2], 125, 0, 12.5));   // reference time, earlier row
+        CHECK(is(wide[3], 150, 0, 15.0));
+        CHECK(is(wide[4], 200, 1, 20.0));
+        CHECK(!wide[5].found);              // nothing after
+    }
+
+    // Both sides must be within tolerance.
+    const auto narrow = align(sec, TimeAligner::Policy::Interpolate, 50, { 149, 150, 151 });
+    CHECK(narrow.size() == 3);
+    if (narrow.size() == 3) {
+        CHECK(!narrow[0].found);            // 51 to the next sample
+        CHECK(is(narrow[1], 150, 0, 15.0)); // 50 either side
+        CHECK(!narrow[2].found);            // 51 from the previous one
+    }
+}
+
+void aligner_out_of_order() {
+    // The secondary steps back once (200 after 300); the reference once (250).
+    TimeAligner aligner;
+    const size_t s = aligner.add(points({ { 100, 1.0 }, { 300, 3.0 }, { 200, 2.0 }, { 400, 4.0 } }),
+                                 TimeAligner::Policy::Nearest, 0);
+    std::vector<TimeAligner::Record> got;
+    auto ref = times({ 100, 200, 300, 250, 400 });
+    const size_t emitted = aligner.run(*ref, [&](const TimeAligner::Record &rec) {
+        got.push_back(rec);
+        return true;
+    });
+    CHECK(emitted == 4 && got.size() == 4);
+    CHECK(aligner.out_of_order(s) == 1);
+    CHECK(aligner.out_of_order(SIZE_MAX) == 1);
+    if (got.size() != 4) return;
+    CHECK(got[0].reference.ts == 100 && is(got[0].matches[0], 100, 0, 1.0));
+    CHECK(got[1].reference.ts == 200 && !got[1].matches[0].found); // the dropped sample never matches
+    CHECK(got[2].reference.ts == 300 && is(got[2].matches[0], 300, 1, 3.0));
+    CHECK(got[3].reference.ts == 400 && is(got[3].matches[0], 400, 3, 4.0));
+
+    // require_all leaves out references a stream cannot match, and the
+    // callback can stop the run.
+    TimeAligner strict;
+    strict.add(points({ { 100, 1.0 }, { 300, 3.0 } }), TimeAligner::Policy::Nearest, 0);
+    auto ref2 = times({ 100, 200, 300 });
+    std::vector<int64_t> seen;
+    CHECK(strict.run(*ref2, [&](const TimeAligner::Record &rec) { seen.push_back(rec.reference.ts); return true; },
+                     true) == 2);
+    CHECK((seen == std::vector<int64_t>{ 100, 300 }));
+    TimeAligner stopping;
+    stopping.add(points({ { 100, 1.0 } }), TimeAligner::Policy::Nearest, 1000);
+    auto ref3 = times({ 100, 200, 300 });
+    CHECK(stopping.run(*ref3, [](const TimeAligner::Record &) { return false; }) == 1);
+}
+
+// --- MergeSource ------------------------------------------------------------
+
+void merge_order() {
+    // Interleaved parts with shared timestamps and an empty one; the value is
+    // the part number.
+    std::vector<std::vector<Point>> parts = {
+        { { 10, 0 }, { 20, 0 }, { 20, 0 }, { 50, 0 } },
+        {},
+        { { 5, 2 }, { 20, 2 }, { 60, 2 } },
+        { { 20, 3 }, { 30, 3 } },
+    };
+    std::vector<std::unique_ptr<TimeSource>> sources;
+    for (auto &p : parts) sources.push_back(points(p));
+    MergeSource merged(std::move(sources));
+
+    std::vector<std::pair<int64_t, size_t>> got; // (ts, part)
+    std::vector<uint64_t> next_row(parts.size(), 0);
+    TimedSample s;
+    while (merged.next(s)) {
+        const size_t part = merged.last_part();
+        CHECK(part < parts.size() && s.values.size() == 1 && s.values[0] == double(part));
+        if (part < parts.size()) CHECK(s.row == next_row[part]++); // each part in its own order
+        got.emplace_back(s.ts, part);
+    }
+    CHECK(!merged.next(s));
+    const std::vector<std::pair<int64_t, size_t>> want = {
+        { 5, 2 }, { 10, 0 }, { 20, 0 }, { 20, 0 }, { 20, 2 }, { 20, 3 }, { 30, 3 }, { 50, 0 }, { 60, 2 },
+    };
+    CHECK(got == want); // equal times: lower part first
+
+    MergeSource none({});
+    CHECK(!none.next(s));
+}
+
+// --- CsvTimeSource ----------------------------------------------------------
+
+std::vector<TimedSample> drain(CsvTimeSource &src) {
+    std::vector<TimedSample> out;
+    TimedSample s;
+    while (src.next(s)) out.push_back(s);
+    return out;
+}
+
+bool same_sample(const TimedSample &a, const TimedSample &b) {
+    if (a.ts != b.ts || a.row != b.row || a.values.size() != b.values.size()) return false;
+    for (size_t i = 0; i < a.values.size(); ++i)
+        if (!(a.values[i] == b.values[i] || (std::isnan(a.values[i]) && std::isnan(b.values[i])))) return false;
+    return true;
+}
+
+void csv_source_seek() {
+    const std::string log = fresh_path("seek.csv");
+    benchgen::write_file(log, benchgen::make_csv(log_spec(3000, 40)));
+    const DetectionResult det = detect_file(log);
+    const std::vector<size_t> cols = { CsvTimeSource::column(det, "col1"), CsvTimeSource::column(det, "col3") };
+    TimeIndex::Options opt;
+    opt.block_bytes = 4096;
+    const TimeIndex index(log, det, opt);
+    CHECK(index.sorted() && index.blocks().size() > 10);
+
+    CsvTimeSource whole(log, det, cols);
+    const std::vector<TimedSample> all = drain(whole);
+    CHECK(all.size() == 3000);
+    if (all.size() != 3000) return;
+
+    // From anywhere: the same samples from there on, with their file rows,
+    // after at most one block of earlier ones.
+    const int64_t t0 = 1700000000 * kSecond;
+    size_t block_rows = 0;
+    for (auto &b : index.blocks()) block_rows = std::max<size_t>(block_rows, b.rows);
+    for (int64_t k : { 0, 1, 999, 1500, 2999 }) {
+        CsvTimeSource src(log, det, cols);
+        src.seek(index, t0 + k * kSecond);
+        const std::vector<TimedSample> got = drain(src);
+        const size_t want = 3000 - size_t(k);
+        CHECK(got.size() >= want && got.size() < want + block_rows);
+        if (got.size() < want || got.size() > all.size()) continue;
+        for (size_t i = 0; i < got.size(); ++i) CHECK(same_sample(got[i], all[all.size() - got.size() + i]));
+        CHECK(got[got.size() - want].ts == t0 + k * kSecond);
+    }
+
+    // Past the end: nothing. Before the start: everything.
+    CsvTimeSource past(log, det, cols);
+    past.seek(index, t0 + 5000 * kSecond);
+    CHECK(drain(past).empty());
+    CsvTimeSource before(log, det, cols);
+    before.seek(index, INT64_MIN);
+    CHECK(drain(before).size() == 3000);
+
+    // An index over rows out of time order cannot be used to skip.
+    const std::string backwards = fresh_path("seek_back.csv");
+    benchgen::CsvSpec spec = log_spec(3000, 41);
+    spec.start_epoch = 1700000000 + 2999;
+    spec.step_seconds = -1;
+    benchgen::write_file(backwards, benchgen::make_csv(spec));
+    const DetectionResult bdet = detect_file(backwards);
+    const TimeIndex unsorted(backwards, bdet, opt);
+    CHECK(!unsorted.sorted());
+    CsvTimeSource back(backwards, bdet);
+    back.seek(unsorted, t0 + 2000 * kSecond);
+    CHECK(drain(back).size() == 3000);
+}
+
+const Test kTests[] = {
+    { "aligner_nearest", aligner_nearest },
+    { "aligner_interpolate", aligner_interpolate },
+    { "aligner_out_of_order", aligner_out_of_order },
+    { "merge_order", merge_order },
+    { "csv_source_seek", csv_source_seek },
+};
+
+} // namespace
+
+int main(int argc, char **argv) { return csvdt_test::run(argc, argv, kTests); }
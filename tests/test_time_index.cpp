@@ -0,0 +1,219 @@
+// Tests for TimeIndex (column_detector_index.cpp): queries against a full
+// scan, sidecar reuse and corruption, and refresh() on a growing,
+// rewritten or truncated log.
+//
+// Build and run as described in csvdt_test.h.
+
+#include "csvdt_test.h"
+
+namespace {
+
+using namespace csvdt;
+using namespace csvdt_test;
+
+struct RowHit {
+    uint64_t row;
+    int64_t ts;
+    bool operator==(const RowHit &o) const { return row == o.row && ts == o.ts; }
+};
+
+std::vector<RowHit> query_rows(const TimeIndex &index, int64_t from, int64_t to) {
+    std::vector<RowHit> out;
+    index.query(from, to, [&](uint64_t row, int64_t ts, const std::vector<std::string_view> &) {
+        out.push_back({row, ts});
+        return true;
+    });
+    return out;
+}
+
+// The same query answered by converting every row.
+std::vector<RowHit> scan_rows(const std::string &path, const DetectionResult &det, int64_t from, int64_t to) {
+    const std::vector<int64_t> ts = TimestampExtractor(det).extract(path);
+    std::vector<RowHit> out;
+    for (size_t r = 0; r < ts.size(); ++r)
+        if (ts[r] != TimestampExtractor::kInvalid && ts[r] >= from && ts[r] < to) out.push_back({r, ts[r]});
+    return out;
+}
+
+// Windows over logs made by log_spec(): all, none, inside, across blocks.
+std::vector<std::pair<int64_t, int64_t>> windows(size_t rows) {
+    const int64_t t0 = 1700000000 * kSecond, n = static_cast<int64_t>(rows);
+    return { { INT64_MIN + 1, INT64_MAX }, { 0, t0 }, { t0 + n * kSecond, INT64_MAX }, { t0, t0 + kSecond },
+             { t0 + n / 3 * kSecond, t0 + n / 2 * kSecond }, { t0 + (n - 5) * kSecond, t0 + (n + 5) * kSecond },
+             { t0 - 10 * kSecond, t0 + 7 * kSecond }, { t0 + 5 * kSecond, t0 + 5 * kSecond } };
+}
+
+bool answers_match(const TimeIndex &index, const std::string &path, const DetectionResult &det, size_t rows) {
+    for (auto &w : windows(rows))
+        if (query_rows(index, w.first, w.second) != scan_rows(path, det, w.first, w.second)) return false;
+    return true;
+}
+
+// The block table is consistent with itself and the log.
+bool well_formed(const TimeIndex &index, const std::string &path) {
+    uint64_t at = 0, row = 0;
+    for (auto &b : index.blocks()) {
+        if (b.offset < at || b.offset >= index.indexed_bytes() || b.first_row != row || b.valid > b.rows) return false;
+        at = b.offset + 1;
+        row += b.rows;
+    }
+    return row == index.rows() && index.indexed_bytes() <= fs::file_size(path);
+}
+
+bool same_blocks(const std::vector<TimeIndex::Block> &a, const std::vector<TimeIndex::Block> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].offset != b[i].offset || a[i].first_row != b[i].first_row || a[i].rows != b[i].rows ||
+            a[i].valid != b[i].valid || a[i].min_ts != b[i].min_ts || a[i].max_ts != b[i].max_ts)
+            return false;
+    }
+    return true;
+}
+
+TimeIndex::Options small_blocks() {
+    TimeIndex::Options opt;
+    opt.block_bytes = 4096;
+    opt.threads = 4;
+    return opt;
+}
+
+void time_index_round_trip() {
+    const std::string log = fresh_path("ti.csv");
+    benchgen::write_file(log, benchgen::make_csv(log_spec(3000, 3)));
+    const DetectionResult det = detect_file(log);
+
+    TimeIndex built(log, det, small_blocks());
+    CHECK(built.rows() == 3000);
+    CHECK(built.sorted());
+    CHECK(built.blocks().size() > 10);
+    CHECK(well_formed(built, log));
+    CHECK(answers_match(built, log, det, 3000));
+    CHECK(fs::exists(TimeIndex::sidecar_path(log)));
+
+    // A current sidecar is used as is, not rewritten.
+    const auto written = fs::last_write_time(TimeIndex::sidecar_path(log));
+    TimeIndex loaded(log, det, small_blocks());
+    CHECK(fs::last_write_time(TimeIndex::sidecar_path(log)) == written);
+    CHECK(same_blocks(loaded.blocks(), built.blocks()));
+    CHECK(loaded.indexed_bytes() == built.indexed_bytes());
+    CHECK(!loaded.refresh());
+    CHECK(answers_match(loaded, log, det, 3000));
+
+    // byte_ranges() covers every matching row.
+    const int64_t t0 = 1700000000 * kSecond;
+    const auto ranges = built.byte_ranges(t0 + 1000 * kSecond, t0 + 1100 * kSecond);
+    CHECK(!ranges.empty());
+    for (size_t i = 1; i < ranges.size(); ++i) CHECK(ranges[i - 1].second < ranges[i].first);
+
+    // Another block size or timestamp mapping does not take the sidecar.
+    TimeIndex::Options other = small_blocks();
+    other.block_bytes = 8192;
+    TimeIndex rebuilt(log, det, other);
+    CHECK(fs::last_write_time(TimeIndex::sidecar_path(log)) != written || rebuilt.blocks().size() < built.blocks().size());
+    CHECK(answers_match(rebuilt, log, det, 3000));
+
+    // Rows out of time order: no binary search, same answers.
+    const std::string backwards = fresh_path("ti_back.csv");
+    benchgen::CsvSpec spec = log_spec(3000, 4);
+    spec.start_epoch = 1700000000 + 2999;
+    spec.step_seconds = -1;
+    benchgen::write_file(backwards, benchgen::make_csv(spec));
+    const DetectionResult bdet = detect_file(backwards);
+    TimeIndex unsorted(backwards, bdet, small_blocks());
+    CHECK(!unsorted.sorted());
+    CHECK(answers_match(unsorted, backwards, bdet, 3000));
+}
+
+void time_index_corrupt() {
+    const std::string log = fresh_path("tic.csv");
+    benchgen::write_file(log, benchgen::make_csv(log_spec(600, 5)));
+    const DetectionResult det = detect_file(log);
+    TimeIndex::Options opt = small_blocks();
+    opt.threads = 1;
+    const TimeIndex built(log, det, opt);
+    const std::string sidecar = TimeIndex::sidecar_path(log);
+    const std::string good = read_file(sidecar);
+
+    each_corruption(sidecar, good, [&](const std::string &bytes) {
+        const TimeIndex index(log, det, opt);
+        CHECK(well_formed(index, log));
+        // Structure damage rebuilds; flipped timestamps cannot be told apart
+        // from real ones, but queries on them stay within the log.
+        if (bytes.size() < good.size()) CHECK(same_blocks(index.blocks(), built.blocks()));
+        for (auto &w : windows(600)) query_rows(index, w.first, w.second);
+    });
+
+    std::string bad = good;
+    bad[0] = 'X';
+    benchgen::write_file(sidecar, bad);
+    const TimeIndex rebuilt(log, det, opt);
+    CHECK(same_blocks(rebuilt.blocks(), built.blocks()));
+    CHECK(read_file(sidecar) == good);
+}
+
+void time_index_append() {
+    const std::string log = fresh_path("tia.csv");
+    benchgen::CsvSpec spec = log_spec(2000, 6);
+    const std::string full = benchgen::make_csv(spec);
+    const size_t cut = full.find('\n', full.size() * 2 / 3) + 1;
+    benchgen::write_file(log, full.substr(0, cut));
+    const DetectionResult det = detect_file(log);
+
+    TimeIndex index(log, det, small_blocks());
+    const std::vector<TimeIndex::Block> before = index.blocks();
+    const uint64_t rows_before = index.rows();
+
+    // Appended rows are indexed; full blocks before them are kept.
+    const std::string rest = full.substr(cut);
+    const size_t half = rest.size() / 2; // usually mid-record
+    append_file(log, rest.substr(0, half));
+    CHECK(index.refresh());
+    CHECK(well_formed(index, log));
+    CHECK(index.rows() > rows_before);
+    CHECK(index.indexed_bytes() <= cut + half);
+    CHECK(index.indexed_bytes() == cut + half || rest[half - 1] != '\n');
+    for (size_t i = 0; i + 1 < before.size(); ++i) CHECK(index.blocks()[i].offset == before[i].offset);
+
+    append_file(log, rest.substr(half));
+    CHECK(index.refresh());
+    CHECK(index.rows() == 2000);
+    CHECK(index.indexed_bytes() == full.size());
+    CHECK(answers_match(index, log, det, 2000));
+    CHECK(!index.refresh());
+
+    // A new index picks the grown file up from the saved sidecar.
+    append_file(log, data_lines([&]{ auto s = log_spec(100, 8); s.start_epoch += 2000; return s; }()));
+    TimeIndex reopened(log, det, small_blocks());
+    CHECK(reopened.rows() == 2100);
+    CHECK(well_formed(reopened, log));
+    CHECK(answers_match(reopened, log, det, 2100));
+
+    // The bytes before the indexed end changed: rebuild. (Edits further
+    // back are not noticed on growth; logs are only ever appended to.)
+    std::string rewritten = read_file(log);
+    const size_t last_row = rewritten.rfind('\n', rewritten.size() - 2) + 1;
+    rewritten.replace(last_row, 4, "2030");
+    rewritten += data_lines([&]{ auto s = log_spec(10, 9); s.start_epoch += 2100; return s; }());
+    benchgen::write_file(log, rewritten);
+    CHECK(index.refresh());
+    CHECK(index.rows() == 2110);
+    CHECK(well_formed(index, log));
+    CHECK(!index.sorted());
+    CHECK(answers_match(index, log, det, 2110));
+
+    // Truncated: rebuild as well.
+    benchgen::write_file(log, full.substr(0, cut));
+    CHECK(index.refresh());
+    CHECK(index.rows() == rows_before);
+    CHECK(answers_match(index, log, det, 2000));
+}
+
+const Test kTests[] = {
+    { "time_index_round_trip", time_index_round_trip },
+    { "time_index_corrupt", time_index_corrupt },
+    { "time_index_append", time_index_append },
+};
+
+} // namespace
+
+int main(int argc, char **argv) { return csvdt_test::run(argc, argv, kTests); }